@@ -0,0 +1,265 @@
+#include "analytics.h"
+#include "calendar.h"
+#include <algorithm>
+
+namespace {
+    const char* const ageBandNames[] = { "0-1", "2-4", "5-9", "10+" };
+
+    std::string breedKey(const std::string& breed, int band) {
+        return breed + '\n' + static_cast<char>('0' + band);
+    }
+
+    template<typename Map, typename Value>
+    void adjust(Map& map, const std::string& key, Value delta) {
+        auto it = map.emplace(key, 0).first;
+        it->second += delta;
+        if (it->second == 0) {
+            map.erase(it);
+        }
+    }
+
+    void adjustCounts(std::unordered_map<std::string, Analytics::AppointmentCounts>& map,
+        const std::string& key, const std::string& status, long delta) {
+        Analytics::AppointmentCounts& counts = map[key];
+        if (status == "Scheduled") counts.scheduled += delta;
+        else if (status == "Completed") counts.completed += delta;
+        else if (status == "Cancelled") counts.cancelled += delta;
+        if (counts.scheduled == 0 && counts.completed == 0 && counts.cancelled == 0) {
+            map.erase(key);
+        }
+    }
+
+    std::string describe(const Analytics::AppointmentCounts& counts) {
+        return std::to_string(counts.scheduled) + " scheduled, " + std::to_string(counts.completed) +
+            " completed, " + std::to_string(counts.cancelled) + " cancelled";
+    }
+
+    bool operator!=(const Analytics::AppointmentCounts& a, const Analytics::AppointmentCounts& b) {
+        return a.scheduled != b.scheduled || a.completed != b.completed || a.cancelled != b.cancelled;
+    }
+
+    // Reports keys whose values differ, treating a missing key as zero.
+    template<typename Map, typename Describe>
+    void compareMaps(const std::string& what, const Map& actual, const Map& expected,
+        Describe describeValue, std::vector<std::string>& out) {
+        typename Map::mapped_type zero{};
+        for (const auto& entry : actual) {
+            auto other = expected.find(entry.first);
+            const auto& want = other == expected.end() ? zero : other->second;
+            if (entry.second != want) {
+                out.push_back(what + " " + entry.first + ": counted " + describeValue(entry.second) +
+                    ", actual " + describeValue(want));
+            }
+        }
+        for (const auto& entry : expected) {
+            if (actual.find(entry.first) == actual.end()) {
+                out.push_back(what + " " + entry.first + ": counted " + describeValue(zero) +
+                    ", actual " + describeValue(entry.second));
+            }
+        }
+    }
+}
+
+int Analytics::ageBand(int age) {
+    if (age < 2) return 0;
+    if (age < 5) return 1;
+    if (age < 10) return 2;
+    return 3;
+}
+
+const char* Analytics::ageBandName(int band) {
+    return ageBandNames[band];
+}
+
+std::string Analytics::weekOf(const std::string& date) {
+    long days;
+    if (!calendar::parseDate(date, days)) {
+        return "";
+    }
+    return calendar::civilFromDays(days - calendar::weekday(days));
+}
+
+void Analytics::appointmentAdded(const std::string& date, const std::string& status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustAppointment(date, status, 1);
+}
+
+void Analytics::appointmentRemoved(const std::string& date, const std::string& status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustAppointment(date, status, -1);
+}
+
+void Analytics::statusChanged(const std::string& date, const std::string& from, const std::string& to) {
+    if (from == to) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustAppointment(date, from, -1);
+    adjustAppointment(date, to, 1);
+}
+
+void Analytics::petAdded(const Pet& pet) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustPet(pet, 1, pet.vaccinated ? 1 : 0);
+}
+
+void Analytics::petRemoved(const Pet& pet) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustPet(pet, -1, pet.vaccinated ? -1 : 0);
+}
+
+void Analytics::vaccinationChanged(const Pet& pet, bool vaccinated) {
+    if (pet.vaccinated == vaccinated) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustPet(pet, 0, vaccinated ? 1 : -1);
+}
+
+void Analytics::ownerAdded(const Owner& owner) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustOwner(owner, 1);
+}
+
+void Analytics::ownerRemoved(const Owner& owner) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustOwner(owner, -1);
+}
+
+void Analytics::rebuild(const std::vector<Owner>& owners, const std::vector<Appointment>& appointments) {
+    std::lock_guard<std::mutex> lock(mutex);
+    byDay.clear();
+    byWeek.clear();
+    allAppointments = AppointmentCounts();
+    byBreed.clear();
+    customersByDay.clear();
+    customersByWeek.clear();
+    customerTotal = 0;
+    customersUndated = 0;
+
+    for (const auto& owner : owners) {
+        adjustOwner(owner, 1);
+        for (const auto& pet : owner.pets) {
+            adjustPet(pet, 1, pet.vaccinated ? 1 : 0);
+        }
+    }
+    for (const auto& appt : appointments) {
+        adjustAppointment(appt.date, appt.status, 1);
+    }
+}
+
+void Analytics::addArchived(const std::string& date, const std::string& status, long count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adjustAppointment(date, status, count);
+}
+
+Analytics::AppointmentCounts Analytics::day(const std::string& date) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byDay.find(date);
+    return it == byDay.end() ? AppointmentCounts() : it->second;
+}
+
+Analytics::AppointmentCounts Analytics::week(const std::string& date) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byWeek.find(weekOf(date));
+    return it == byWeek.end() ? AppointmentCounts() : it->second;
+}
+
+Analytics::AppointmentCounts Analytics::totals() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return allAppointments;
+}
+
+std::vector<Analytics::Coverage> Analytics::coverage() const {
+    std::vector<Coverage> rows;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : byBreed) {
+            rows.push_back(entry.second);
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [](const Coverage& a, const Coverage& b) {
+        return a.breed != b.breed ? a.breed < b.breed : a.ageBand < b.ageBand;
+    });
+    return rows;
+}
+
+Analytics::Customers Analytics::customers(const std::string& date) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Customers result;
+    auto day = customersByDay.find(date);
+    result.onDay = day == customersByDay.end() ? 0 : day->second;
+    auto week = customersByWeek.find(weekOf(date));
+    result.inWeek = week == customersByWeek.end() ? 0 : week->second;
+    result.total = customerTotal;
+    result.undated = customersUndated;
+    return result;
+}
+
+std::vector<std::string> Analytics::compare(const Analytics& expected) const {
+    std::unique_lock<std::mutex> mine(mutex, std::defer_lock), theirs(expected.mutex, std::defer_lock);
+    std::lock(mine, theirs);
+
+    std::vector<std::string> differences;
+    compareMaps("Day", byDay, expected.byDay, describe, differences);
+    compareMaps("Week of", byWeek, expected.byWeek, describe, differences);
+    if (allAppointments != expected.allAppointments) {
+        differences.push_back("All appointments: counted " + describe(allAppointments) +
+            ", actual " + describe(expected.allAppointments));
+    }
+
+    std::unordered_map<std::string, std::pair<long, long>> coverage, expectedCoverage;
+    for (const auto& entry : byBreed) {
+        coverage[entry.second.breed + " aged " + ageBandName(entry.second.ageBand)] =
+            std::make_pair(entry.second.pets, entry.second.vaccinated);
+    }
+    for (const auto& entry : expected.byBreed) {
+        expectedCoverage[entry.second.breed + " aged " + ageBandName(entry.second.ageBand)] =
+            std::make_pair(entry.second.pets, entry.second.vaccinated);
+    }
+    compareMaps("Breed", coverage, expectedCoverage, [](const std::pair<long, long>& value) {
+        return std::to_string(value.second) + " of " + std::to_string(value.first) + " vaccinated";
+    }, differences);
+
+    auto count = [](long value) { return std::to_string(value); };
+    compareMaps("Customers registered on", customersByDay, expected.customersByDay, count, differences);
+    compareMaps("Customers registered in week of", customersByWeek, expected.customersByWeek, count, differences);
+    if (customerTotal != expected.customerTotal || customersUndated != expected.customersUndated) {
+        differences.push_back("Customers: counted " + count(customerTotal) + " (" + count(customersUndated) +
+            " undated), actual " + count(expected.customerTotal) + " (" + count(expected.customersUndated) + " undated)");
+    }
+    return differences;
+}
+
+void Analytics::adjustAppointment(const std::string& date, const std::string& status, long delta) {
+    adjustCounts(byDay, date, status, delta);
+    std::string week = weekOf(date);
+    if (!week.empty()) {
+        adjustCounts(byWeek, week, status, delta);
+    }
+    if (status == "Scheduled") allAppointments.scheduled += delta;
+    else if (status == "Completed") allAppointments.completed += delta;
+    else if (status == "Cancelled") allAppointments.cancelled += delta;
+}
+
+void Analytics::adjustPet(const Pet& pet, long pets, long vaccinatedDelta) {
+    int band = ageBand(pet.age);
+    std::string key = breedKey(pet.breed, band);
+    Coverage& entry = byBreed[key];
+    entry.breed = pet.breed;
+    entry.ageBand = band;
+    entry.pets += pets;
+    entry.vaccinated += vaccinatedDelta;
+    if (entry.pets == 0 && entry.vaccinated == 0) {
+        byBreed.erase(key);
+    }
+}
+
+void Analytics::adjustOwner(const Owner& owner, long delta) {
+    customerTotal += delta;
+    if (owner.registered.empty()) {
+        customersUndated += delta;
+        return;
+    }
+    adjust(customersByDay, owner.registered, delta);
+    std::string week = weekOf(owner.registered);
+    if (!week.empty()) {
+        adjust(customersByWeek, week, delta);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "owner.h"
+#include "pet.h"
+#include "appointment.h"
+
+// Aggregate counters behind the Reports menu. VMS updates them from every
+// operation that changes what they count, in constant time, so a report
+// never scans owners or appointments. Archived appointments stay counted
+// (VMS adds them from the archive's per-day counts after a rebuild), and
+// a report taken while a transaction commits may include its changes
+// before they are journaled.
+class Analytics {
+public:
+    struct AppointmentCounts {
+        long scheduled = 0, completed = 0, cancelled = 0;
+        long total() const { return scheduled + completed + cancelled; }
+    };
+    struct Coverage {
+        std::string breed;
+        int ageBand = 0;
+        long pets = 0, vaccinated = 0;
+    };
+    struct Customers {
+        long onDay = 0, inWeek = 0, total = 0, undated = 0;
+    };
+
+    // Pet ages are grouped as "0-1", "2-4", "5-9" and "10+".
+    static const int AgeBandCount = 4;
+    static int ageBand(int age);
+    static const char* ageBandName(int band);
+    // Monday of the week containing date (YYYY-MM-DD), or "" if it is not
+    // a valid date.
+    static std::string weekOf(const std::string& date);
+
+    void appointmentAdded(const std::string& date, const std::string& status);
+    void appointmentRemoved(const std::string& date, const std::string& status);
+    void statusChanged(const std::string& date, const std::string& from, const std::string& to);
+    void petAdded(const Pet& pet);
+    void petRemoved(const Pet& pet);
+    // pet as it was before vaccinated was set.
+    void vaccinationChanged(const Pet& pet, bool vaccinated);
+    // Counts the customer only; its pets are added separately.
+    void ownerAdded(const Owner& owner);
+    void ownerRemoved(const Owner& owner);
+
+    // Recounts everything from scratch; O(total records).
+    void rebuild(const std::vector<Owner>& owners, const std::vector<Appointment>& appointments);
+    // Counts appointments moved to the archive, which rebuild does not see.
+    void addArchived(const std::string& date, const std::string& status, long count);
+
+    AppointmentCounts day(const std::string& date) const;
+    AppointmentCounts week(const std::string& date) const;
+    AppointmentCounts totals() const;
+    // One entry per breed and age band with any pets, by breed then band.
+    std::vector<Coverage> coverage() const;
+    Customers customers(const std::string& date) const;
+
+    // Describes every counter that differs from expected; empty if all agree.
+    std::vector<std::string> compare(const Analytics& expected) const;
+
+private:
+    void adjustAppointment(const std::string& date, const std::string& status, long delta);
+    void adjustPet(const Pet& pet, long pets, long vaccinatedDelta);
+    void adjustOwner(const Owner& owner, long delta);
+
+    mutable std::mutex mutex;
+    // Entries are erased when they drop back to zero.
+    std::unordered_map<std::string, AppointmentCounts> byDay, byWeek;
+    AppointmentCounts allAppointments;
+    // Keyed by breed + '\n' + age band.
+    std::unordered_map<std::string, Coverage> byBreed;
+    std::unordered_map<std::string, long> customersByDay, customersByWeek;
+    long customerTotal = 0, customersUndated = 0;
+};
\ No newline at end of file
@@ -1,18 +1,21 @@
-#pragma once
-#include <string>
-#include <vector>
-#include "pet.h"
-#include "owner.h"
-
-class Appointment {
-public:
-    std::string date, time, status;
-    Pet pet;
-    Owner owner;
-
-    Appointment(std::string d, std::string t, Pet p, Owner o, std::string s);
-    std::string toCSV() const;
-    static Appointment fromCSV(const std::string& line, const std::vector<Owner>& allOwners);
-    bool isInPast() const;
-    void updateStatus();
+#pragma once
+#include <string>
+#include <vector>
+
+namespace csv_utils { class CsvWriter; struct CsvField; }
+
+class Appointment {
+public:
+    std::string date, time, status;
+    // The pet and its owner are looked up by name (VMS::findOwner and
+    // VMS::findPet) rather than copied into every appointment.
+    std::string petName, ownerName;
+    // Tombstone, as for Owner::deleted.
+    bool deleted = false;
+
+    Appointment(std::string d, std::string t, std::string p, std::string o, std::string s);
+    void writeCSV(csv_utils::CsvWriter& out) const;
+    static Appointment fromCSV(const std::vector<csv_utils::CsvField>& fields);
+    bool isInPast() const;
+    void updateStatus();
 };
\ No newline at end of file
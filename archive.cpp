@@ -0,0 +1,301 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "archive.h"
+#include "file_utils.h"
+#include "trace.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <utility>
+
+namespace {
+    const char* const SegmentMagic = "VMS-ARCHIVE";
+    const int SegmentVersion = 1;
+
+    std::string keyOf(const std::string& ownerName, const std::string& petName) {
+        return ownerName + '\n' + petName;
+    }
+
+    bool earlier(const ArchivedAppointment& a, const ArchivedAppointment& b) {
+        return a.date != b.date ? a.date < b.date : a.time < b.time;
+    }
+
+    // Rows are front coded as "<shared>,<rest>\n" over "date time status".
+    void decodeGroup(const std::string& data, const std::string& ownerName, const std::string& petName,
+        std::vector<ArchivedAppointment>& out) {
+        std::string previous;
+        size_t pos = 0;
+        while (pos < data.size()) {
+            size_t comma = data.find(',', pos);
+            size_t end = data.find('\n', pos);
+            if (comma == std::string::npos || end == std::string::npos || comma > end) break;
+            size_t shared = std::stoul(data.substr(pos, comma - pos));
+            std::string row = previous.substr(0, shared) + data.substr(comma + 1, end - comma - 1);
+            pos = end + 1;
+
+            size_t first = row.find(' ');
+            size_t second = first == std::string::npos ? first : row.find(' ', first + 1);
+            if (second == std::string::npos) break;
+            out.push_back(ArchivedAppointment{ ownerName, petName, row.substr(0, first),
+                row.substr(first + 1, second - first - 1), row.substr(second + 1) });
+            previous.swap(row);
+        }
+    }
+
+    bool readHeader(std::istream& in, uint64_t& journalSequence, size_t& groups, size_t& days) {
+        std::string magic;
+        int version = 0;
+        return in >> magic >> version >> journalSequence >> groups >> days && magic == SegmentMagic &&
+            version == SegmentVersion && in.get() == '\n';
+    }
+}
+
+std::string AppointmentArchive::segmentName(int segment) {
+    return "archive." + std::to_string(segment) + ".dat";
+}
+
+void AppointmentArchive::open() {
+    trace::Span span("archive open");
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    counts.clear();
+    archived = 0;
+    segments = 0;
+    while (loadIndex(segments + 1)) {
+        segments++;
+    }
+}
+
+bool AppointmentArchive::loadIndex(int segment) {
+    std::string name = segmentName(segment);
+    std::ifstream in(name, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    uint64_t journalSequence = 0;
+    size_t groupCount = 0, dayCount = 0;
+    if (!readHeader(in, journalSequence, groupCount, dayCount)) {
+        std::cerr << "Warning: " << name << " is not an archive segment; its appointments are not shown." << std::endl;
+        return true;
+    }
+
+    std::vector<std::pair<std::string, Group>> groups;
+    for (size_t i = 0; i < groupCount; i++) {
+        Group group;
+        group.segment = segment;
+        size_t ownerLength = 0, petLength = 0;
+        in >> group.count >> group.offset >> group.length >> group.minDate >> group.maxDate
+            >> ownerLength >> petLength;
+        in.get();
+        std::string names(ownerLength + petLength, '\0');
+        in.read(&names[0], names.size());
+        if (!in || in.get() != '\n') {
+            std::cerr << "Warning: " << name << " has a damaged index; its appointments are not shown." << std::endl;
+            return true;
+        }
+        groups.emplace_back(keyOf(names.substr(0, ownerLength), names.substr(ownerLength)), group);
+    }
+
+    std::vector<std::pair<std::pair<std::string, std::string>, long>> days;
+    for (size_t i = 0; i < dayCount; i++) {
+        std::string date, status;
+        long rows = 0;
+        in >> date >> status >> rows;
+        if (!in || in.get() != '\n') {
+            std::cerr << "Warning: " << name << " has a damaged index; its appointments are not shown." << std::endl;
+            return true;
+        }
+        days.emplace_back(std::make_pair(date, status), rows);
+    }
+
+    long dataStart = static_cast<long>(in.tellg());
+    for (auto& entry : groups) {
+        entry.second.offset += dataStart;
+        archived += entry.second.count;
+        index[entry.first].push_back(entry.second);
+    }
+    for (const auto& entry : days) {
+        counts[entry.first] += entry.second;
+    }
+    return true;
+}
+
+void AppointmentArchive::count(const ArchivedAppointment& row, long delta) {
+    auto it = counts.emplace(std::make_pair(row.date, row.status), 0).first;
+    it->second += delta;
+    if (it->second == 0) {
+        counts.erase(it);
+    }
+}
+
+void AppointmentArchive::add(std::vector<ArchivedAppointment> rows, uint64_t version) {
+    std::lock_guard<std::mutex> lock(mutex);
+    archived += rows.size();
+    for (auto& row : rows) {
+        count(row, 1);
+        pending.push_back(Pending{ version, std::move(row) });
+    }
+}
+
+bool AppointmentArchive::prepareSegment(uint64_t version, uint64_t journalSequence,
+    std::string& name, std::string& contents) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!writing.empty()) return false;
+
+    // Rows removed after the snapshot being checkpointed are still in its
+    // appointments.csv and wait for the next segment.
+    auto later = std::stable_partition(pending.begin(), pending.end(),
+        [version](const Pending& entry) { return entry.version <= version; });
+    for (auto it = pending.begin(); it != later; ++it) {
+        writing.push_back(std::move(it->row));
+    }
+    pending.erase(pending.begin(), later);
+    if (writing.empty()) return false;
+
+    std::vector<const ArchivedAppointment*> rows;
+    for (const auto& row : writing) {
+        rows.push_back(&row);
+    }
+    std::sort(rows.begin(), rows.end(), [](const ArchivedAppointment* a, const ArchivedAppointment* b) {
+        if (a->ownerName != b->ownerName) return a->ownerName < b->ownerName;
+        if (a->petName != b->petName) return a->petName < b->petName;
+        return earlier(*a, *b);
+    });
+
+    std::string header, data;
+    size_t groupCount = 0;
+
+    for (size_t first = 0; first < rows.size();) {
+        size_t last = first;
+        std::string previous;
+        size_t offset = data.size();
+        while (last < rows.size() && rows[last]->ownerName == rows[first]->ownerName &&
+            rows[last]->petName == rows[first]->petName) {
+            std::string row = rows[last]->date + ' ' + rows[last]->time + ' ' + rows[last]->status;
+            size_t shared = 0;
+            while (shared < previous.size() && shared < row.size() && previous[shared] == row[shared]) {
+                shared++;
+            }
+            data += std::to_string(shared);
+            data += ',';
+            data.append(row, shared, std::string::npos);
+            data += '\n';
+            previous.swap(row);
+            last++;
+        }
+
+        const ArchivedAppointment& head = *rows[first];
+        header += std::to_string(last - first) + ' ' + std::to_string(offset) + ' ' +
+            std::to_string(data.size() - offset) + ' ' + head.date + ' ' + rows[last - 1]->date + ' ' +
+            std::to_string(head.ownerName.size()) + ' ' + std::to_string(head.petName.size()) + ' ' +
+            head.ownerName + head.petName + '\n';
+        groupCount++;
+        first = last;
+    }
+
+    // The per-day counts follow the groups.
+    std::map<std::pair<std::string, std::string>, long> days;
+    for (const auto& row : writing) {
+        days[std::make_pair(row.date, row.status)]++;
+    }
+    for (const auto& entry : days) {
+        header += entry.first.first + ' ' + entry.first.second + ' ' + std::to_string(entry.second) + '\n';
+    }
+
+    name = segmentName(segments + 1);
+    contents = std::string(SegmentMagic) + ' ' + std::to_string(SegmentVersion) + ' ' +
+        std::to_string(journalSequence) + ' ' + std::to_string(groupCount) + ' ' +
+        std::to_string(days.size()) + '\n' + header + data;
+    return true;
+}
+
+void AppointmentArchive::segmentWritten(bool committed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!committed) {
+        for (auto& row : writing) {
+            pending.push_back(Pending{ 0, std::move(row) });
+        }
+        writing.clear();
+        return;
+    }
+
+    // The rows now come from the segment; drop the copies counted in add().
+    archived -= writing.size();
+    for (const auto& row : writing) {
+        count(row, -1);
+    }
+    writing.clear();
+    if (loadIndex(segments + 1)) {
+        segments++;
+    }
+}
+
+void AppointmentArchive::forPet(const std::string& ownerName, const std::string& petName,
+    const std::function<void(const ArchivedAppointment&)>& fn) const {
+    trace::Span span("archive lookup");
+    std::vector<ArchivedAppointment> rows;
+    std::vector<Group> groups;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(keyOf(ownerName, petName));
+        if (found != index.end()) {
+            groups = found->second;
+        }
+        for (const auto& entry : pending) {
+            if (entry.row.ownerName == ownerName && entry.row.petName == petName) {
+                rows.push_back(entry.row);
+            }
+        }
+        for (const auto& row : writing) {
+            if (row.ownerName == ownerName && row.petName == petName) {
+                rows.push_back(row);
+            }
+        }
+    }
+
+    // Segments are immutable, so they are read without the lock.
+    for (const auto& group : groups) {
+        std::ifstream in(segmentName(group.segment), std::ios::binary);
+        std::string data(static_cast<size_t>(group.length), '\0');
+        if (!in.seekg(group.offset) || !in.read(&data[0], data.size())) {
+            std::cerr << "Warning: could not read " << segmentName(group.segment) << std::endl;
+            continue;
+        }
+        decodeGroup(data, ownerName, petName, rows);
+    }
+
+    std::stable_sort(rows.begin(), rows.end(), earlier);
+    for (const auto& row : rows) {
+        fn(row);
+    }
+}
+
+size_t AppointmentArchive::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return archived;
+}
+
+void AppointmentArchive::countByDay(
+    const std::function<void(const std::string& date, const std::string& status, long count)>& fn) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : counts) {
+        fn(entry.first.first, entry.first.second, entry.second);
+    }
+}
+
+void AppointmentArchive::copySegments(const std::string& directory, uint64_t journalSequence) {
+    std::string prefix = directory.empty() ? "" : directory + "/";
+    for (int segment = 1;; segment++) {
+        std::string name = segmentName(segment);
+        std::string contents;
+        if (!file_utils::readFile(prefix + name, contents)) return;
+
+        std::istringstream in(contents);
+        uint64_t written = 0;
+        size_t groups = 0, days = 0;
+        if (!readHeader(in, written, groups, days) || written > journalSequence) return;
+        if (!std::ifstream(name).is_open()) {
+            file_utils::writeDurably(name, contents);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <functional>
+
+// One appointment moved to the archive. Only names are kept: the pet and
+// owner records themselves stay in the hot tier (owners.csv, pets.csv).
+struct ArchivedAppointment {
+    std::string ownerName, petName, date, time, status;
+};
+
+// Cold tier for appointments that are finished and older than the archive
+// horizon (see VMS::setArchiveHorizon). They are kept out of the
+// appointments vector, so loadData, the status sweep, the conflict checks
+// and every checkpoint skip them.
+//
+// Archived rows are written in immutable segments (archive.1.dat,
+// archive.2.dat, ...), one per checkpoint that moved something, and each
+// segment is part of its checkpoint's manifest so it appears on disk
+// exactly when the rows leave appointments.csv. Inside a segment the rows
+// are grouped by pet and sorted by date and time, and each row only stores
+// what differs from the one before it (front coding). A header lists every
+// group with its offset and date range; only these headers are held in
+// memory, rows are read from disk when a pet's history is requested,
+// along with a count of the rows per date and status for the reports.
+class AppointmentArchive {
+public:
+    // Loads the index of every segment on disk.
+    void open();
+
+    // Moves rows into the archive; version is the first snapshot version
+    // without them. They are visible to forPet() at once and written with
+    // the first checkpoint of a snapshot that no longer holds them.
+    void add(std::vector<ArchivedAppointment> rows, uint64_t version);
+
+    // Encodes the rows removed up to the given snapshot version as the
+    // next segment. The caller writes it as part of that snapshot's
+    // checkpoint (journalSequence) and then calls segmentWritten().
+    // Returns false if there is nothing to write.
+    bool prepareSegment(uint64_t version, uint64_t journalSequence, std::string& name, std::string& contents);
+    // Indexes the prepared segment, or on failure returns its rows to the
+    // next one.
+    void segmentWritten(bool committed);
+
+    // Passes the archived appointments of one pet to fn, oldest first.
+    void forPet(const std::string& ownerName, const std::string& petName,
+        const std::function<void(const ArchivedAppointment&)>& fn) const;
+
+    size_t size() const;
+    // Passes the number of archived appointments for each date and status.
+    void countByDay(const std::function<void(const std::string& date, const std::string& status, long count)>& fn) const;
+
+    // Copies another directory's segments written by checkpoints up to
+    // journalSequence (i.e. consistent with a checkpoint copied from it).
+    static void copySegments(const std::string& directory, uint64_t journalSequence);
+
+private:
+    // Where one pet's rows are in one segment.
+    struct Group {
+        int segment;
+        long offset;
+        long length;
+        size_t count;
+        std::string minDate, maxDate;
+    };
+
+    static std::string segmentName(int segment);
+    bool loadIndex(int segment);
+    void count(const ArchivedAppointment& row, long delta);
+
+    // Keyed by owner name + '\n' + pet name.
+    std::map<std::string, std::vector<Group>> index;
+    struct Pending {
+        uint64_t version;
+        ArchivedAppointment row;
+    };
+
+    std::vector<Pending> pending;               // not yet in a segment
+    std::vector<ArchivedAppointment> writing;   // in the prepared segment
+    int segments = 0;
+    size_t archived = 0;
+    // Keyed by date and status; covers the segments, pending and writing.
+    std::map<std::pair<std::string, std::string>, long> counts;
+    mutable std::mutex mutex;
+};
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "batch.h"
+#include "exceptions.h"
+#include "security.h"
+#include <iostream>
+#include <fstream>
+#include <cctype>
+
+namespace batch {
+    namespace {
+        void require(bool condition, const std::string& message) {
+            if (!condition) {
+                throw OperationFailedException(message);
+            }
+        }
+
+        void requireArgs(const std::vector<std::string>& args, size_t min, size_t max, const std::string& usage) {
+            require(args.size() - 1 >= min && args.size() - 1 <= max, "Usage: " + usage);
+        }
+
+        int parseInt(const std::string& text, int min, int max, const std::string& what) {
+            size_t used = 0;
+            int value = 0;
+            try {
+                value = std::stoi(text, &used);
+            }
+            catch (...) {
+                used = 0;
+            }
+            require(used == text.size() && value >= min && value <= max, "Invalid " + what + ": " + text);
+            return value;
+        }
+
+        bool parseYesNo(const std::string& text) {
+            if (text == "yes" || text == "Yes" || text == "1") return true;
+            if (text == "no" || text == "No" || text == "0") return false;
+            throw OperationFailedException("Expected yes/no, got: " + text);
+        }
+
+        void requireName(VMS& vms, const std::string& name) {
+            require(vms.validateName(name), "Invalid name: " + name);
+        }
+
+        void requireSlot(VMS& vms, const std::string& date, const std::string& time) {
+            require(vms.validateDate(date), "Invalid date: " + date);
+            require(vms.validateTime(time), "Invalid time: " + time);
+        }
+
+        // Stages one command in tx. Returns false for commands that only
+        // control the run (commit) rather than change data.
+        bool execute(VMS& vms, Transaction& tx, const std::vector<std::string>& args) {
+            const std::string& cmd = args[0];
+
+            if (cmd == "add-owner") {
+                requireArgs(args, 6, 6, "add-owner <name> <age> <address> <phone> <email> <password>");
+                requireName(vms, args[1]);
+                int age = parseInt(args[2], 18, 120, "owner age");
+                require(vms.validateAddress(args[3]), "Invalid address: " + args[3]);
+                require(vms.validatePhone(args[4]), "Invalid phone: " + args[4]);
+                require(vms.validateEmail(args[5]), "Invalid email: " + args[5]);
+                require(vms.validatePassword(args[6]), "Password must be at least 6 characters.");
+                tx.registerOwner(Owner(args[1], age, args[3], args[4], args[5], security::hashPassword(args[6])));
+            }
+            else if (cmd == "update-owner") {
+                requireArgs(args, 4, 4, "update-owner <name> <address> <phone> <email>");
+                require(vms.validateAddress(args[2]), "Invalid address: " + args[2]);
+                require(vms.validatePhone(args[3]), "Invalid phone: " + args[3]);
+                require(vms.validateEmail(args[4]), "Invalid email: " + args[4]);
+                tx.updateOwnerContact(args[1], args[2], args[3], args[4]);
+            }
+            else if (cmd == "delete-owner") {
+                requireArgs(args, 1, 1, "delete-owner <name>");
+                tx.deleteOwner(args[1]);
+            }
+            else if (cmd == "add-pet") {
+                requireArgs(args, 5, 6, "add-pet <owner> <pet> <breed> <age> <yes|no> [medical history]");
+                requireName(vms, args[2]);
+                requireName(vms, args[3]);
+                int age = parseInt(args[4], 1, 29, "pet age");
+                bool vaccinated = parseYesNo(args[5]);
+                tx.addPet(args[1], Pet(args[2], args[3], age, args.size() > 6 ? args[6] : "", vaccinated));
+            }
+            else if (cmd == "update-pet") {
+                requireArgs(args, 4, 4, "update-pet <owner> <pet> <yes|no> <medical history>");
+                tx.updatePet(args[1], args[2], args[4], parseYesNo(args[3]));
+            }
+            else if (cmd == "delete-pet") {
+                requireArgs(args, 2, 2, "delete-pet <owner> <pet>");
+                tx.deletePet(args[1], args[2]);
+            }
+            else if (cmd == "add-note") {
+                requireArgs(args, 3, 3, "add-note <owner> <pet> <note>");
+                tx.addMedicalNote(args[1], args[2], args[3]);
+            }
+            else if (cmd == "set-history") {
+                requireArgs(args, 3, 3, "set-history <owner> <pet> <medical history>");
+                tx.replaceMedicalHistory(args[1], args[2], args[3]);
+            }
+            else if (cmd == "schedule") {
+                requireArgs(args, 4, 4, "schedule <owner> <pet> <YYYY-MM-DD> <HH:MM>");
+                requireSlot(vms, args[3], args[4]);
+                tx.scheduleAppointment(args[1], args[2], args[3], args[4]);
+            }
+            else if (cmd == "set-status") {
+                requireArgs(args, 5, 5, "set-status <owner> <pet> <YYYY-MM-DD> <HH:MM> <Scheduled|Completed|Cancelled>");
+                requireSlot(vms, args[3], args[4]);
+                tx.updateAppointmentStatus(args[1], args[2], args[3], args[4], args[5]);
+            }
+            else if (cmd == "cancel") {
+                requireArgs(args, 4, 4, "cancel <owner> <pet> <YYYY-MM-DD> <HH:MM>");
+                requireSlot(vms, args[3], args[4]);
+                tx.cancelAppointment(args[1], args[2], args[3], args[4]);
+            }
+            else if (cmd == "commit") {
+                requireArgs(args, 0, 0, "commit");
+                return false;
+            }
+            else {
+                throw OperationFailedException("Unknown command: " + cmd);
+            }
+            return true;
+        }
+    }
+
+    std::vector<std::string> tokenize(const std::string& line) {
+        std::vector<std::string> fields;
+        size_t i = 0;
+        while (i < line.size()) {
+            if (std::isspace(static_cast<unsigned char>(line[i]))) {
+                ++i;
+                continue;
+            }
+            if (line[i] == '#') {
+                break;
+            }
+
+            std::string field;
+            if (line[i] == '\"') {
+                ++i;
+                while (i < line.size()) {
+                    if (line[i] == '\"') {
+                        if (i + 1 < line.size() && line[i + 1] == '\"') {
+                            field += '\"';
+                            i += 2;
+                            continue;
+                        }
+                        ++i;
+                        break;
+                    }
+                    field += line[i++];
+                }
+            }
+            else {
+                while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+                    field += line[i++];
+                }
+            }
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    int run(VMS& vms, const std::string& scriptPath, int commitEvery) {
+        std::ifstream script(scriptPath);
+        if (!script) {
+            throw FileAccessException(scriptPath);
+        }
+
+        int applied = 0, failed = 0, commits = 0;
+        Transaction tx;
+        std::vector<int> stagedLines;  // script line of each staged mutation
+
+        auto commitStaged = [&]() {
+            if (tx.empty()) return;
+            std::vector<CommitFailure> failures;
+            try {
+                failures = vms.commitValid(tx);
+            }
+            catch (const std::exception& e) {
+                // Nothing from this transaction was applied.
+                failed += static_cast<int>(stagedLines.size());
+                std::cerr << scriptPath << ":" << stagedLines.front() << "-" << stagedLines.back()
+                    << ": commit failed: " << e.what() << "\n";
+                tx.clear();
+                stagedLines.clear();
+                return;
+            }
+            for (const auto& failure : failures) {
+                std::cerr << scriptPath << ":" << stagedLines[failure.index] << ": " << failure.message << "\n";
+            }
+            failed += static_cast<int>(failures.size());
+            applied += static_cast<int>(stagedLines.size() - failures.size());
+            if (failures.size() < stagedLines.size()) {
+                ++commits;
+            }
+            tx.clear();
+            stagedLines.clear();
+        };
+
+        int lineNumber = 0;
+        std::string line;
+        while (std::getline(script, line)) {
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+
+            std::vector<std::string> args = tokenize(line);
+            if (args.empty()) continue;
+
+            try {
+                if (execute(vms, tx, args)) {
+                    stagedLines.push_back(lineNumber);
+                }
+                else {
+                    commitStaged();
+                }
+            }
+            catch (const std::exception& e) {
+                ++failed;
+                std::cerr << scriptPath << ":" << lineNumber << ": " << e.what() << "\n";
+            }
+
+            if (commitEvery > 0 && static_cast<int>(tx.size()) >= commitEvery) {
+                commitStaged();
+            }
+        }
+        commitStaged();
+
+        // One checkpoint for the whole run; until then the journal holds
+        // the committed work.
+        vms.saveData();
+
+        std::cout << "Batch complete: " << applied << " applied, " << failed << " failed, "
+            << commits << " commit(s).\n";
+        memory::printReport(vms.measureMemory(), std::cout);
+        return failed;
+    }
+}
\ No newline at end of file
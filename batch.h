@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "vms.h"
+
+namespace batch {
+    // Splits one script line into fields. Fields are separated by whitespace;
+    // a field containing spaces is wrapped in double quotes ("" inside quotes
+    // is a literal quote). Everything after an unquoted '#' is a comment.
+    std::vector<std::string> tokenize(const std::string& line);
+
+    // Runs every command in scriptPath against vms without prompting.
+    // Commands are staged in a transaction that is committed (one journal
+    // write) after every commitEvery commands (0 = once at the end), at each
+    // "commit" line and at the end of the run; rejected commands are
+    // reported and skipped. The CSV files are rewritten once at the end.
+    // Returns the number of commands that failed.
+    int run(VMS& vms, const std::string& scriptPath, int commitEvery);
+}
\ No newline at end of file
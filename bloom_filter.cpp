@@ -0,0 +1,55 @@
+#include "bloom_filter.h"
+#include <functional>
+
+namespace {
+    // splitmix64 finalizer: spreads every input bit over the whole word.
+    uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+}
+
+BloomFilter::BloomFilter(size_t capacity)
+    : keyCapacity(capacity < 64 ? 64 : capacity) {
+    size_t bits = keyCapacity * BitsPerKey;
+    blockCount = (bits + BlockWords * 64 - 1) / (BlockWords * 64);
+    words.reset(new std::atomic<uint64_t>[blockCount * BlockWords]());
+}
+
+uint64_t BloomFilter::hashOf(const std::string& name) {
+    return mix(static_cast<uint64_t>(std::hash<std::string>()(name)));
+}
+
+uint64_t BloomFilter::hashOf(const std::string& first, const std::string& second) {
+    return mix(hashOf(first) + 0x9e3779b97f4a7c15ULL * hashOf(second));
+}
+
+// The high half of hash picks the block; a second mix of it supplies the
+// seven 9-bit positions inside the block.
+void BloomFilter::add(uint64_t hash) {
+    size_t block = static_cast<size_t>(((hash >> 32) * blockCount) >> 32);
+    std::atomic<uint64_t>* base = &words[block * BlockWords];
+    uint64_t probe = mix(hash);
+    for (int i = 0; i < Probes; i++) {
+        unsigned bit = static_cast<unsigned>(probe >> (i * 9)) & 511;
+        base[bit >> 6].fetch_or(uint64_t(1) << (bit & 63), std::memory_order_relaxed);
+    }
+    added.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BloomFilter::mightContain(uint64_t hash) const {
+    size_t block = static_cast<size_t>(((hash >> 32) * blockCount) >> 32);
+    const std::atomic<uint64_t>* base = &words[block * BlockWords];
+    uint64_t probe = mix(hash);
+    for (int i = 0; i < Probes; i++) {
+        unsigned bit = static_cast<unsigned>(probe >> (i * 9)) & 511;
+        if (!(base[bit >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
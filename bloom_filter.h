@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Approximate set of names for fast negative lookups. mightContain never
+// misses a name that was added and wrongly accepts about 1% of others
+// while no more than capacity names have been added. Each name sets 7 bits
+// inside one 512-bit block, so a lookup reads a single block. add and
+// mightContain may be called concurrently. Names cannot be taken out
+// again; the owner rebuilds the filter once enough of them are stale.
+class BloomFilter {
+public:
+    explicit BloomFilter(size_t capacity);
+
+    static uint64_t hashOf(const std::string& name);
+    // Key for a pair of names, such as an owner and one of their pets.
+    static uint64_t hashOf(const std::string& first, const std::string& second);
+
+    void add(uint64_t hash);
+    bool mightContain(uint64_t hash) const;
+
+    size_t capacity() const { return keyCapacity; }
+    // Names added, counting repeats.
+    size_t size() const { return added.load(std::memory_order_relaxed); }
+    size_t bytes() const { return blockCount * BlockWords * sizeof(uint64_t); }
+
+private:
+    static const size_t BlockWords = 8;
+    static const size_t BitsPerKey = 10;
+    static const int Probes = 7;
+
+    size_t keyCapacity;
+    size_t blockCount;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+    std::atomic<size_t> added{ 0 };
+};
\ No newline at end of file
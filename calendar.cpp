@@ -0,0 +1,212 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "calendar.h"
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+namespace calendar {
+    static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch");
+    static_assert(daysFromCivil(2000, 3, 1) == 11017, "day after a 400-year leap day");
+    static_assert(weekday(daysFromCivil(2025, 4, 14)) == 0, "2025-04-14 was a Monday");
+    static_assert(daysInMonth(1900, 2) == 28 && daysInMonth(2000, 2) == 29 && daysInMonth(2025, 12) == 31,
+        "month lengths");
+
+    // Howard Hinnant's civil_from_days.
+    std::string civilFromDays(long days) {
+        days += 719468;
+        long era = (days >= 0 ? days : days - 146096) / 146097;
+        long doe = days - era * 146097;
+        long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long mp = (5 * doy + 2) / 153;
+        long day = doy - (153 * mp + 2) / 5 + 1;
+        long month = mp + (mp < 10 ? 3 : -9);
+        long year = yoe + era * 400 + (month <= 2);
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d",
+            static_cast<int>(year), static_cast<int>(month), static_cast<int>(day));
+        return buffer;
+    }
+
+    long long localSeconds() {
+        const time_t Quarter = 15 * 60;
+        thread_local time_t cachedQuarter = -1;
+        thread_local long long offset = 0;
+
+        time_t now = time(nullptr);
+        if (now / Quarter != cachedQuarter) {
+            tm local = {};
+#if defined(_WIN32)
+            localtime_s(&local, &now);
+#else
+            localtime_r(&now, &local);
+#endif
+            long long wall = minuteStamp(daysFromCivil(local.tm_year + 1900L, local.tm_mon + 1L, local.tm_mday),
+                minuteOfDay(local.tm_hour, local.tm_min)) * 60 + local.tm_sec;
+            offset = wall - static_cast<long long>(now);
+            cachedQuarter = now / Quarter;
+        }
+        return static_cast<long long>(now) + offset;
+    }
+
+    long today() {
+        long long seconds = localSeconds();
+        long long days = seconds / 86400 - (seconds % 86400 < 0 ? 1 : 0);
+        return static_cast<long>(days);
+    }
+}
+
+namespace calendar {
+    namespace {
+        const int MonthLengths[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+        // Zeller's congruence, shifted to 0 for Monday. Weekdays repeat every
+        // 400 years, which keeps year positive for January of year 0.
+        int zellerWeekday(long year, int month, int day) {
+            year += 400;
+            if (month < 3) {
+                month += 12;
+                year--;
+            }
+            long k = year % 100, j = year / 100;
+            long h = (day + 13 * (month + 1) / 5 + k + k / 4 + j / 4 + 5 * j) % 7;  // 0 = Saturday
+            return static_cast<int>((h + 5) % 7);
+        }
+
+        struct Failures {
+            std::ostream& out;
+            long count;
+
+            void report(const std::string& what) {
+                if (++count <= 20) {
+                    out << "  " << what << "\n";
+                }
+            }
+        };
+    }
+
+    bool selfTest(std::ostream& out) {
+        Failures failed{ out, 0 };
+        long checked = 0;
+        char text[64];
+
+        // Walk the calendar one day at a time from 0000-01-01; every field
+        // combination that is not the next real date must be rejected.
+        long expectedDays = daysFromCivil(0, 1, 1);
+        for (int year = 0; year <= 9999; year++) {
+            bool leap = year % 400 == 0 || (year % 4 == 0 && year % 100 != 0);
+            if (isLeapYear(year) != leap) {
+                failed.report("isLeapYear(" + std::to_string(year) + ")");
+            }
+            for (int month = 0; month <= 99; month++) {
+                bool realMonth = month >= 1 && month <= 12;
+                int length = realMonth ? MonthLengths[month - 1] + (month == 2 && leap ? 1 : 0) : 0;
+                if (realMonth && daysInMonth(year, month) != length) {
+                    snprintf(text, sizeof(text), "daysInMonth(%04d, %d)", year, month);
+                    failed.report(text);
+                }
+                snprintf(text, sizeof(text), "%04d-%02d-00", year, month);
+                for (int day = 0; day <= 99; day++) {
+                    text[8] = static_cast<char>('0' + day / 10);
+                    text[9] = static_cast<char>('0' + day % 10);
+                    long days = -1;
+                    bool parsed = parseDate(text, 10, days);
+                    bool real = day >= 1 && day <= length;
+                    checked++;
+                    if (parsed != real) {
+                        failed.report(std::string(real ? "rejected " : "accepted ") + text);
+                        continue;
+                    }
+                    if (!real) continue;
+                    if (days != expectedDays || civilFromDays(days) != text ||
+                        weekday(days) != zellerWeekday(year, month, day)) {
+                        failed.report(std::string("days, round trip or weekday of ") + text);
+                    }
+                    expectedDays++;
+                }
+            }
+        }
+
+        for (int hours = 0; hours <= 99; hours++) {
+            for (int minutes = 0; minutes <= 99; minutes++) {
+                snprintf(text, sizeof(text), "%02d:%02d", hours, minutes);
+                int parsed = -1;
+                bool real = hours <= 23 && minutes <= 59;
+                checked++;
+                if (parseTime(text, parsed) != real || (real && parsed != hours * 60 + minutes)) {
+                    failed.report(std::string("parseTime ") + text);
+                }
+            }
+        }
+        const char* const malformed[] = { "", "2025-1-01", "2025-01-1", "2025/01/01", "2025-01-01 ",
+            " 2025-01-01", "+025-01-01", "2025-0a-01", "20250101", "9:30", "09-30", "09:3", "09:300", "-9:30" };
+        for (const char* bad : malformed) {
+            long days;
+            int minutes;
+            checked++;
+            if (parseDate(bad, days) || parseTime(bad, minutes)) {
+                failed.report(std::string("accepted \"") + bad + "\"");
+            }
+        }
+
+        // The C library agrees with the proleptic calendar from 1970 to 2037
+        // everywhere time_t is at least 32 bits.
+        for (long days = 0; days < daysFromCivil(2038, 1, 1); days++) {
+            time_t at = static_cast<time_t>(days) * 86400 + 43200;
+            tm utc = {};
+#if defined(_WIN32)
+            gmtime_s(&utc, &at);
+#else
+            gmtime_r(&at, &utc);
+#endif
+            checked++;
+            if (daysFromCivil(utc.tm_year + 1900L, utc.tm_mon + 1L, utc.tm_mday) != days ||
+                weekday(days) != (utc.tm_wday + 6) % 7) {
+                failed.report("gmtime disagrees at " + civilFromDays(days));
+            }
+        }
+
+        // Wall-clock minutes either side of now, as the C library has them.
+        // Only the UTC offset of now is cached, so minutes on the other
+        // side of a summer-time change are left out.
+        time_t now;
+        long long offset;
+        do {
+            now = time(nullptr);
+            offset = localSeconds() - static_cast<long long>(now);
+        } while (time(nullptr) != now);
+        tm current = {};
+#if defined(_WIN32)
+        localtime_s(&current, &now);
+#else
+        localtime_r(&now, &current);
+#endif
+        for (long minute = -3 * MinutesPerDay; minute <= 3 * MinutesPerDay; minute++) {
+            time_t at = now + static_cast<time_t>(minute) * 60;
+            tm wall = {};
+#if defined(_WIN32)
+            localtime_s(&wall, &at);
+#else
+            localtime_r(&at, &wall);
+#endif
+            if (wall.tm_isdst != current.tm_isdst) continue;
+            snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d", wall.tm_year + 1900, wall.tm_mon + 1,
+                wall.tm_mday, wall.tm_hour, wall.tm_min);
+            long long stamp = 0;
+            long long seconds = static_cast<long long>(at) + offset;
+            checked++;
+            if (!parseDateTime(text, 10, text + 11, 5, stamp) || stamp * 60 != seconds - seconds % 60) {
+                failed.report(std::string("localSeconds disagrees with localtime at ") + text);
+            }
+        }
+        snprintf(text, sizeof(text), "%04d-%02d-%02d", current.tm_year + 1900, current.tm_mon + 1, current.tm_mday);
+        checked++;
+        if (civilFromDays(today()) != text) {
+            failed.report(std::string("today() is not ") + text);
+        }
+
+        out << "Calendar: " << checked << " checks, " << failed.count << " failed\n";
+        return failed.count == 0;
+    }
+}
\ No newline at end of file
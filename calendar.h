@@ -0,0 +1,124 @@
+#pragma once
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+// Date arithmetic on the proleptic Gregorian calendar, independent of the
+// time zone and of the C library's tm conversions. Everything but the
+// clock and the formatting is constexpr, so dates known at compile time
+// cost nothing and the rest needs no locale, stream or lock.
+namespace calendar {
+    const int MinutesPerDay = 24 * 60;
+
+    constexpr bool isLeapYear(long year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    // month is 1 to 12.
+    constexpr int daysInMonth(long year, int month) {
+        return month == 2 ? (isLeapYear(year) ? 29 : 28) : 30 + ((month + month / 8) & 1);
+    }
+
+    // Days since 1970-01-01 (Howard Hinnant's days_from_civil).
+    constexpr long daysFromCivil(long year, long month, long day) {
+        year -= month <= 2;
+        long era = (year >= 0 ? year : year - 399) / 400;
+        long yoe = year - era * 400;
+        long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    // 0 for Monday to 6 for Sunday; 1970-01-01 was a Thursday.
+    constexpr int weekday(long days) {
+        return static_cast<int>(((days % 7) + 7 + 3) % 7);
+    }
+
+    constexpr int minuteOfDay(int hours, int minutes) {
+        return hours * 60 + minutes;
+    }
+
+    // Minutes since 1970-01-01 00:00 for a day and a minute of that day.
+    constexpr long long minuteStamp(long days, int minutes) {
+        return static_cast<long long>(days) * MinutesPerDay + minutes;
+    }
+
+    namespace detail {
+        constexpr bool digits(const char* text, size_t count, int& value) {
+            value = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (text[i] < '0' || text[i] > '9') return false;
+                value = value * 10 + (text[i] - '0');
+            }
+            return true;
+        }
+    }
+
+    // Parses YYYY-MM-DD; returns false unless it is a real date.
+    constexpr bool parseDate(const char* date, size_t length, long& days) {
+        int year = 0, month = 0, day = 0;
+        if (length != 10 || date[4] != '-' || date[7] != '-' ||
+            !detail::digits(date, 4, year) || !detail::digits(date + 5, 2, month) ||
+            !detail::digits(date + 8, 2, day) ||
+            month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+            return false;
+        }
+        days = daysFromCivil(year, month, day);
+        return true;
+    }
+
+    // Parses HH:MM into minutes after midnight; false if out of range.
+    constexpr bool parseTime(const char* time, size_t length, int& minutes) {
+        int hours = 0, mins = 0;
+        if (length != 5 || time[2] != ':' || !detail::digits(time, 2, hours) ||
+            !detail::digits(time + 3, 2, mins) || hours > 23 || mins > 59) {
+            return false;
+        }
+        minutes = minuteOfDay(hours, mins);
+        return true;
+    }
+
+    // Parses a YYYY-MM-DD date and an HH:MM time into a minuteStamp.
+    constexpr bool parseDateTime(const char* date, size_t dateLength, const char* time, size_t timeLength,
+        long long& stamp) {
+        long days = 0;
+        int minutes = 0;
+        if (!parseDate(date, dateLength, days) || !parseTime(time, timeLength, minutes)) {
+            return false;
+        }
+        stamp = minuteStamp(days, minutes);
+        return true;
+    }
+
+    inline bool parseDate(const std::string& date, long& days) {
+        return parseDate(date.data(), date.size(), days);
+    }
+
+    inline bool parseTime(const std::string& time, int& minutes) {
+        return parseTime(time.data(), time.size(), minutes);
+    }
+
+    inline bool parseDateTime(const std::string& date, const std::string& time, long long& stamp) {
+        return parseDateTime(date.data(), date.size(), time.data(), time.size(), stamp);
+    }
+
+    // Inverse of daysFromCivil, formatted as YYYY-MM-DD.
+    std::string civilFromDays(long days);
+
+    // Local wall-clock time in seconds since 1970-01-01 00:00, on the same
+    // scale as minuteStamp * 60. The UTC offset is looked up once per
+    // quarter hour per thread, since time zones only change offset on a
+    // quarter-hour boundary, so this rarely calls into the C library.
+    long long localSeconds();
+    // Today's local date in days since 1970-01-01.
+    long today();
+
+    // Checks every function above exhaustively against straightforward
+    // reference implementations and the C library: every YYYY-MM-DD with
+    // two-digit month and day fields in years 0000 to 9999 and every HH:MM
+    // string, round trips through civilFromDays, weekdays against Zeller's
+    // congruence and mktime, and localSeconds for every minute of the three
+    // days either side of now. Prints each mismatch (up to a limit) and a
+    // summary; returns false if there were any.
+    bool selfTest(std::ostream& out);
+}
\ No newline at end of file
@@ -0,0 +1,479 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "change_feed.h"
+#include "exceptions.h"
+#include "file_utils.h"
+#include "trace.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+    const char* const eventTypes[] = {
+        "owner.added",
+        "owner.updated",
+        "owner.deleted",
+        "pet.added",
+        "pet.updated",
+        "pet.deleted",
+        "medical-note.appended",
+        "medical-history.replaced",
+        "appointment.scheduled",
+        "appointment.status-changed",
+        "appointment.cancelled"
+    };
+    const size_t eventTypeCount = sizeof(eventTypes) / sizeof(eventTypes[0]);
+    static_assert(eventTypeCount == static_cast<size_t>(Mutation::Type::Cancel) + 1,
+        "eventTypes must have one entry per Mutation::Type");
+
+    void appendEscaped(std::string& out, const std::string& field) {
+        for (char c : field) {
+            switch (c) {
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\\': out += "\\\\"; break;
+            default: out += c; break;
+            }
+        }
+    }
+
+    std::vector<std::string> splitEscaped(const std::string& line) {
+        std::vector<std::string> fields(1);
+        for (size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (c == '\t') {
+                fields.emplace_back();
+            }
+            else if (c == '\\' && i + 1 < line.size()) {
+                char next = line[++i];
+                fields.back() += next == 't' ? '\t' : next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+            }
+            else {
+                fields.back() += c;
+            }
+        }
+        return fields;
+    }
+
+    bool parseNumber(const std::string& text, uint64_t& value) {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+        value = std::stoull(text);
+        return true;
+    }
+
+    int64_t nowMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Once the active file passes RotateBytes it becomes <path>.1, the
+    // older segments move up one and <path>.<KeptSegments> is removed.
+    const uint64_t RotateBytes = 64 * 1024 * 1024;
+    const int KeptSegments = 4;
+    // How much of the end of a file open() reads at first; enough for
+    // all but the largest commits.
+    const uint64_t TailBytes = 64 * 1024;
+
+    bool readRange(const std::string& path, uint64_t from, uint64_t length, std::string& contents) {
+        std::ifstream in(path, std::ios::binary);
+        contents.assign(static_cast<size_t>(length), '\0');
+        return in.is_open() && in.seekg(static_cast<std::streamoff>(from)) &&
+            in.read(&contents[0], static_cast<std::streamsize>(length));
+    }
+
+    // Finds the last complete commit from the end of the file, reading
+    // TailBytes (or more for a longer commit), and sets keep to where it
+    // ends. If the process stopped before all of a commit's events were
+    // written, they are dropped (along with a torn last line) and the
+    // whole commit is published again from the journal.
+    bool findLastCommit(const std::string& path, uint64_t size, ChangeEvent& last, uint64_t& keep) {
+        for (uint64_t window = TailBytes;; window *= 4) {
+            uint64_t from = size > window ? size - window : 0;
+            std::string contents;
+            if (!readRange(path, from, size - from, contents)) {
+                keep = size;
+                return false;
+            }
+            // The first line read may have been cut.
+            size_t base = 0;
+            if (from > 0) {
+                base = contents.find('\n');
+                if (base == std::string::npos) continue;
+                base++;
+            }
+
+            size_t complete = contents.rfind('\n');
+            complete = complete == std::string::npos || complete < base ? base : complete + 1;
+            size_t end = complete;
+            std::vector<ChangeEvent> lastCommit;
+            bool haveLast = false;
+            bool decided = from == 0;
+            while (end > base) {
+                size_t start = end >= 2 ? contents.rfind('\n', end - 2) : std::string::npos;
+                start = start == std::string::npos ? 0 : start + 1;
+                ChangeEvent event;
+                if (!ChangeEvent::decode(contents.substr(start, end - 1 - start), event)) {
+                    decided = true;
+                    break;
+                }
+                if (!lastCommit.empty() && event.journalSequence != lastCommit.front().journalSequence) {
+                    last = event;
+                    haveLast = true;
+                    decided = true;
+                    break;
+                }
+                lastCommit.push_back(event);
+                end = start;
+                if (lastCommit.size() >= event.commitSize) {
+                    decided = true;
+                    break;
+                }
+            }
+            if (!decided) continue;
+
+            if (!lastCommit.empty() && lastCommit.size() >= lastCommit.front().commitSize) {
+                last = lastCommit.front();
+                haveLast = true;
+                keep = from + complete;
+            }
+            else {
+                keep = from + end;
+            }
+            return haveLast;
+        }
+    }
+
+    // Sequence of the first event in the file, or 0 if it has none.
+    uint64_t firstSequence(std::istream& in) {
+        std::string line;
+        ChangeEvent event;
+        if (!std::getline(in, line) || in.eof() || !ChangeEvent::decode(line, event)) {
+            return 0;
+        }
+        return event.sequence;
+    }
+
+    uint64_t firstSequence(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return firstSequence(in);
+    }
+}
+
+const char* ChangeEvent::type() const {
+    return eventTypes[static_cast<size_t>(mutation.type)];
+}
+
+std::string ChangeEvent::encode(bool credentials) const {
+    std::string line = std::to_string(sequence) + '\t' + std::to_string(journalSequence) + '\t' +
+        std::to_string(commitSize) + '\t' + std::to_string(timestampMillis) + '\t' + type();
+    for (size_t i = 0; i < mutation.fields.size(); i++) {
+        line += '\t';
+        if (credentials || mutation.type != Mutation::Type::RegisterOwner || i != 5) {
+            appendEscaped(line, mutation.fields[i]);
+        }
+    }
+    return line;
+}
+
+bool ChangeEvent::decode(const std::string& line, ChangeEvent& out) {
+    std::vector<std::string> fields = splitEscaped(line);
+    uint64_t commitSize = 0, timestamp = 0;
+    if (fields.size() < 5 || !parseNumber(fields[0], out.sequence) ||
+        !parseNumber(fields[1], out.journalSequence) || !parseNumber(fields[2], commitSize) ||
+        commitSize == 0 || !parseNumber(fields[3], timestamp)) {
+        return false;
+    }
+    out.commitSize = static_cast<uint32_t>(commitSize);
+    out.timestampMillis = static_cast<int64_t>(timestamp);
+
+    size_t type = 0;
+    while (type < eventTypeCount && fields[4] != eventTypes[type]) type++;
+    if (type == eventTypeCount) return false;
+
+    out.mutation.type = static_cast<Mutation::Type>(type);
+    out.mutation.fields.assign(fields.begin() + 5, fields.end());
+    return out.mutation.fields.size() == Mutation::fieldCount(out.mutation.type);
+}
+
+ChangeFeed::ChangeFeed(const std::string& path, const std::string& replicaPath)
+    : outputs{ { path, false, nullptr, 0, 0 }, { replicaPath, true, nullptr, 0, 0 } } {}
+
+ChangeFeed::~ChangeFeed() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wake.notify_one();
+    }
+    if (writer.joinable()) {
+        writer.join();
+    }
+    for (auto& output : outputs) {
+        if (output.file) {
+            fclose(output.file);
+        }
+    }
+}
+
+uint64_t ChangeFeed::open() {
+    trace::Span span("change feed open");
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // After a crash one file may be ahead of the other. Commits after the
+    // one both have are published again and each file skips the events it
+    // already holds. A file with no events at all (the replica feed of an
+    // older installation) starts where the other one is.
+    ChangeEvent last[2];
+    bool found[2];
+    for (int i = 0; i < 2; i++) {
+        found[i] = openOutput(outputs[i], last[i]);
+    }
+    if (!found[0] && !found[1]) {
+        return 0;
+    }
+    int behind = !found[0] ? 1 : !found[1] ? 0 : last[1].sequence < last[0].sequence ? 1 : 0;
+    for (int i = 0; i < 2; i++) {
+        outputs[i].lastSequence = found[i] ? last[i].sequence : last[behind].sequence;
+    }
+    nextSequence = last[behind].sequence + 1;
+    writtenSequence = last[behind].sequence;
+    return last[behind].journalSequence;
+}
+
+bool ChangeFeed::openOutput(Output& output, ChangeEvent& last) {
+    output.size = 0;
+    uint64_t size = 0, keep = 0;
+    bool found = false;
+    if (file_utils::fileSize(output.path, size)) {
+        found = findLastCommit(output.path, size, last, keep);
+        if (keep < size) {
+            FILE* existing = fopen(output.path.c_str(), "r+b");
+            if (!existing || !file_utils::truncate(existing, keep)) {
+                if (existing) fclose(existing);
+                throw FileWriteException(output.path);
+            }
+            fclose(existing);
+        }
+        output.size = keep;
+    }
+    if (!found) {
+        // Rotated just before the program stopped.
+        std::string newest = file_utils::rotatedPath(output.path, 1);
+        found = file_utils::fileSize(newest, size) && findLastCommit(newest, size, last, keep);
+    }
+    return found;
+}
+
+void ChangeFeed::publish(uint64_t journalSequence, const std::vector<Mutation>& mutations) {
+    if (mutations.empty()) return;
+    int64_t timestamp = nowMillis();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!writer.joinable()) {
+        writer = std::thread(&ChangeFeed::writerLoop, this);
+    }
+    for (const auto& mutation : mutations) {
+        ChangeEvent event;
+        event.sequence = nextSequence++;
+        event.journalSequence = journalSequence;
+        event.commitSize = static_cast<uint32_t>(mutations.size());
+        event.timestampMillis = timestamp;
+        event.mutation = mutation;
+        queue.push_back(std::move(event));
+    }
+    wake.notify_one();
+}
+
+void ChangeFeed::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!writer.joinable()) return;
+    uint64_t target = nextSequence - 1;
+    syncRequested = true;
+    wake.notify_one();
+    drained.wait(lock, [&]() { return (writtenSequence >= target && !syncRequested) || stopping; });
+}
+
+void ChangeFeed::writerLoop() {
+    trace::nameThread("change feed");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return !queue.empty() || syncRequested || stopping; });
+        if (queue.empty() && !syncRequested && stopping) break;
+
+        std::vector<ChangeEvent> batch;
+        batch.swap(queue);
+        bool sync = syncRequested;
+        lock.unlock();
+
+        {
+            trace::Span span("change feed write");
+            for (auto& output : outputs) {
+                write(output, batch, sync);
+            }
+        }
+
+        lock.lock();
+        if (!batch.empty()) {
+            writtenSequence = batch.back().sequence;
+        }
+        if (sync) {
+            syncRequested = false;
+        }
+        drained.notify_all();
+    }
+}
+
+void ChangeFeed::write(Output& output, const std::vector<ChangeEvent>& batch, bool sync) {
+    std::string text;
+    for (const auto& event : batch) {
+        if (event.sequence > output.lastSequence) {
+            text += event.encode(output.credentials);
+            text += '\n';
+        }
+    }
+    if (!output.file) {
+        output.file = fopen(output.path.c_str(), "ab");
+    }
+    bool written = output.file && fwrite(text.data(), 1, text.size(), output.file) == text.size() &&
+        (sync ? file_utils::sync(output.file) : fflush(output.file) == 0);
+    if (!written) {
+        std::cerr << "Error: Could not write to file " << output.path << std::endl;
+    }
+    if (!batch.empty()) {
+        output.lastSequence = std::max(output.lastSequence, batch.back().sequence);
+    }
+    output.size += text.size();
+    // A batch holds whole commits, so no commit is split between files.
+    if (written && output.size >= RotateBytes) {
+        rotate(output);
+    }
+}
+
+void ChangeFeed::rotate(Output& output) {
+    trace::Span span("change feed rotate");
+    fclose(output.file);
+    output.file = nullptr;
+    // If a reader has the file open where that prevents it (Windows), it is
+    // tried again after the next batch.
+    if (file_utils::rotate(output.path, KeptSegments)) {
+        output.size = 0;
+    }
+}
+
+uint64_t ChangeFeed::read(const std::string& path, uint64_t after,
+    const std::function<void(const ChangeEvent&)>& handler) {
+    if (!std::ifstream(path).is_open() && !std::ifstream(file_utils::rotatedPath(path, 1)).is_open()) {
+        throw FileAccessException(path);
+    }
+
+    uint64_t last = after;
+    ChangeFeedReader reader(path, after);
+    reader.poll([&](const std::vector<ChangeEvent>& events) {
+        for (const auto& event : events) {
+            if (event.sequence > after) {
+                handler(event);
+                last = event.sequence;
+            }
+        }
+    });
+    return last;
+}
+
+ChangeFeedReader::ChangeFeedReader(const std::string& path, uint64_t after)
+    : path(path), lastSequence(after) {}
+
+size_t ChangeFeedReader::poll(const std::function<void(const std::vector<ChangeEvent>&)>& handler) {
+    // Oldest segment first, the active file last.
+    std::vector<std::string> files;
+    for (int segment = KeptSegments; segment >= 1; segment--) {
+        files.push_back(file_utils::rotatedPath(path, segment));
+    }
+    files.push_back(path);
+
+    // Usually the file being read is still the active one.
+    size_t current = files.size();
+    if (fileFirst != 0) {
+        for (size_t i = files.size(); i-- > 0;) {
+            if (firstSequence(files[i]) == fileFirst) {
+                current = i;
+                break;
+            }
+        }
+    }
+    // Otherwise the next event is in the newest file that starts at or
+    // before it.
+    if (current == files.size()) {
+        size_t oldest = files.size();
+        uint64_t oldestFirst = 0;
+        for (size_t i = files.size(); i-- > 0;) {
+            uint64_t first = firstSequence(files[i]);
+            if (first == 0) continue;
+            oldest = i;
+            oldestFirst = first;
+            if (first <= lastSequence + 1) {
+                current = i;
+                break;
+            }
+        }
+        if (oldest == files.size()) {
+            return 0;
+        }
+        if (current == files.size()) {
+            if (lastSequence > 0) {
+                std::cerr << "Warning: events " << lastSequence + 1 << " to " << oldestFirst - 1
+                    << " were rotated out of " << path << " before they were read." << std::endl;
+            }
+            current = oldest;
+        }
+        fileFirst = 0;
+    }
+
+    size_t delivered = 0;
+    for (size_t i = current; i < files.size(); i++) {
+        std::ifstream in(files[i], std::ios::binary);
+        uint64_t first = firstSequence(in);
+        if (first == 0) continue;  // not started yet
+        if (first != fileFirst) {
+            if (i == current && fileFirst != 0) break;  // rotated since it was found
+            fileFirst = first;
+            offset = 0;
+        }
+        in.clear();
+        in.seekg(offset);
+        delivered += readCommits(in, handler);
+    }
+    return delivered;
+}
+
+size_t ChangeFeedReader::readCommits(std::istream& in,
+    const std::function<void(const std::vector<ChangeEvent>&)>& handler) {
+    size_t delivered = 0;
+    std::streamoff position = offset;
+    std::vector<ChangeEvent> commit;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (in.eof()) break;  // no newline yet: still being written
+        position += static_cast<std::streamoff>(line.size()) + 1;
+
+        ChangeEvent event;
+        if (!ChangeEvent::decode(line, event)) {
+            std::cerr << "Skipping malformed event in " << path << std::endl;
+            continue;
+        }
+        if (!commit.empty() && event.journalSequence != commit.front().journalSequence) {
+            commit.clear();  // never completed; the writer published it again
+        }
+        commit.push_back(event);
+        if (commit.size() >= event.commitSize) {
+            // Events already passed on are read again after a rotation.
+            if (commit.back().sequence > lastSequence) {
+                handler(commit);
+                delivered += commit.size();
+                lastSequence = commit.back().sequence;
+            }
+            commit.clear();
+            offset = position;
+        }
+    }
+    return delivered;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <ios>
+#include <istream>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "mutation.h"
+
+// One committed change as seen by downstream consumers.
+struct ChangeEvent {
+    uint64_t sequence = 0;         // position in the feed, +1 per event
+    uint64_t journalSequence = 0;  // commit the change belongs to
+    uint32_t commitSize = 0;       // number of events in that commit
+    int64_t timestampMillis = 0;   // commit time, Unix epoch
+    Mutation mutation;
+
+    // Event type, e.g. "owner.added" or "appointment.status-changed".
+    const char* type() const;
+
+    // One line: sequence, journal sequence, commit size, timestamp, type
+    // and the mutation's fields separated by tabs, with tab, newline, carriage
+    // return and backslash escaped as \t \n \r \\. Without credentials,
+    // the password hash of owner.added is left empty.
+    std::string encode(bool credentials = true) const;
+    static bool decode(const std::string& line, ChangeEvent& out);
+};
+
+// Append-only change-data-capture feed (vms.feed). Commits hand their
+// mutations to publish(), which only queues them; a background thread
+// writes them out, so the commit path never waits for this file.
+// Consumers remember the last sequence they processed and resume with
+// read(). Events lost in a crash before they were written are
+// re-published from the journal on the next start (see VMS::loadData).
+//
+// The feed goes to billing, SMS and analytics consumers, so it leaves out
+// password hashes. The same events are written in full, with the same
+// sequence numbers, to a second file (vms.replica.feed) that only
+// replicas read.
+//
+// Each file is rotated after a write takes it past 64 MB: it becomes
+// <path>.1, older segments move up to <path>.4 and the oldest is removed,
+// so the feed keeps between 256 and 320 MB of recent history. open() only
+// reads the end of the file, so startup does not grow with the history.
+class ChangeFeed {
+public:
+    ChangeFeed(const std::string& path, const std::string& replicaPath);
+    ~ChangeFeed();
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    // Continues an existing feed: drops the events of a commit that was
+    // only partly written and returns the journal sequence of the last
+    // commit complete in both files (0 for a new feed).
+    uint64_t open();
+
+    // Queues the mutations of one commit, numbered in call order.
+    void publish(uint64_t journalSequence, const std::vector<Mutation>& mutations);
+
+    // Waits until everything published so far is written and synced.
+    void flush();
+
+    // Passes every event after the given sequence to handler and returns
+    // the last sequence seen. Stops at a commit whose events are not all
+    // written yet. Throws FileAccessException if there is no feed.
+    static uint64_t read(const std::string& path, uint64_t after,
+        const std::function<void(const ChangeEvent&)>& handler);
+
+private:
+    struct Output {
+        std::string path;
+        bool credentials;
+        FILE* file;
+        // Last event in the file; earlier ones are not written again.
+        uint64_t lastSequence;
+        // Bytes in the active file.
+        uint64_t size;
+    };
+
+    // Drops a partly written last commit and returns the last complete
+    // one's event, if any, from the active file or the newest segment.
+    static bool openOutput(Output& output, ChangeEvent& last);
+    static void write(Output& output, const std::vector<ChangeEvent>& batch, bool sync);
+    static void rotate(Output& output);
+    void writerLoop();
+
+    Output outputs[2];
+    std::thread writer;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::vector<ChangeEvent> queue;
+    uint64_t nextSequence = 1;
+    uint64_t writtenSequence = 0;
+    bool syncRequested = false;
+    bool stopping = false;
+};
+
+// Follows a feed that another process is appending to. Each poll() reads
+// what has been added since the previous one and hands over whole commits
+// only, so a reader never sees part of a transaction. Reading carries on
+// across rotations; events rotated out before they were read are
+// reported on stderr and skipped.
+class ChangeFeedReader {
+public:
+    // Starts with the first commit still kept that ends after the given
+    // event.
+    explicit ChangeFeedReader(const std::string& path, uint64_t after = 0);
+
+    // Passes each newly completed commit's events to handler, in order,
+    // and returns how many events were passed. A missing file counts as
+    // empty.
+    size_t poll(const std::function<void(const std::vector<ChangeEvent>&)>& handler);
+
+private:
+    size_t readCommits(std::istream& in, const std::function<void(const std::vector<ChangeEvent>&)>& handler);
+
+    std::string path;
+    // Last event passed on.
+    uint64_t lastSequence;
+    // The file being read, known by its first event (0 before it is
+    // found), and the start of the first commit in it not yet passed on.
+    uint64_t fileFirst = 0;
+    std::streamoff offset = 0;
+};
\ No newline at end of file
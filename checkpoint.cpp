@@ -0,0 +1,310 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "checkpoint.h"
+#include "exceptions.h"
+#include "csv_utils.h"
+#include "file_utils.h"
+#include "stats.h"
+#include "trace.h"
+#include "lazy_text.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+
+namespace checkpoint {
+    namespace {
+        const char* const ManifestPath = "vms.checkpoint";
+        // The checkpoint before the current one, kept until the next is
+        // written: its manifest, and each of its files as <name>.prev
+        // (or still <name>, if the current checkpoint has the same one).
+        const char* const PreviousManifestPath = "vms.checkpoint.prev";
+        const char* const PreviousSuffix = ".prev";
+
+        struct FileEntry {
+            std::string name;
+            size_t size;
+            uint32_t crc;
+        };
+
+        struct Manifest {
+            uint64_t sequence = 0;
+            std::vector<FileEntry> files;
+        };
+
+        bool readManifest(Manifest& manifest, const std::string& path = ManifestPath) {
+            std::ifstream in(path);
+            if (!in.is_open()) return false;
+
+            std::string tag;
+            if (!(in >> tag >> manifest.sequence) || tag != "checkpoint") {
+                std::cerr << "Ignoring unreadable " << path << std::endl;
+                return false;
+            }
+            FileEntry entry;
+            std::string crcText;
+            while (in >> tag >> entry.name >> entry.size >> crcText && tag == "file") {
+                entry.crc = static_cast<uint32_t>(std::stoul(crcText, nullptr, 16));
+                manifest.files.push_back(entry);
+            }
+            return true;
+        }
+
+        // Writes one data file as <name>.tmp and records it in the manifest.
+        void writeFile(Manifest& manifest, const std::string& name, const std::string& contents) {
+            file_utils::writeDurably(name + ".tmp", contents);
+            manifest.files.push_back(FileEntry{ name, contents.size(), file_utils::crc32(contents) });
+        }
+
+        // Streams one CSV file to <name>.tmp, rows being written by
+        // writeRows, and records it in the manifest.
+        template<typename WriteRows>
+        void writeCsvFile(Manifest& manifest, const std::string& name, WriteRows writeRows) {
+            std::string tmpPath = name + ".tmp";
+            FILE* file = fopen(tmpPath.c_str(), "wb");
+            if (!file) {
+                throw FileWriteException(tmpPath);
+            }
+            csv_utils::CsvWriter out(file);
+            try {
+                writeRows(out);
+            }
+            catch (...) {
+                fclose(file);
+                throw;
+            }
+            bool written = out.flush() && file_utils::sync(file);
+            written = fclose(file) == 0 && written;
+            if (!written) {
+                throw FileWriteException(tmpPath);
+            }
+            manifest.files.push_back(FileEntry{ name, static_cast<size_t>(out.position()), out.crc() });
+        }
+
+        bool matches(const std::string& path, const FileEntry& entry, std::string& contents) {
+            return file_utils::readFile(path, contents) &&
+                contents.size() == entry.size && file_utils::crc32(contents) == entry.crc;
+        }
+
+        bool matches(const std::string& path, const FileEntry& entry) {
+            size_t size = 0;
+            uint32_t crc = 0;
+            return file_utils::checksumFile(path, size, crc) && size == entry.size && crc == entry.crc;
+        }
+
+        // Writes contents to a temporary file and replaces path with it.
+        void replaceDurably(const std::string& path, const std::string& contents) {
+            std::string tmpPath = path + ".tmp";
+            file_utils::writeDurably(tmpPath, contents);
+            if (!file_utils::replaceFile(tmpPath, path)) {
+                throw FileWriteException(path);
+            }
+        }
+
+        // Moves the file now at name to name.prev and the new one at
+        // name.tmp into its place.
+        bool install(const std::string& name) {
+            if (std::ifstream(name).is_open() && !file_utils::replaceFile(name, name + PreviousSuffix)) {
+                return false;
+            }
+            return file_utils::replaceFile(name + ".tmp", name);
+        }
+
+        // Makes every file of manifest current: one that no longer matches
+        // is taken from its .tmp copy (a checkpoint interrupted after its
+        // manifest was written) or its .prev copy (falling back to the
+        // previous checkpoint). Leaves the first file that matches none
+        // in damaged and returns false.
+        bool settle(const Manifest& manifest, std::string& damaged) {
+            for (const auto& entry : manifest.files) {
+                std::string tmpPath = entry.name + ".tmp";
+                std::string previousPath = entry.name + PreviousSuffix;
+                if (matches(tmpPath, entry)) {
+                    if (!install(entry.name)) {
+                        throw FileWriteException(entry.name);
+                    }
+                    continue;
+                }
+                // Left over from a checkpoint that never reached its manifest.
+                remove(tmpPath.c_str());
+                if (matches(entry.name, entry)) continue;
+                if (matches(previousPath, entry)) {
+                    if (!file_utils::replaceFile(previousPath, entry.name)) {
+                        throw FileWriteException(entry.name);
+                    }
+                    continue;
+                }
+                damaged = entry.name;
+                return false;
+            }
+            return true;
+        }
+
+        // Keeps the current manifest as the previous one, replaces it with
+        // one listing the .tmp files just written, then renames them into
+        // place, keeping the files they replace as .prev. relocations are
+        // the new offsets of medical histories left on disk (see
+        // lazy_text.h). Returns the journal sequence of the checkpoint
+        // replaced, or 0 if there was none.
+        uint64_t commit(const Manifest& manifest,
+            const std::vector<std::pair<uint32_t, uint64_t>>& relocations = {}) {
+            Manifest current;
+            std::string currentText;
+            if (readManifest(current) && file_utils::readFile(ManifestPath, currentText)) {
+                replaceDurably(PreviousManifestPath, currentText);
+            }
+
+            std::ostringstream text;
+            text << "checkpoint " << manifest.sequence << "\n";
+            for (const auto& entry : manifest.files) {
+                char crc[9];
+                snprintf(crc, sizeof(crc), "%08x", static_cast<unsigned>(entry.crc));
+                text << "file " << entry.name << " " << entry.size << " " << crc << "\n";
+            }
+            replaceDurably(ManifestPath, text.str());
+
+            // Committed; a crash from here on is finished by recover().
+            for (const auto& entry : manifest.files) {
+                auto replace = [&entry]() { return install(entry.name); };
+                bool replaced = entry.name == "pets.csv"
+                    ? lazy_text::replaceDataFile(replace, relocations) : replace();
+                if (!replaced) {
+                    throw FileWriteException(entry.name);
+                }
+            }
+            return current.sequence;
+        }
+    }
+
+    uint64_t write(const Snapshot& snapshot, const std::vector<std::pair<std::string, std::string>>& extraFiles) {
+        trace::Span span("checkpoint write");
+        Manifest manifest;
+        manifest.sequence = snapshot.journalSequence;
+        std::vector<std::pair<uint32_t, uint64_t>> relocations;
+
+        {
+            stats::ScopedTimer fileTimer(stats::Op::SaveOwners);
+            trace::Span fileSpan("write owners.csv");
+            writeCsvFile(manifest, "owners.csv", [&snapshot](csv_utils::CsvWriter& out) {
+                for (const auto& owner : *snapshot.owners) {
+                    owner.writeCSV(out);
+                    out.endRow();
+                }
+            });
+        }
+
+        {
+            stats::ScopedTimer fileTimer(stats::Op::SavePets);
+            trace::Span fileSpan("write pets.csv");
+            writeCsvFile(manifest, "pets.csv", [&snapshot, &relocations](csv_utils::CsvWriter& out) {
+                for (const auto& owner : *snapshot.owners) {
+                    for (const auto& pet : owner.pets) {
+                        out.field(owner.name);
+                        uint64_t historyOffset = 0;
+                        pet.writeCSV(out, &historyOffset);
+                        if (!pet.medicalHistory.isResident()) {
+                            relocations.emplace_back(pet.medicalHistory.diskId(), historyOffset);
+                        }
+                        out.endRow();
+                    }
+                }
+            });
+        }
+
+        {
+            stats::ScopedTimer fileTimer(stats::Op::SaveAppointments);
+            trace::Span fileSpan("write appointments.csv");
+            writeCsvFile(manifest, "appointments.csv", [&snapshot](csv_utils::CsvWriter& out) {
+                for (const auto& appt : *snapshot.appointments) {
+                    appt.writeCSV(out);
+                    out.endRow();
+                }
+            });
+        }
+
+        for (const auto& file : extraFiles) {
+            writeFile(manifest, file.first, file.second);
+        }
+        return commit(manifest, relocations);
+    }
+
+    uint64_t recover() {
+        trace::Span span("checkpoint recover");
+        Manifest manifest, previous;
+        std::string damaged;
+        bool current = readManifest(manifest);
+        if (current && settle(manifest, damaged)) {
+            return manifest.sequence;
+        }
+        bool fallback = readManifest(previous, PreviousManifestPath);
+        if (!current && !fallback) {
+            return 0;
+        }
+
+        std::string problem = current ? damaged + " does not match checkpoint " + std::to_string(manifest.sequence)
+            : std::string(ManifestPath) + " cannot be read";
+        std::string previousDamaged;
+        if (!fallback || !settle(previous, previousDamaged)) {
+            throw OperationFailedException(problem +
+                " and there is no intact earlier checkpoint to fall back to; restore the data files from a backup.");
+        }
+
+        // Files only the damaged checkpoint had (a new archive segment)
+        // hold nothing the previous one needs.
+        for (const auto& entry : manifest.files) {
+            bool shared = false;
+            for (const auto& kept : previous.files) {
+                shared = shared || kept.name == entry.name;
+            }
+            if (!shared) {
+                remove(entry.name.c_str());
+            }
+        }
+        std::string previousText;
+        if (!file_utils::readFile(PreviousManifestPath, previousText)) {
+            throw FileAccessException(PreviousManifestPath);
+        }
+        replaceDurably(ManifestPath, previousText);
+        std::cerr << "Warning: " << problem << "; falling back to checkpoint " << previous.sequence
+            << " and replaying the journal from there." << std::endl;
+        return previous.sequence;
+    }
+
+    uint64_t copyFrom(const std::string& directory) {
+        trace::Span span("checkpoint copy");
+        std::string prefix = directory.empty() ? "" : directory + "/";
+
+        // The other process may be part-way through a checkpoint: each file
+        // is either still the old one or already renamed, and the .tmp copy
+        // is then the other. Whichever matches the manifest is used; if the
+        // manifest is replaced meanwhile, start over.
+        for (int attempt = 0; attempt < 20; attempt++) {
+            Manifest source;
+            if (!readManifest(source, prefix + ManifestPath)) {
+                throw FileAccessException(prefix + ManifestPath);
+            }
+
+            Manifest copy;
+            copy.sequence = source.sequence;
+            for (const auto& entry : source.files) {
+                std::string contents;
+                if (!matches(prefix + entry.name, entry, contents) &&
+                    !matches(prefix + entry.name + ".tmp", entry, contents)) {
+                    break;
+                }
+                writeFile(copy, entry.name, contents);
+            }
+
+            if (copy.files.size() == source.files.size()) {
+                commit(copy);
+                return copy.sequence;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        throw OperationFailedException("The checkpoint in " + directory + " keeps changing; try again.");
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include "snapshot.h"
+
+// Crash-safe rewrites of owners.csv, pets.csv and appointments.csv.
+//
+// A checkpoint writes each file as <name>.tmp and syncs it, then replaces
+// the manifest (vms.checkpoint) in one step; that is the commit point. The
+// manifest names the journal sequence the files contain and the size and
+// CRC-32 of each. Only then are the .tmp files renamed over the originals,
+// so a crash at any moment leaves either the previous checkpoint intact or
+// a new one that recover() can finish.
+//
+// The checkpoint before the current one is kept as a fallback: its
+// manifest as vms.checkpoint.prev and the files it replaced as
+// <name>.prev. The journal keeps the records after it (see write), so if
+// a file of the current checkpoint is found damaged, recover() goes back
+// to the previous one and the journal brings it up to date.
+namespace checkpoint {
+    // Writes the snapshot as a checkpoint covering its journalSequence,
+    // together with any further files given as (name, contents), such as a
+    // new archive segment. Does not lock anything; snapshots are immutable.
+    // Throws FileWriteException, in which case the previous checkpoint
+    // stands. Returns the journal sequence of the checkpoint it replaced,
+    // now the fallback; the journal must keep the records after it.
+    uint64_t write(const Snapshot& snapshot,
+        const std::vector<std::pair<std::string, std::string>>& extraFiles = {});
+
+    // Completes a checkpoint interrupted after its manifest was written and
+    // returns the journal sequence the CSV files contain (0 if there is no
+    // manifest, e.g. files from before checkpoints existed). If a file no
+    // longer matches its checksum, the previous checkpoint is restored
+    // instead (with a warning) and its sequence returned. Throws
+    // OperationFailedException if neither is intact.
+    uint64_t recover();
+
+    // Copies the checkpoint in another directory (a primary's) into this
+    // one as a checkpoint of its own and returns its journal sequence.
+    // Safe while the other process is checkpointing. Throws
+    // FileAccessException if the directory has no checkpoint.
+    uint64_t copyFrom(const std::string& directory);
+}
\ No newline at end of file
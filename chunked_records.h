@@ -0,0 +1,145 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only sequence of records (Owner, Appointment) kept as chunks of
+// ChunkSlots consecutive VMS slots. A snapshot shares every chunk its
+// predecessor had unless one of the chunk's slots was written, so
+// publishing a commit copies the chunks it touched and the chunk pointers,
+// not the table. Tombstoned slots stay in their chunk until the next
+// compaction and are skipped by everything below.
+template<typename Record>
+class ChunkedRecords {
+public:
+    static const size_t ChunkSlots = 256;
+
+    struct Chunk {
+        std::vector<Record> slots;
+        // Positions in slots that are not tombstoned, ascending.
+        std::vector<uint32_t> live;
+    };
+    typedef std::shared_ptr<const Chunk> ChunkPtr;
+
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Record value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Record* pointer;
+        typedef const Record& reference;
+
+        const_iterator() {}
+        const_iterator(const std::vector<ChunkPtr>* parts, size_t chunk) : parts(parts), chunk(chunk) {
+            skipEmpty();
+        }
+
+        reference operator*() const { return (*parts)[chunk]->slots[(*parts)[chunk]->live[position]]; }
+        pointer operator->() const { return &**this; }
+        const_iterator& operator++() {
+            if (++position == (*parts)[chunk]->live.size()) {
+                position = 0;
+                ++chunk;
+                skipEmpty();
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator before = *this;
+            ++*this;
+            return before;
+        }
+        bool operator==(const const_iterator& other) const {
+            return chunk == other.chunk && position == other.position;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        void skipEmpty() {
+            while (chunk < parts->size() && (*parts)[chunk]->live.empty()) {
+                ++chunk;
+            }
+        }
+
+        const std::vector<ChunkPtr>* parts = nullptr;
+        size_t chunk = 0;
+        size_t position = 0;
+    };
+
+    ChunkedRecords() {}
+    explicit ChunkedRecords(std::vector<ChunkPtr> chunks) : parts(std::move(chunks)) {
+        ends.reserve(parts.size());
+        size_t total = 0;
+        for (const auto& part : parts) {
+            total += part->live.size();
+            ends.push_back(total);
+        }
+    }
+
+    size_t size() const { return ends.empty() ? 0 : ends.back(); }
+    bool empty() const { return size() == 0; }
+    // The index-th live record; a binary search over the chunks.
+    const Record& operator[](size_t index) const {
+        size_t chunk = std::upper_bound(ends.begin(), ends.end(), index) - ends.begin();
+        size_t first = chunk == 0 ? 0 : ends[chunk - 1];
+        return parts[chunk]->slots[parts[chunk]->live[index - first]];
+    }
+    const_iterator begin() const { return const_iterator(&parts, 0); }
+    const_iterator end() const { return const_iterator(&parts, parts.size()); }
+
+    const std::vector<ChunkPtr>& chunks() const { return parts; }
+
+    // Chunk number chunk of table, copied slot for slot.
+    static ChunkPtr copy(const std::vector<Record>& table, size_t chunk) {
+        auto next = std::make_shared<Chunk>();
+        size_t first = chunk * ChunkSlots;
+        size_t last = std::min(table.size(), first + ChunkSlots);
+        if (first < last) {
+            next->slots.assign(table.begin() + first, table.begin() + last);
+        }
+        findLive(*next);
+        return next;
+    }
+
+    // previous (nullptr for a new chunk) with the slots in [begin, end)
+    // (ascending, all in chunk number chunk) taken from table instead.
+    // Slots before them that previous does not reach yet belong to
+    // commits still in progress; they get tombstoned stand-ins, which
+    // those commits overwrite when they publish.
+    static ChunkPtr overlay(const ChunkPtr& previous, const std::vector<Record>& table, size_t chunk,
+        const size_t* begin, const size_t* end) {
+        auto next = previous ? std::make_shared<Chunk>(*previous) : std::make_shared<Chunk>();
+        size_t first = chunk * ChunkSlots;
+        size_t needed = end[-1] - first + 1;
+        if (next->slots.size() < needed) {
+            Record standIn = table[end[-1]];
+            standIn.deleted = true;
+            next->slots.resize(needed, standIn);
+        }
+        for (const size_t* slot = begin; slot != end; ++slot) {
+            next->slots[*slot - first] = table[*slot];
+        }
+        findLive(*next);
+        return next;
+    }
+
+private:
+    static void findLive(Chunk& chunk) {
+        chunk.live.clear();
+        for (size_t i = 0; i < chunk.slots.size(); i++) {
+            if (!chunk.slots[i].deleted) {
+                chunk.live.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    std::vector<ChunkPtr> parts;
+    // Live records in chunks 0 to i, for operator[].
+    std::vector<size_t> ends;
+};
+
+template<typename Record>
+const size_t ChunkedRecords<Record>::ChunkSlots;
\ No newline at end of file
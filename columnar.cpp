@@ -0,0 +1,323 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "columnar.h"
+#include "calendar.h"
+#include "file_utils.h"
+#include "exceptions.h"
+#include "trace.h"
+#include <cstdio>
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <unordered_map>
+
+namespace columnar {
+    namespace {
+        const int32_t Null = INT32_MIN;
+        const size_t BufferSize = 1 << 20;
+
+        void appendJsonString(std::string& out, const std::string& text) {
+            out += '"';
+            for (char c : text) {
+                unsigned char u = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                }
+                else if (u < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", u);
+                    out += escaped;
+                }
+                else {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+
+        // Buffered little-endian writer that knows its file position.
+        class Output {
+        public:
+            explicit Output(FILE* file) : file(file) { buffer.reserve(BufferSize); }
+
+            void bytes(const char* data, size_t length) {
+                if (buffer.size() + length > BufferSize) flush();
+                buffer.insert(buffer.end(), data, data + length);
+                position += length;
+            }
+            void byte(uint8_t value) {
+                char c = static_cast<char>(value);
+                bytes(&c, 1);
+            }
+            void uint32(uint32_t value) {
+                char b[4] = { static_cast<char>(value), static_cast<char>(value >> 8),
+                    static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+                bytes(b, 4);
+            }
+            void int32(int32_t value) { uint32(static_cast<uint32_t>(value)); }
+            void align() {
+                while (position % 8 != 0) byte(0);
+            }
+            void flush() {
+                if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+                    failed = true;
+                }
+                buffer.clear();
+            }
+
+            uint64_t position = 0;
+            bool failed = false;
+
+        private:
+            FILE* file;
+            std::vector<char> buffer;
+        };
+
+        // Writes the columns of one table and describes them in the footer.
+        // Each column is given as a function that calls its argument once
+        // per row with the row's value, so values go straight from the
+        // snapshot into the output buffer.
+        class Table {
+        public:
+            Table(Output& out, std::string& footer, const char* name, size_t rows)
+                : out(out), footer(footer), rows(rows) {
+                if (footer.back() != '[') footer += ',';
+                footer += "{\"name\":";
+                appendJsonString(footer, name);
+                footer += ",\"rows\":" + std::to_string(rows) + ",\"columns\":[";
+            }
+            ~Table() { footer += "]}"; }
+
+            // type is "int32", "date" or "time"; Null values are counted
+            // and left out of min and max.
+            template<typename Each>
+            void integers(const char* name, const char* type, Each each) {
+                begin(name, type);
+                int32_t min = INT32_MAX, max = INT32_MIN;
+                size_t nulls = 0;
+                each([&](int32_t value) {
+                    out.int32(value);
+                    if (value == Null) {
+                        nulls++;
+                    }
+                    else {
+                        if (value < min) min = value;
+                        if (value > max) max = value;
+                    }
+                });
+                footer += ",\"offset\":" + std::to_string(start);
+                statistics(nulls < rows ? std::to_string(min) : "null", nulls < rows ? std::to_string(max) : "null", nulls);
+            }
+
+            template<typename Each>
+            void booleans(const char* name, Each each) {
+                begin(name, "bool");
+                bool any[2] = { false, false };
+                each([&](bool value) {
+                    out.byte(value ? 1 : 0);
+                    any[value ? 1 : 0] = true;
+                });
+                footer += ",\"offset\":" + std::to_string(start);
+                statistics(rows ? (any[0] ? "0" : "1") : "null", rows ? (any[1] ? "1" : "0") : "null", 0);
+            }
+
+            // Offsets first, then the bytes: two passes over the rows.
+            template<typename Each>
+            void strings(const char* name, Each each) {
+                begin(name, "string");
+                uint32_t end = 0;
+                out.uint32(0);
+                const std::string* min = nullptr;
+                const std::string* max = nullptr;
+                each([&](const std::string& value) {
+                    end += static_cast<uint32_t>(value.size());
+                    out.uint32(end);
+                    if (!min || value < *min) min = &value;
+                    if (!max || *max < value) max = &value;
+                });
+                uint64_t data = out.position;
+                each([&](const std::string& value) {
+                    out.bytes(value.data(), value.size());
+                });
+                footer += ",\"offsets\":" + std::to_string(start) + ",\"data\":" + std::to_string(data) +
+                    ",\"bytes\":" + std::to_string(end);
+                statistics(min ? json(*min) : "null", max ? json(*max) : "null", 0);
+            }
+
+            // Codes are assigned in order of first appearance.
+            template<typename Each>
+            void dictionary(const char* name, Each each) {
+                begin(name, "dictionary");
+                std::unordered_map<std::string, uint32_t> codes;
+                std::vector<std::string> values;
+                each([&](const std::string& value) {
+                    auto it = codes.find(value);
+                    if (it == codes.end()) {
+                        it = codes.emplace(value, static_cast<uint32_t>(values.size())).first;
+                        values.push_back(value);
+                    }
+                    out.uint32(it->second);
+                });
+                footer += ",\"offset\":" + std::to_string(start) + ",\"values\":[";
+                const std::string* min = nullptr;
+                const std::string* max = nullptr;
+                for (size_t i = 0; i < values.size(); i++) {
+                    if (i > 0) footer += ',';
+                    appendJsonString(footer, values[i]);
+                    if (!min || values[i] < *min) min = &values[i];
+                    if (!max || *max < values[i]) max = &values[i];
+                }
+                footer += ']';
+                statistics(min ? json(*min) : "null", max ? json(*max) : "null", 0);
+            }
+
+        private:
+            void begin(const char* name, const char* type) {
+                out.align();
+                start = out.position;
+                if (footer.back() != '[') footer += ',';
+                footer += "{\"name\":";
+                appendJsonString(footer, name);
+                footer += ",\"type\":";
+                appendJsonString(footer, type);
+            }
+            void statistics(const std::string& min, const std::string& max, size_t nulls) {
+                footer += ",\"min\":" + min + ",\"max\":" + max + ",\"nulls\":" + std::to_string(nulls) + "}";
+            }
+            static std::string json(const std::string& text) {
+                std::string out;
+                appendJsonString(out, text);
+                return out;
+            }
+
+            Output& out;
+            std::string& footer;
+            size_t rows;
+            uint64_t start = 0;
+        };
+
+        int32_t dateValue(const std::string& date) {
+            long days;
+            return calendar::parseDate(date, days) ? static_cast<int32_t>(days) : Null;
+        }
+
+        int32_t timeValue(const std::string& time) {
+            int minutes;
+            return calendar::parseTime(time, minutes) ? minutes : Null;
+        }
+    }
+
+    size_t write(const Snapshot& view, const std::string& path) {
+        trace::Span span("columnar::write");
+        const Snapshot::Owners& owners = *view.owners;
+        const Snapshot::Appointments& appointments = *view.appointments;
+
+        // Ids are row numbers. Names resolve like loadData does: the first
+        // owner with a name wins.
+        std::unordered_map<std::string, int32_t> ownerIds;
+        std::vector<int32_t> firstPetId(owners.size());
+        int32_t petCount = 0;
+        for (size_t i = 0; i < owners.size(); i++) {
+            ownerIds.emplace(owners[i].name, static_cast<int32_t>(i));
+            firstPetId[i] = petCount;
+            petCount += static_cast<int32_t>(owners[i].pets.size());
+        }
+        std::vector<int32_t> apptOwner(appointments.size(), -1), apptPet(appointments.size(), -1);
+        for (size_t i = 0; i < appointments.size(); i++) {
+            auto owner = ownerIds.find(appointments[i].ownerName);
+            if (owner == ownerIds.end()) continue;
+            apptOwner[i] = owner->second;
+            const std::vector<Pet>& pets = owners[owner->second].pets;
+            for (size_t p = 0; p < pets.size(); p++) {
+                if (pets[p].name == appointments[i].petName) {
+                    apptPet[i] = firstPetId[owner->second] + static_cast<int32_t>(p);
+                    break;
+                }
+            }
+        }
+
+        std::string tmpPath = path + ".tmp";
+        FILE* file = fopen(tmpPath.c_str(), "wb");
+        if (!file) {
+            throw FileWriteException(tmpPath);
+        }
+        Output out(file);
+        out.bytes("VCOL1\0\0\0", 8);
+        std::string footer = "{\"version\":1,\"tables\":[";
+
+        {
+            Table table(out, footer, "owners", owners.size());
+            table.integers("id", "int32", [&](auto visit) {
+                for (size_t i = 0; i < owners.size(); i++) visit(static_cast<int32_t>(i));
+            });
+            table.strings("name", [&](auto visit) {
+                for (const auto& owner : owners) visit(owner.name);
+            });
+            table.integers("age", "int32", [&](auto visit) {
+                for (const auto& owner : owners) visit(static_cast<int32_t>(owner.age));
+            });
+            table.integers("registered", "date", [&](auto visit) {
+                for (const auto& owner : owners) visit(owner.registered.empty() ? Null : dateValue(owner.registered));
+            });
+        }
+        {
+            Table table(out, footer, "pets", static_cast<size_t>(petCount));
+            table.integers("id", "int32", [&](auto visit) {
+                for (int32_t i = 0; i < petCount; i++) visit(i);
+            });
+            table.integers("owner_id", "int32", [&](auto visit) {
+                for (size_t i = 0; i < owners.size(); i++) {
+                    for (size_t p = 0; p < owners[i].pets.size(); p++) visit(static_cast<int32_t>(i));
+                }
+            });
+            table.strings("name", [&](auto visit) {
+                for (const auto& owner : owners) for (const auto& pet : owner.pets) visit(pet.name);
+            });
+            table.dictionary("breed", [&](auto visit) {
+                for (const auto& owner : owners) for (const auto& pet : owner.pets) visit(pet.breed);
+            });
+            table.integers("age", "int32", [&](auto visit) {
+                for (const auto& owner : owners) for (const auto& pet : owner.pets) visit(static_cast<int32_t>(pet.age));
+            });
+            table.booleans("vaccinated", [&](auto visit) {
+                for (const auto& owner : owners) for (const auto& pet : owner.pets) visit(pet.vaccinated);
+            });
+        }
+        {
+            Table table(out, footer, "appointments", appointments.size());
+            table.integers("id", "int32", [&](auto visit) {
+                for (size_t i = 0; i < appointments.size(); i++) visit(static_cast<int32_t>(i));
+            });
+            table.integers("owner_id", "int32", [&](auto visit) {
+                for (int32_t id : apptOwner) visit(id);
+            });
+            table.integers("pet_id", "int32", [&](auto visit) {
+                for (int32_t id : apptPet) visit(id);
+            });
+            table.integers("date", "date", [&](auto visit) {
+                for (const auto& appt : appointments) visit(dateValue(appt.date));
+            });
+            table.integers("time", "time", [&](auto visit) {
+                for (const auto& appt : appointments) visit(timeValue(appt.time));
+            });
+            table.dictionary("status", [&](auto visit) {
+                for (const auto& appt : appointments) visit(appt.status);
+            });
+        }
+        footer += "]}";
+
+        out.align();
+        out.bytes(footer.data(), footer.size());
+        out.uint32(static_cast<uint32_t>(footer.size()));
+        out.bytes("VCOL", 4);
+        out.flush();
+        bool ok = !out.failed && file_utils::sync(file);
+        ok = fclose(file) == 0 && ok;
+        if (!ok || !file_utils::replaceFile(tmpPath, path)) {
+            remove(tmpPath.c_str());
+            throw FileWriteException(path);
+        }
+        return static_cast<size_t>(out.position);
+    }
+}
\ No newline at end of file
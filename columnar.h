@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include "snapshot.h"
+
+// Typed, column-oriented export of a snapshot for analysis tools.
+//
+// The file holds the owners, pets and appointments tables. Each column is
+// one contiguous little-endian array, 8-byte aligned, so a reader can map
+// it straight into an array type:
+//   int32      - 4-byte signed integers; null is -2147483648
+//   bool       - 1 byte, 0 or 1
+//   date       - int32 days since 1970-01-01
+//   time       - int32 minutes after midnight
+//   string     - uint32 offsets (rows + 1), then the UTF-8 bytes
+//   dictionary - uint32 codes into the column's "values" list
+// Rows refer to each other by id (the row number in the referenced
+// table); owner_id and pet_id are -1 if the record was not found.
+//
+// The data is followed by a JSON footer describing every table and column
+// (type, byte offsets, min, max and null count), then the footer length as
+// a uint32 and the magic "VCOL". The file also starts with "VCOL1\0\0\0".
+namespace columnar {
+    // Writes view to path (replaced in one step when complete). Returns
+    // the number of bytes written. Throws FileWriteException.
+    size_t write(const Snapshot& view, const std::string& path);
+}
\ No newline at end of file
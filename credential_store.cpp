@@ -0,0 +1,120 @@
+#include "credential_store.h"
+#include "exceptions.h"
+#include "security.h"
+#include <fstream>
+#include <sys/stat.h>
+
+namespace {
+    // Verified against when the username is unknown so that unknown and
+    // known users take the same time to reject.
+    const std::string& dummyHash() {
+        static const std::string hash = security::hashPassword("dummy-password");
+        return hash;
+    }
+
+    bool modificationTime(const std::string& filename, time_t& modified) {
+        struct stat info;
+        if (stat(filename.c_str(), &info) != 0) {
+            return false;
+        }
+        modified = info.st_mtime;
+        return true;
+    }
+}
+
+const CredentialStore::RoleEntry& CredentialStore::currentRole(const std::string& role) {
+    std::string filename = role + ".txt";
+    time_t modified = 0;
+    if (!modificationTime(filename, modified)) {
+        throw FileAccessException(filename);
+    }
+
+    auto it = roles.find(role);
+    if (it != roles.end() && it->second.modified == modified) {
+        return it->second;
+    }
+
+    std::ifstream infile(filename);
+    if (!infile) {
+        throw FileAccessException(filename);
+    }
+    std::string stored;
+    std::getline(infile, stored);
+    infile.close();
+
+    // Migrate plain-text role files to the salted hash format.
+    if (!security::isPasswordHash(stored)) {
+        stored = security::hashPassword(stored);
+        std::ofstream outfile(filename);
+        if (outfile) {
+            outfile << stored;
+            outfile.close();
+            modificationTime(filename, modified);
+        }
+    }
+
+    RoleEntry& entry = roles[role];
+    entry.passwordHash = stored;
+    entry.modified = modified;
+    return entry;
+}
+
+bool CredentialStore::verifyStaff(const std::string& role, const std::string& password) {
+    std::string stored;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stored = currentRole(role).passwordHash;
+    }
+    return security::verifyPassword(password, stored);
+}
+
+bool CredentialStore::verifyCustomer(const std::string& name, const std::string& password) const {
+    std::string stored;
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = customers.find(name);
+        if (it != customers.end()) {
+            stored = it->second;
+            known = true;
+        }
+    }
+    if (!known) {
+        security::verifyPassword(password, dummyHash());
+        return false;
+    }
+    return security::verifyPassword(password, stored);
+}
+
+void CredentialStore::setCustomer(const std::string& name, const std::string& passwordHash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    customers[name] = passwordHash;
+}
+
+void CredentialStore::removeCustomer(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    customers.erase(name);
+}
+
+void CredentialStore::rebuildCustomers(const std::vector<Owner>& owners) {
+    std::lock_guard<std::mutex> lock(mutex);
+    customers.clear();
+    customers.reserve(owners.size());
+    for (const auto& owner : owners) {
+        customers[owner.name] = owner.password;
+    }
+}
+
+void CredentialStore::rebuildCustomers(const std::vector<std::pair<std::string, std::string>>& namesAndHashes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    customers.clear();
+    customers.reserve(namesAndHashes.size());
+    for (const auto& entry : namesAndHashes) {
+        customers[entry.first] = entry.second;
+    }
+}
+
+bool CredentialStore::hasCustomer(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return customers.find(name) != customers.end();
+}
\ No newline at end of file
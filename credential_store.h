@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+#include <utility>
+#include "owner.h"
+
+// Keeps staff and customer credentials in memory, keyed by username, so a
+// login is a hash lookup plus one password hash instead of file reads or
+// a scan over every owner. Staff role files (<role>.txt) are re-read only
+// when their modification time changes.
+class CredentialStore {
+public:
+    // Throws FileAccessException if the role file does not exist.
+    bool verifyStaff(const std::string& role, const std::string& password);
+    bool verifyCustomer(const std::string& name, const std::string& password) const;
+
+    void setCustomer(const std::string& name, const std::string& passwordHash);
+    void removeCustomer(const std::string& name);
+    void rebuildCustomers(const std::vector<Owner>& owners);
+    // From (name, password hash) pairs; a later pair for a name wins, as
+    // for owners.
+    void rebuildCustomers(const std::vector<std::pair<std::string, std::string>>& namesAndHashes);
+    bool hasCustomer(const std::string& name) const;
+
+private:
+    struct RoleEntry {
+        std::string passwordHash;
+        time_t modified = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, RoleEntry> roles;
+    std::unordered_map<std::string, std::string> customers;
+
+    const RoleEntry& currentRole(const std::string& role);
+};
\ No newline at end of file
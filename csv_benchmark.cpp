@@ -0,0 +1,203 @@
+#include "csv_benchmark.h"
+#include "csv_utils.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace csv_benchmark {
+    namespace {
+        struct DataSet {
+            const char* name;
+            std::vector<std::string> fields;
+            size_t bytes = 0;
+        };
+
+        // Fields built from words; every quoteEvery-th word is quoted,
+        // every commaEvery-th is followed by a comma and every
+        // newlineEvery-th starts a new line (0 = never).
+        DataSet makeDataSet(const char* name, size_t totalBytes, size_t fieldWords,
+            int commaEvery, int quoteEvery, int newlineEvery) {
+            static const char* const words[] = { "rex", "vaccinated", "booster", "weight", "ear",
+                "follow", "up", "in", "two", "weeks", "antibiotics", "teeth", "allergy", "prescribed" };
+            std::mt19937 random(42);
+            DataSet data;
+            data.name = name;
+            while (data.bytes < totalBytes) {
+                std::string field;
+                for (size_t w = 0; w < fieldWords; w++) {
+                    if (w > 0) field += newlineEvery > 0 && random() % newlineEvery == 0 ? '\n' : ' ';
+                    const char* word = words[random() % (sizeof(words) / sizeof(words[0]))];
+                    bool quoted = quoteEvery > 0 && random() % quoteEvery == 0;
+                    if (quoted) field += '"';
+                    field += word;
+                    if (quoted) field += '"';
+                    if (commaEvery > 0 && random() % commaEvery == 0) field += ',';
+                }
+                data.bytes += field.size();
+                data.fields.push_back(field);
+            }
+            return data;
+        }
+
+        // csv_utils::escapeCSV as it was before CsvWriter: copy, three
+        // finds, one insert per quote and a final concatenation.
+        std::string legacyEscape(const std::string& field) {
+            std::string result = field;
+            if (field.find(',') != std::string::npos ||
+                field.find('\"') != std::string::npos ||
+                field.find('\n') != std::string::npos) {
+                size_t pos = 0;
+                while ((pos = result.find('\"', pos)) != std::string::npos) {
+                    result.insert(pos, 1, '\"');
+                    pos += 2;
+                }
+                result = '\"' + result + '\"';
+            }
+            return result;
+        }
+
+        // The fields split the way loadData reads a line before
+        // CsvReader: at every comma, quoted or not.
+        size_t legacySplit(const std::string& contents) {
+            std::istringstream in(contents);
+            std::string line, field;
+            size_t fields = 0;
+            while (std::getline(in, line)) {
+                std::istringstream ss(line);
+                while (std::getline(ss, field, ',')) {
+                    fields += csv_utils::unescapeCSV(field).size() > 0 ? 1 : 0;
+                }
+            }
+            return fields;
+        }
+
+        // Reads contents back and counts the fields that differ from data,
+        // plus any that are missing or extra.
+        size_t roundTripErrors(const DataSet& data, const std::string& contents) {
+            csv_utils::CsvReader reader(contents.data(), contents.size());
+            std::vector<csv_utils::CsvField> record;
+            size_t next = 0, errors = 0;
+            while (reader.next(record)) {
+                for (const auto& field : record) {
+                    if (next >= data.fields.size() || field.value() != data.fields[next]) {
+                        errors++;
+                    }
+                    next++;
+                }
+            }
+            return errors + (next < data.fields.size() ? data.fields.size() - next : 0);
+        }
+
+        // Repeats encode until at least half a second has passed and
+        // returns GB/s of input.
+        template<typename Encode>
+        double measure(const DataSet& data, Encode encode) {
+            typedef std::chrono::steady_clock Clock;
+            size_t rounds = 0;
+            Clock::time_point start = Clock::now();
+            double seconds = 0;
+            do {
+                encode();
+                rounds++;
+                seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            } while (seconds < 0.5);
+            return static_cast<double>(data.bytes) * rounds / seconds / 1e9;
+        }
+    }
+
+    bool run(std::ostream& out, size_t megabytes) {
+        size_t bytes = (megabytes == 0 ? 1 : megabytes) << 20;
+        std::vector<DataSet> sets;
+        sets.push_back(makeDataSet("names (2 words)", bytes, 2, 0, 0, 0));
+        sets.push_back(makeDataSet("medical histories (300 words)", bytes, 300, 40, 0, 50));
+        sets.push_back(makeDataSet("quote-heavy (20 words)", bytes, 20, 4, 3, 0));
+
+        bool simdAvailable = csv_utils::simdEnabled();
+        std::ios::fmtflags flags = out.flags();
+        out << "\n--- CSV Encoder Throughput (GB/s of input) ---\n";
+        out << std::left << std::setw(32) << "Data set" << std::right << std::setw(10) << "SSE2"
+            << std::setw(10) << "Scalar" << std::setw(10) << "Legacy" << "\n";
+        out << std::fixed << std::setprecision(2);
+        for (const auto& data : sets) {
+            csv_utils::CsvWriter writer;
+            auto encode = [&data, &writer]() {
+                writer.clear();
+                for (size_t i = 0; i < data.fields.size(); i++) {
+                    writer.field(data.fields[i]);
+                    if (i % 6 == 5) writer.endRow();
+                }
+            };
+
+            out << std::left << std::setw(32) << data.name << std::right;
+            if (simdAvailable) {
+                csv_utils::setSimdEnabled(true);
+                out << std::setw(10) << measure(data, encode);
+            }
+            else {
+                out << std::setw(10) << "n/a";
+            }
+            csv_utils::setSimdEnabled(false);
+            out << std::setw(10) << measure(data, encode);
+            csv_utils::setSimdEnabled(simdAvailable);
+
+            std::string contents;
+            out << std::setw(10) << measure(data, [&data, &contents]() {
+                contents.clear();
+                for (size_t i = 0; i < data.fields.size(); i++) {
+                    contents += legacyEscape(data.fields[i]);
+                    contents += i % 6 == 5 ? '\n' : ',';
+                }
+            }) << "\n";
+        }
+
+        // The same fields read back: CsvReader with either classifier, and
+        // the getline split it replaced (which also breaks quoted commas
+        // and newlines apart). Every field must come back unchanged.
+        out << "\n--- CSV Tokenizer Throughput (GB/s of input) ---\n";
+        out << std::left << std::setw(32) << "Data set" << std::right << std::setw(10) << "SSE2"
+            << std::setw(10) << "Scalar" << std::setw(10) << "Legacy" << "  Round trip\n";
+        bool allEqual = true;
+        for (const auto& data : sets) {
+            csv_utils::CsvWriter writer;
+            for (size_t i = 0; i < data.fields.size(); i++) {
+                writer.field(data.fields[i]);
+                if (i % 6 == 5) writer.endRow();
+            }
+            writer.endRow();
+            std::string contents = writer.text();
+            std::vector<csv_utils::CsvField> record;
+            size_t fields = 0;
+            auto tokenize = [&contents, &record, &fields]() {
+                csv_utils::CsvReader reader(contents.data(), contents.size());
+                while (reader.next(record)) {
+                    fields += record.size();
+                }
+            };
+
+            out << std::left << std::setw(32) << data.name << std::right;
+            size_t errors = 0;
+            if (simdAvailable) {
+                csv_utils::setSimdEnabled(true);
+                out << std::setw(10) << measure(data, tokenize);
+                errors += roundTripErrors(data, contents);
+            }
+            else {
+                out << std::setw(10) << "n/a";
+            }
+            csv_utils::setSimdEnabled(false);
+            out << std::setw(10) << measure(data, tokenize);
+            errors += roundTripErrors(data, contents);
+            csv_utils::setSimdEnabled(simdAvailable);
+            out << std::setw(10) << measure(data, [&contents, &fields]() {
+                fields += legacySplit(contents);
+            });
+            out << "  " << (errors == 0 ? "equal" : std::to_string(errors) + " fields differ") << "\n";
+            allEqual = allEqual && errors == 0;
+        }
+        out.flags(flags);
+        return allEqual;
+    }
+}
\ No newline at end of file
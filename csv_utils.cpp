@@ -1,36 +1,524 @@
-#include "csv_utils.h"
-
-namespace csv_utils {
-    std::string escapeCSV(const std::string& field) {
-        std::string result = field;
-
-        if (field.find(',') != std::string::npos ||
-            field.find('\"') != std::string::npos ||
-            field.find('\n') != std::string::npos) {
-
-            size_t pos = 0;
-            while ((pos = result.find('\"', pos)) != std::string::npos) {
-                result.insert(pos, 1, '\"');
-                pos += 2;
-            }
-
-            result = '\"' + result + '\"';
-        }
-        return result;
-    }
-
-    std::string unescapeCSV(const std::string& field) {
-        std::string result = field;
-
-        if (result.size() >= 2 && result.front() == '\"' && result.back() == '\"') {
-            result = result.substr(1, result.size() - 2);
-
-            size_t pos = 0;
-            while ((pos = result.find('\"\"', pos)) != std::string::npos) {
-                result.erase(pos, 1);
-                pos += 1;
-            }
-        }
-        return result;
-    }
+#include "csv_utils.h"
+#include "file_utils.h"
+#include "parallel.h"
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CSV_UTILS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace csv_utils {
+    namespace {
+#if defined(CSV_UTILS_SSE2)
+        std::atomic<bool> useSimd{ true };
+#else
+        std::atomic<bool> useSimd{ false };
+#endif
+
+        // Position of the first ',', '"' or '\n' in field, or length.
+        // Checks eight bytes per step with word arithmetic (a byte of x
+        // is zero where the high bit of the result is set).
+        size_t findSpecialScalar(const char* field, size_t length) {
+            const uint64_t ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+            size_t i = 0;
+            for (; i + 8 <= length; i += 8) {
+                uint64_t word;
+                memcpy(&word, field + i, 8);
+                uint64_t comma = word ^ (ones * ','), quote = word ^ (ones * '"'), newline = word ^ (ones * '\n');
+                uint64_t hits = ((comma - ones) & ~comma) | ((quote - ones) & ~quote) | ((newline - ones) & ~newline);
+                if (hits & highs) break;
+            }
+            for (; i < length; i++) {
+                char c = field[i];
+                if (c == ',' || c == '"' || c == '\n') return i;
+            }
+            return length;
+        }
+
+#if defined(CSV_UTILS_SSE2)
+        inline unsigned lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        // Compares 16 bytes at a time against all three characters at once.
+        size_t findSpecialSse2(const char* field, size_t length) {
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i newline = _mm_set1_epi8('\n');
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field + i));
+                __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, comma),
+                    _mm_cmpeq_epi8(chunk, quote)), _mm_cmpeq_epi8(chunk, newline));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+                if (mask != 0) {
+                    return i + lowestBit(mask);
+                }
+            }
+            return i + findSpecialScalar(field + i, length - i);
+        }
+#endif
+
+        size_t findSpecial(const char* field, size_t length) {
+#if defined(CSV_UTILS_SSE2)
+            if (useSimd.load(std::memory_order_relaxed)) {
+                return findSpecialSse2(field, length);
+            }
+#endif
+            return findSpecialScalar(field, length);
+        }
+
+        // Writes field escaped at out, which has room for 2 * length + 2
+        // bytes, and returns the end. Quotes can only occur from the first
+        // special character on; the runs between them are copied whole.
+        char* escapeInto(char* out, const char* field, size_t length) {
+            size_t special = findSpecial(field, length);
+            if (special == length) {
+                memcpy(out, field, length);
+                return out + length;
+            }
+
+            *out++ = '"';
+            size_t start = 0;
+            const char* quote = static_cast<const char*>(memchr(field + special, '"', length - special));
+            while (quote) {
+                size_t end = static_cast<size_t>(quote - field) + 1;
+                memcpy(out, field + start, end - start);
+                out += end - start;
+                *out++ = '"';
+                start = end;
+                quote = static_cast<const char*>(memchr(field + start, '"', length - start));
+            }
+            memcpy(out, field + start, length - start);
+            out += length - start;
+            *out++ = '"';
+            return out;
+        }
+
+        inline unsigned lowestBit64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+            unsigned long index;
+            if (_BitScanForward(&index, static_cast<unsigned long>(mask))) {
+                return static_cast<unsigned>(index);
+            }
+            _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+            return static_cast<unsigned>(index) + 32;
+#else
+            return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+        }
+
+        // Bit i is set for each character of the 64-byte block at i.
+        struct BlockMasks {
+            uint64_t quotes, commas, newlines;
+        };
+
+        BlockMasks classifyScalar(const char* block) {
+            BlockMasks masks = { 0, 0, 0 };
+            for (unsigned i = 0; i < 64; i++) {
+                uint64_t bit = static_cast<uint64_t>(1) << i;
+                char c = block[i];
+                if (c == '"') masks.quotes |= bit;
+                else if (c == ',') masks.commas |= bit;
+                else if (c == '\n') masks.newlines |= bit;
+            }
+            return masks;
+        }
+
+#if defined(CSV_UTILS_SSE2)
+        BlockMasks classifySse2(const char* block) {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i newline = _mm_set1_epi8('\n');
+            BlockMasks masks = { 0, 0, 0 };
+            for (unsigned i = 0; i < 4; i++) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+                masks.quotes |= static_cast<uint64_t>(static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)))) << (16 * i);
+                masks.commas |= static_cast<uint64_t>(static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, comma)))) << (16 * i);
+                masks.newlines |= static_cast<uint64_t>(static_cast<unsigned>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)))) << (16 * i);
+            }
+            return masks;
+        }
+#endif
+
+        // Bit i of the result is the XOR of bits 0..i: set where an odd
+        // number of quotes has been seen, i.e. inside a quoted field.
+        inline uint64_t prefixXor(uint64_t bits) {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+    }
+
+    std::string escapeCSV(const std::string& field) {
+        std::string result;
+        appendEscaped(result, field.data(), field.size());
+        return result;
+    }
+
+    std::string unescapeCSV(const std::string& field) {
+        CsvField raw = { field.data(), field.size(), 0 };
+        return raw.value();
+    }
+
+    void appendEscaped(std::string& out, const char* field, size_t length) {
+        size_t start = out.size();
+        out.resize(start + 2 * length + 2);
+        char* end = escapeInto(&out[start], field, length);
+        out.resize(static_cast<size_t>(end - out.data()));
+    }
+
+    bool simdEnabled() {
+        return useSimd.load(std::memory_order_relaxed);
+    }
+
+    void setSimdEnabled(bool enabled) {
+#if defined(CSV_UTILS_SSE2)
+        useSimd.store(enabled, std::memory_order_relaxed);
+#else
+        (void)enabled;
+#endif
+    }
+
+    CsvWriter::CsvWriter(FILE* file)
+        : file(file), buffer(new char[BufferSize + 4096]), capacity(BufferSize + 4096) {
+    }
+
+    void CsvWriter::grow(size_t count) {
+        if (used + count > capacity) {
+            size_t grown = capacity * 2 > used + count ? capacity * 2 : used + count;
+            std::unique_ptr<char[]> larger(new char[grown]);
+            memcpy(larger.get(), buffer.get(), used);
+            buffer = std::move(larger);
+            capacity = grown;
+        }
+    }
+
+    char* CsvWriter::reserve(size_t count) {
+        grow(count + 1);  // and the separator
+        char* out = buffer.get() + used;
+        if (!startOfRow) {
+            *out++ = ',';
+        }
+        startOfRow = false;
+        return out;
+    }
+
+    void CsvWriter::field(const char* data, size_t length) {
+        char* out = reserve(2 * length + 2);
+        used = static_cast<size_t>(escapeInto(out, data, length) - buffer.get());
+    }
+
+    void CsvWriter::field(long long value) {
+        char digits[24];
+        size_t count = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+            : static_cast<unsigned long long>(value);
+        do {
+            digits[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+
+        char* out = reserve(count + 1);
+        if (value < 0) {
+            *out++ = '-';
+        }
+        while (count > 0) {
+            *out++ = digits[--count];
+        }
+        used = static_cast<size_t>(out - buffer.get());
+    }
+
+    void CsvWriter::endRow() {
+        grow(1);
+        buffer[used++] = '\n';
+        startOfRow = true;
+        if (file && used >= BufferSize) {
+            flush();
+        }
+    }
+
+    bool CsvWriter::flush() {
+        if (file && used > 0) {
+            checksum = file_utils::crc32(buffer.get(), used, checksum);
+            if (fwrite(buffer.get(), 1, used, file) != used) {
+                failed = true;
+            }
+            flushed += used;
+            used = 0;
+        }
+        return !failed;
+    }
+
+    void CsvWriter::clear() {
+        used = 0;
+        flushed = 0;
+        checksum = 0;
+        startOfRow = true;
+        failed = false;
+    }
+
+    std::string CsvField::value() const {
+        if (length < 2 || data[0] != '"' || data[length - 1] != '"') {
+            return std::string(data, length);
+        }
+        const char* next = data + 1;
+        const char* last = data + length - 1;
+        const char* quote = static_cast<const char*>(memchr(next, '"', static_cast<size_t>(last - next)));
+        if (!quote) {
+            // Built at its exact size, so moving it into a record does
+            // not carry spare capacity along.
+            return std::string(next, last);
+        }
+        std::string result;
+        result.reserve(length - 2);
+        while (quote) {
+            result.append(next, quote + 1);
+            next = quote + 2;  // past the second quote of the pair
+            quote = next < last ? static_cast<const char*>(memchr(next, '"', static_cast<size_t>(last - next))) : nullptr;
+        }
+        if (next < last) {
+            result.append(next, last);
+        }
+        return result;
+    }
+
+    std::string fieldValue(const std::vector<CsvField>& fields, size_t index) {
+        return index < fields.size() ? fields[index].value() : std::string();
+    }
+
+    CsvReader::CsvReader(const std::string& path)
+        : CsvReader(path, 0, UINT64_MAX) {
+    }
+
+    CsvReader::CsvReader(const std::string& path, uint64_t from, uint64_t to)
+        : file(fopen(path.c_str(), "rb")), dataOffset(from), remaining(to > from ? to - from : 0) {
+        if (file && from > 0 && !file_utils::seek(file, from)) {
+            fclose(file);
+            file = nullptr;
+        }
+        open = file != nullptr;
+        atEnd = !open;
+    }
+
+    CsvReader::CsvReader(const char* text, size_t length)
+        : open(true), atEnd(true), data(text), end(length) {
+    }
+
+    CsvReader::~CsvReader() {
+        if (file) {
+            fclose(file);
+        }
+    }
+
+    // Moves the unread text to the front of the buffer and reads up to the
+    // buffer's end, growing it if one record has filled most of it.
+    void CsvReader::fill() {
+        if (begin > 0) {
+            memmove(storage.data(), storage.data() + begin, end - begin);
+            dataOffset += begin;
+            end -= begin;
+            scanned -= begin;
+            begin = 0;
+        }
+        if (storage.size() < end + ChunkSize) {
+            storage.resize(end + ChunkSize);
+        }
+        size_t wanted = storage.size() - end;
+        if (wanted > remaining) {
+            wanted = static_cast<size_t>(remaining);
+        }
+        size_t count = fread(storage.data() + end, 1, wanted, file);
+        end += count;
+        remaining -= count;
+        atEnd = count < wanted || remaining == 0;
+        data = storage.data();
+    }
+
+    // Finds the boundaries in a window from begin: ChunkSize bytes, or
+    // twice the last window if a single record did not fit in it.
+    void CsvReader::scan() {
+        size_t window = 2 * (scanned - begin);
+        if (window < ChunkSize) {
+            window = ChunkSize;
+        }
+        size_t limit = end - begin > window ? begin + window : end;
+        boundaries.clear();
+        nextBoundary = 0;
+#if defined(CSV_UTILS_SSE2)
+        bool simd = useSimd.load(std::memory_order_relaxed);
+#endif
+
+        uint64_t inQuotes = 0;  // all ones if the last block ended inside quotes
+        for (size_t base = begin; base < limit; base += 64) {
+            const char* block = data + base;
+            char padded[64];
+            if (limit - base < 64) {
+                memset(padded, 0, sizeof(padded));
+                memcpy(padded, block, limit - base);
+                block = padded;
+            }
+#if defined(CSV_UTILS_SSE2)
+            BlockMasks masks = simd ? classifySse2(block) : classifyScalar(block);
+#else
+            BlockMasks masks = classifyScalar(block);
+#endif
+            uint64_t quoted = prefixXor(masks.quotes) ^ inQuotes;
+            inQuotes = static_cast<uint64_t>(0) - (quoted >> 63);
+            uint64_t separators = (masks.commas | masks.newlines) & ~quoted;
+            while (separators != 0) {
+                unsigned bit = lowestBit64(separators);
+                boundaries.push_back((base + bit) * 2 + ((masks.newlines >> bit) & 1));
+                separators &= separators - 1;
+            }
+        }
+        scanned = limit;
+    }
+
+    bool CsvReader::next(std::vector<CsvField>& fields) {
+        for (;;) {
+            fields.clear();
+            size_t start = begin;
+            bool complete = false;
+            while (nextBoundary < boundaries.size()) {
+                size_t boundary = boundaries[nextBoundary++];
+                size_t position = boundary / 2;
+                CsvField field = { data + start, position - start, dataOffset + start };
+                fields.push_back(field);
+                start = position + 1;
+                if (boundary & 1) {
+                    complete = true;
+                    break;
+                }
+            }
+
+            if (!complete) {
+                // The record runs past what has been scanned.
+                if (scanned < end) {
+                    scan();
+                    continue;
+                }
+                if (!atEnd) {
+                    fill();
+                    scan();
+                    continue;
+                }
+                if (begin == end) {
+                    return false;
+                }
+                CsvField field = { data + start, end - start, dataOffset + start };
+                fields.push_back(field);
+                start = end;
+            }
+            begin = start;
+
+            CsvField& last = fields.back();
+            if (last.length > 0 && last.data[last.length - 1] == '\r') {
+                last.length--;
+            }
+            if (fields.size() > 1 || last.length > 0) {
+                return true;
+            }
+        }
+    }
+
+    std::vector<uint64_t> splitRecords(const std::string& path, size_t parts) {
+        uint64_t size;
+        if (!file_utils::fileSize(path, size)) {
+            return std::vector<uint64_t>();
+        }
+        if (parts == 0) {
+            parts = 1;
+        }
+        std::vector<uint64_t> starts(parts + 1);
+        for (size_t i = 0; i <= parts; i++) {
+            starts[i] = size / parts * i + (i == parts ? size % parts : 0);
+        }
+
+        // Quote parity of each piece as first cut.
+        std::vector<char> odd(parts, 0);
+        std::atomic<bool> failed{ false };
+        parallel::forEach(parts, [&](size_t i) {
+            FILE* file = fopen(path.c_str(), "rb");
+            if (!file || !file_utils::seek(file, starts[i])) {
+                failed = true;
+                if (file) fclose(file);
+                return;
+            }
+            std::vector<char> buffer(CsvReader::ChunkSize);
+            uint64_t left = starts[i + 1] - starts[i];
+            size_t quotes = 0;
+            while (left > 0) {
+                size_t wanted = left < buffer.size() ? static_cast<size_t>(left) : buffer.size();
+                size_t count = fread(buffer.data(), 1, wanted, file);
+                quotes += static_cast<size_t>(std::count(buffer.data(), buffer.data() + count, '"'));
+                left -= count;
+                if (count < wanted) break;
+            }
+            fclose(file);
+            odd[i] = static_cast<char>(quotes & 1);
+        });
+        if (failed) {
+            return std::vector<uint64_t>();
+        }
+
+        // Move each cut to just after the first newline outside quotes.
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return std::vector<uint64_t>();
+        }
+        bool inQuotes = false;
+        char buffer[4096];
+        for (size_t i = 1; i < parts; i++) {
+            inQuotes = inQuotes != (odd[i - 1] != 0);
+            uint64_t position = starts[i];
+            bool quoted = inQuotes;
+            bool found = false;
+            if (position < starts[i - 1]) {
+                position = starts[i - 1];  // the previous cut moved past this one
+            }
+            else if (file_utils::seek(file, position)) {
+                size_t count;
+                while (!found && (count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                    for (size_t j = 0; j < count; j++) {
+                        if (buffer[j] == '"') {
+                            quoted = !quoted;
+                        }
+                        else if (buffer[j] == '\n' && !quoted) {
+                            position += j + 1;
+                            found = true;
+                            break;
+                        }
+                    }
+                    if (!found) position += count;
+                }
+            }
+            starts[i] = position < size ? position : size;
+        }
+        fclose(file);
+        return starts;
+    }
 }
\ No newline at end of file
@@ -1,7 +1,137 @@
-#pragma once
-#include <string>
-
-namespace csv_utils {
-    std::string escapeCSV(const std::string& field);
-    std::string unescapeCSV(const std::string& field);
+#pragma once
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace csv_utils {
+    std::string escapeCSV(const std::string& field);
+    std::string unescapeCSV(const std::string& field);
+
+    // Appends field to out, quoted (with quotes doubled) if it contains a
+    // comma, quote or newline. Scans the field once.
+    void appendEscaped(std::string& out, const char* field, size_t length);
+
+    // True if fields are scanned with SSE2 (16 bytes at a time when
+    // writing, 64 when reading). The scalar scanners can be forced for
+    // comparison (see csv_benchmark.h).
+    bool simdEnabled();
+    void setSimdEnabled(bool enabled);
+
+    // Writes CSV rows field by field straight into one reusable buffer.
+    // With a file, the buffer is written out in BufferSize chunks and the
+    // size and CRC-32 of everything written are kept; without one, rows
+    // accumulate until clear().
+    class CsvWriter {
+    public:
+        static const size_t BufferSize = 1 << 20;
+
+        explicit CsvWriter(FILE* file = nullptr);
+        CsvWriter(const CsvWriter&) = delete;
+        CsvWriter& operator=(const CsvWriter&) = delete;
+
+        void field(const char* data, size_t length);
+        void field(const std::string& value) { field(value.data(), value.size()); }
+        void field(long long value);
+        void endRow();
+
+        // Bytes written so far, including those still in the buffer.
+        uint64_t position() const { return flushed + used; }
+        // Writes out the buffer; false if any write to the file failed.
+        bool flush();
+        // CRC-32 of the bytes flushed so far.
+        uint32_t crc() const { return checksum; }
+        // What is in the buffer (everything, when there is no file).
+        std::string text() const { return std::string(buffer.get(), used); }
+        void clear();
+
+    private:
+        void grow(size_t count);
+        // Makes room for count more bytes and returns where they go,
+        // after the separating comma if the row already has a field.
+        char* reserve(size_t count);
+
+        FILE* file;
+        std::unique_ptr<char[]> buffer;
+        size_t used = 0, capacity = 0;
+        uint64_t flushed = 0;
+        uint32_t checksum = 0;
+        bool startOfRow = true;
+        bool failed = false;
+    };
+
+    // One field of a record as it appears in the text (still quoted).
+    struct CsvField {
+        const char* data;
+        size_t length;
+        uint64_t offset;  // from the start of the file
+
+        // The field's value: surrounding quotes removed, "" turned into ".
+        std::string value() const;
+    };
+
+    // Value of fields[index], or "" if the record is shorter.
+    std::string fieldValue(const std::vector<CsvField>& fields, size_t index);
+
+    // Splits CSV text into records. Quoted fields may contain commas,
+    // doubled quotes and newlines; a '\r' before a record's newline is
+    // dropped and empty lines are skipped.
+    //
+    // The text is classified 64 bytes at a time (with SSE2 when enabled):
+    // one pass builds bit masks of the block's quotes, commas and newlines,
+    // and a prefix XOR of the quote mask marks the bytes inside quotes (a
+    // doubled quote toggles twice, leaving the state unchanged). Commas and
+    // newlines outside quotes are the field and record boundaries. Files
+    // are read ChunkSize bytes at a time; a record cut by the end of a chunk
+    // is scanned again from its start once the rest has been read.
+    class CsvReader {
+    public:
+        static const size_t ChunkSize = 1 << 20;
+
+        // Reads the file at path; see isOpen().
+        explicit CsvReader(const std::string& path);
+        // Reads bytes [from, to) of the file, which must start at a record
+        // (see splitRecords). Field offsets are still from the file's start.
+        CsvReader(const std::string& path, uint64_t from, uint64_t to);
+        // Reads text held by the caller, which must outlive the reader.
+        CsvReader(const char* text, size_t length);
+        ~CsvReader();
+        CsvReader(const CsvReader&) = delete;
+        CsvReader& operator=(const CsvReader&) = delete;
+
+        bool isOpen() const { return open; }
+
+        // Reads the next record into fields, whose data stays valid until
+        // the next call. Returns false at the end of the text.
+        bool next(std::vector<CsvField>& fields);
+
+    private:
+        void fill();
+        void scan();
+
+        FILE* file = nullptr;
+        bool open = false;
+        bool atEnd = false;
+        std::vector<char> storage;
+        const char* data = nullptr;
+        // data[begin, end) has not been returned yet; boundaries covers
+        // data[begin, scanned).
+        size_t begin = 0, end = 0, scanned = 0;
+        uint64_t dataOffset = 0;  // file offset of data[0]
+        uint64_t remaining = 0;   // bytes of the file still to read
+        // Position of each boundary times two, plus one for a newline.
+        std::vector<size_t> boundaries;
+        size_t nextBoundary = 0;
+    };
+
+    // Splits the file into about parts pieces of equal size that each start
+    // at a record, for reading in parallel with CsvReader(path, from, to).
+    // Returns the start of every piece followed by the file size (pieces
+    // may be empty); an empty vector if the file cannot be read. The file
+    // is read once, in parallel, to count the quotes in each piece: their
+    // parity tells whether a piece starts inside a quoted field, and so
+    // which of the following newlines ends a record.
+    std::vector<uint64_t> splitRecords(const std::string& path, size_t parts);
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "data_loader.h"
+#include "csv_utils.h"
+#include "file_utils.h"
+#include "parallel.h"
+#include "security.h"
+#include "trace.h"
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+namespace data_loader {
+    namespace {
+        enum File { Owners, Pets, Appointments, FileCount };
+        const char* const fileNames[FileCount] = { "owners.csv", "pets.csv", "appointments.csv" };
+        const char* const parseSpans[FileCount] = { "parse owners.csv", "parse pets.csv", "parse appointments.csv" };
+
+        // Smaller pieces are not worth a thread of their own.
+        const uint64_t MinimumPieceBytes = 1 << 20;
+        // Appointments linked per work item.
+        const size_t LinkBatch = 4096;
+        const size_t NotFound = static_cast<size_t>(-1);
+
+        struct Piece {
+            File file;
+            uint64_t from, to;
+        };
+
+        struct PetRecord {
+            std::string ownerName;
+            Pet pet;
+            size_t owner;  // position in owners, or NotFound
+        };
+
+        // Up to four pieces per worker so the three files balance out.
+        void addPieces(std::vector<Piece>& pieces, File file) {
+            uint64_t size;
+            if (!file_utils::fileSize(fileNames[file], size)) {
+                return;
+            }
+            uint64_t parts = size / MinimumPieceBytes;
+            uint64_t most = parallel::workerCount() * 4;
+            if (parts > most) parts = most;
+            if (parts == 0) parts = 1;
+
+            std::vector<uint64_t> starts = csv_utils::splitRecords(fileNames[file], static_cast<size_t>(parts));
+            for (size_t i = 0; i + 1 < starts.size(); i++) {
+                if (starts[i] < starts[i + 1]) {
+                    pieces.push_back(Piece{ file, starts[i], starts[i + 1] });
+                }
+            }
+        }
+
+        // Moves the pieces' records into one vector, in file order.
+        template<typename T>
+        void concatenate(std::vector<std::vector<T>>& parts, std::vector<T>& out) {
+            size_t total = 0;
+            for (const auto& part : parts) total += part.size();
+            out.reserve(total);
+            for (auto& part : parts) {
+                for (auto& record : part) out.push_back(std::move(record));
+                std::vector<T>().swap(part);
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, std::string>> loadCredentials() {
+        std::vector<std::pair<std::string, std::string>> credentials;
+        csv_utils::CsvReader reader(fileNames[Owners]);
+        std::vector<csv_utils::CsvField> record;
+        while (reader.next(record)) {
+            credentials.emplace_back(record[0].value(), csv_utils::fieldValue(record, 5));
+        }
+        return credentials;
+    }
+
+    void load(std::vector<Owner>& owners, std::vector<Appointment>& appointments) {
+        std::vector<Piece> pieces;
+        for (int file = 0; file < FileCount; file++) {
+            addPieces(pieces, static_cast<File>(file));
+        }
+
+        // Parse every piece of every file.
+        std::vector<std::vector<Owner>> ownerParts(pieces.size());
+        std::vector<std::vector<PetRecord>> petParts(pieces.size());
+        std::vector<std::vector<Appointment>> appointmentParts(pieces.size());
+        parallel::forEach(pieces.size(), [&](size_t i) {
+            const Piece& piece = pieces[i];
+            trace::Span span(parseSpans[piece.file]);
+            csv_utils::CsvReader reader(fileNames[piece.file], piece.from, piece.to);
+            std::vector<csv_utils::CsvField> record;
+            while (reader.next(record)) {
+                switch (piece.file) {
+                case Owners:
+                    ownerParts[i].push_back(Owner::fromCSV(record));
+                    break;
+                case Pets:
+                    // Long medical histories are left in the file in
+                    // memory-budget mode, at the offsets the reader reports.
+                    petParts[i].push_back(PetRecord{ record[0].value(), Pet::fromCSV(record, 1, true), NotFound });
+                    break;
+                default:
+                    appointmentParts[i].push_back(Appointment::fromCSV(record));
+                    break;
+                }
+            }
+        });
+        concatenate(ownerParts, owners);
+        concatenate(appointmentParts, appointments);
+
+        // Migrate passwords stored with the legacy shift cipher. Hashing is
+        // deliberately slow, so it is spread over the workers too.
+        {
+            trace::Span span("migrate passwords");
+            parallel::forEach((owners.size() + LinkBatch - 1) / LinkBatch, [&](size_t batch) {
+                size_t end = (batch + 1) * LinkBatch < owners.size() ? (batch + 1) * LinkBatch : owners.size();
+                for (size_t i = batch * LinkBatch; i < end; i++) {
+                    Owner& owner = owners[i];
+                    if (!owner.password.empty() && !security::isPasswordHash(owner.password)) {
+                        owner.password = security::hashPassword(security::simpleDecrypt(owner.password));
+                    }
+                }
+            });
+        }
+
+        std::unordered_map<std::string, size_t> ownerPositions;
+        ownerPositions.reserve(owners.size());
+        for (size_t i = 0; i < owners.size(); i++) {
+            ownerPositions.emplace(owners[i].name, i);  // first owner of a name wins
+        }
+
+        // Attach pets: look up every pet's owner and sort the records of
+        // each piece into one bucket per range of owners, then give each
+        // worker a range so every owner's pets are appended in file order
+        // by one thread, touching only the records for that range.
+        {
+            trace::Span span("link pets");
+            size_t ranges = parallel::workerCount();
+            size_t perRange = (owners.size() + ranges - 1) / ranges;
+            if (perRange == 0) perRange = 1;
+            std::vector<std::vector<std::vector<PetRecord*>>> buckets(petParts.size(),
+                std::vector<std::vector<PetRecord*>>(ranges));
+            parallel::forEach(petParts.size(), [&](size_t i) {
+                for (auto& record : petParts[i]) {
+                    auto owner = ownerPositions.find(record.ownerName);
+                    if (owner != ownerPositions.end()) {
+                        record.owner = owner->second;
+                        buckets[i][owner->second / perRange].push_back(&record);
+                    }
+                }
+            });
+            parallel::forEach(ranges, [&](size_t r) {
+                for (auto& part : buckets) {
+                    for (PetRecord* record : part[r]) {
+                        owners[record->owner].pets.push_back(std::move(record->pet));
+                    }
+                }
+            });
+        }
+
+        // Blank the names on appointments whose owner or pet no longer
+        // exists.
+        {
+            trace::Span span("link appointments");
+            parallel::forEach((appointments.size() + LinkBatch - 1) / LinkBatch, [&](size_t batch) {
+                size_t end = (batch + 1) * LinkBatch < appointments.size() ? (batch + 1) * LinkBatch : appointments.size();
+                for (size_t i = batch * LinkBatch; i < end; i++) {
+                    Appointment& appt = appointments[i];
+                    auto owner = ownerPositions.find(appt.ownerName);
+                    bool found = false;
+                    if (owner != ownerPositions.end()) {
+                        for (const auto& candidate : owners[owner->second].pets) {
+                            if (candidate.name == appt.petName) {
+                                found = true;
+                                break;
+                            }
+                        }
+                    }
+                    else {
+                        appt.ownerName.clear();
+                    }
+                    if (!found) {
+                        appt.petName.clear();
+                    }
+                }
+            });
+        }
+    }
+}
\ No newline at end of file
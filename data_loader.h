@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <utility>
+#include "owner.h"
+#include "appointment.h"
+
+// Reads owners.csv, pets.csv and appointments.csv at startup on all
+// hardware threads.
+//
+// First the three files are parsed at the same time, each cut into pieces
+// at record boundaries (csv_utils::splitRecords) that worker threads take
+// in turn. Then the records are joined through an index of owner names:
+// pets are attached to their owners and appointments get copies of their
+// owner and pet, again split across the workers. The result is the same as
+// reading the files one record at a time: records keep their order in the
+// files and the first owner of a name wins.
+namespace data_loader {
+    // Fills owners and appointments (both empty) from the files in the
+    // current directory; a missing file counts as empty. Passwords stored
+    // with the legacy shift cipher are rehashed. Throws what the record
+    // parsers throw for a malformed record.
+    void load(std::vector<Owner>& owners, std::vector<Appointment>& appointments);
+
+    // Only the name and stored password of every owner in owners.csv, in
+    // file order: enough for logins while load() is still running.
+    std::vector<std::pair<std::string, std::string>> loadCredentials();
+}
\ No newline at end of file
@@ -0,0 +1,459 @@
+#include "dedupe.h"
+#include "parallel.h"
+#include "stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cctype>
+
+namespace dedupe {
+    namespace {
+        // Owners per blocking key beyond which the key is skipped: a
+        // group of n owners costs n * (n - 1) / 2 comparisons.
+        const size_t MaxBlock = 64;
+        // Owners normalized and pairs scored per work item.
+        const size_t OwnersPerTask = 4096;
+        const size_t PairsPerTask = 4096;
+
+        // One owner as compared: the normalized name, and hashes of the
+        // normalized phone, email and email domain (0 if empty). Kept small
+        // so scoring a pair touches little memory.
+        struct Entry {
+            const char* name = nullptr;
+            size_t length = 0;
+            // Bit c % 64 set for each character c of the name. One edit
+            // changes at most two bits, so most pairs are told apart
+            // without reading either name.
+            uint64_t characters = 0;
+            uint64_t phone = 0, email = 0, domain = 0;
+        };
+
+        void normalizeNameInto(const std::string& name, std::string& out) {
+            out.clear();
+            bool gap = false;
+            for (char c : name) {
+                unsigned char u = static_cast<unsigned char>(c);
+                if (std::isalnum(u)) {
+                    if (gap && !out.empty()) out += ' ';
+                    gap = false;
+                    out += static_cast<char>(std::tolower(u));
+                }
+                else if (std::isspace(u) || c == '-' || c == '.' || c == ',') {
+                    gap = true;
+                }
+            }
+        }
+
+        void normalizePhoneInto(const std::string& phone, std::string& out) {
+            out.clear();
+            for (char c : phone) {
+                if (c >= '0' && c <= '9') out += c;
+            }
+            if (out.size() == 12 && out.compare(0, 2, "44") == 0) {
+                out.replace(0, 2, "0");
+            }
+        }
+
+        void normalizeEmailInto(const std::string& email, std::string& out) {
+            out.clear();
+            for (char c : email) {
+                unsigned char u = static_cast<unsigned char>(c);
+                if (!std::isspace(u)) out += static_cast<char>(std::tolower(u));
+            }
+        }
+
+        // splitmix64 finalizer, as in bloom_filter.cpp.
+        uint64_t mix(uint64_t x) {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return x;
+        }
+
+        // FNV-1a over kind and text, finished with mix; never 0, which
+        // stands for an empty value.
+        uint64_t keyOf(char kind, const char* text, size_t length) {
+            if (length == 0) return 0;
+            uint64_t hash = (0xcbf29ce484222325ULL ^ static_cast<unsigned char>(kind)) * 0x100000001b3ULL;
+            for (size_t i = 0; i < length; i++) {
+                hash = (hash ^ static_cast<unsigned char>(text[i])) * 0x100000001b3ULL;
+            }
+            return mix(hash) | 1;
+        }
+
+        uint64_t keyOf(char kind, const std::string& text) {
+            return keyOf(kind, text.data(), text.size());
+        }
+
+        // Fills entry from an owner's details, except for entry.name: the
+        // normalized name is appended to names at the offset returned.
+        // scratch is working space.
+        size_t describeEntry(const std::string& name, const std::string& phone, const std::string& email,
+            Entry& entry, std::string& names, std::string& scratch) {
+            normalizePhoneInto(phone, scratch);
+            entry.phone = keyOf('p', scratch);
+            normalizeEmailInto(email, scratch);
+            entry.email = keyOf('e', scratch);
+            size_t at = scratch.rfind('@');
+            entry.domain = at == std::string::npos ? 0 : keyOf('d', scratch.data() + at + 1, scratch.size() - at - 1);
+            normalizeNameInto(name, scratch);
+            entry.characters = 0;
+            for (char c : scratch) {
+                entry.characters |= uint64_t(1) << (static_cast<unsigned char>(c) & 63);
+            }
+            size_t offset = names.size();
+            names += scratch;
+            entry.length = scratch.size();
+            return offset;
+        }
+
+        // Myers' bit-parallel algorithm in Hyyro's form for a of at most 64
+        // characters: one word holds a whole column of the distance matrix
+        // as vertical +1/-1 deltas (pv, mv), so each character of b costs a
+        // dozen word operations however long a is.
+        int bitParallelDistance(const char* a, size_t m, const char* b, size_t n, int limit) {
+            // Match masks by character; cleared again before returning.
+            thread_local uint64_t peq[256] = {};
+            for (size_t i = 0; i < m; i++) {
+                peq[static_cast<unsigned char>(a[i])] |= uint64_t(1) << i;
+            }
+
+            const uint64_t last = uint64_t(1) << (m - 1);
+            uint64_t pv = ~uint64_t(0), mv = 0;
+            int score = static_cast<int>(m);
+            for (size_t j = 0; j < n; j++) {
+                uint64_t eq = peq[static_cast<unsigned char>(b[j])];
+                uint64_t xv = eq | mv;
+                uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+                if (ph & last) score++;
+                else if (mh & last) score--;
+                ph = (ph << 1) | 1;
+                mh <<= 1;
+                pv = mh | ~(xv | ph);
+                mv = ph & xv;
+                // The distance falls by at most one per character left.
+                if (score - static_cast<int>(n - 1 - j) > limit) break;
+            }
+
+            for (size_t i = 0; i < m; i++) {
+                peq[static_cast<unsigned char>(a[i])] = 0;
+            }
+            return score > limit ? limit + 1 : score;
+        }
+
+        // Row-by-row dynamic programming, for names too long for one word.
+        int rowDistance(const char* a, size_t m, const char* b, size_t n, int limit) {
+            std::vector<int> previous(n + 1), current(n + 1);
+            for (size_t j = 0; j <= n; j++) previous[j] = static_cast<int>(j);
+            for (size_t i = 1; i <= m; i++) {
+                current[0] = static_cast<int>(i);
+                int best = current[0];
+                for (size_t j = 1; j <= n; j++) {
+                    int substitute = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                    current[j] = std::min(substitute, std::min(previous[j], current[j - 1]) + 1);
+                    best = std::min(best, current[j]);
+                }
+                if (best > limit) return limit + 1;
+                previous.swap(current);
+            }
+            return std::min(previous[n], limit + 1);
+        }
+
+        int distance(const char* a, size_t m, const char* b, size_t n, int limit) {
+            if (m > n) {
+                std::swap(a, b);
+                std::swap(m, n);
+            }
+            if (n - m > static_cast<size_t>(limit)) return limit + 1;
+            if (limit <= 0) return std::equal(a, a + m, b) ? 0 : 1;
+            if (m == 0) return static_cast<int>(n);
+            if (m <= 64) return bitParallelDistance(a, m, b, n, limit);
+            return rowDistance(a, m, b, n, limit);
+        }
+
+        int bitCount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcountll(x);
+#else
+            int count = 0;
+            for (; x; x &= x - 1) count++;
+            return count;
+#endif
+        }
+
+        // Largest name distance at which x and y would count as one
+        // customer, or -1 if they cannot, decided without reading names.
+        int distanceLimit(const Entry& x, const Entry& y) {
+            if (x.length == 0 || y.length == 0) return -1;
+            bool sameContact = (x.phone != 0 && x.phone == y.phone) || (x.email != 0 && x.email == y.email);
+            int limit = sameContact ? MaxDistance : (x.domain != 0 && x.domain == y.domain) ? 1 : 0;
+            size_t lengthDifference = x.length > y.length ? x.length - y.length : y.length - x.length;
+            if (lengthDifference > static_cast<size_t>(limit)) return -1;
+            if (bitCount(x.characters ^ y.characters) > 2 * limit) return -1;
+            return limit;
+        }
+
+        // Decides whether x and y are probably one customer.
+        bool score(const Entry& x, const Entry& y, Match& match) {
+            int limit = distanceLimit(x, y);
+            if (limit < 0) return false;
+            bool samePhone = x.phone != 0 && x.phone == y.phone;
+            bool sameEmail = x.email != 0 && x.email == y.email;
+
+            int edits = distance(x.name, x.length, y.name, y.length, limit);
+            if (edits > limit) return false;
+            match.distance = edits;
+            match.reason = samePhone ? Reason::SamePhone
+                : sameEmail ? Reason::SameEmail
+                : edits == 0 ? Reason::SameName
+                : Reason::SimilarName;
+            return true;
+        }
+
+        // Blocking key and owner position.
+        typedef std::pair<uint64_t, size_t> Key;
+
+        // Stable LSD radix sort on the key, 16 bits per pass.
+        void sortByKey(std::vector<Key>& keys) {
+            std::vector<Key> buffer(keys.size());
+            std::vector<size_t> counts(1 << 16);
+            for (int shift = 0; shift < 64; shift += 16) {
+                std::fill(counts.begin(), counts.end(), 0);
+                for (const auto& key : keys) counts[(key.first >> shift) & 0xffff]++;
+                size_t total = 0;
+                for (auto& count : counts) {
+                    size_t start = total;
+                    total += count;
+                    count = start;
+                }
+                for (const auto& key : keys) buffer[counts[(key.first >> shift) & 0xffff]++] = key;
+                keys.swap(buffer);
+            }
+        }
+
+        // Calls group(begin, end) for each run of equal keys in sorted keys.
+        template<typename Group>
+        void forEachGroup(const std::vector<Key>& keys, Group group) {
+            for (size_t start = 0; start < keys.size();) {
+                size_t end = start + 1;
+                while (end < keys.size() && keys[end].first == keys[start].first) end++;
+                group(start, end);
+                start = end;
+            }
+        }
+
+        // Each trigram of the name together with the email domain, packed
+        // into the low bytes so no string is built per trigram. A repeated
+        // trigram is numbered by occurrence, so an owner's grams are a set.
+        void addGrams(const Entry& entry, size_t position, std::vector<Key>& grams) {
+            if (entry.domain == 0 || entry.length == 0) return;
+            size_t count = entry.length < 3 ? 1 : entry.length - 2;
+            for (size_t i = 0; i < count; i++) {
+                uint64_t occurrence = 0;
+                for (size_t j = 0; j < i; j++) {
+                    if (std::equal(entry.name + j, entry.name + j + 3, entry.name + i)) occurrence++;
+                }
+                uint64_t gram = 0;
+                for (size_t k = i; k < i + 3 && k < entry.length; k++) {
+                    gram = (gram << 8) | static_cast<unsigned char>(entry.name[k]);
+                }
+                grams.emplace_back(mix(entry.domain ^ gram ^ (occurrence << 24)), position);
+            }
+        }
+    }
+
+    const char* describe(Reason reason) {
+        switch (reason) {
+        case Reason::SamePhone: return "same phone";
+        case Reason::SameEmail: return "same email";
+        case Reason::SameName: return "same name";
+        case Reason::SimilarName: return "similar name, same email domain";
+        }
+        return "";
+    }
+
+    std::string normalizeName(const std::string& name) {
+        std::string out;
+        normalizeNameInto(name, out);
+        return out;
+    }
+
+    std::string normalizePhone(const std::string& phone) {
+        std::string out;
+        normalizePhoneInto(phone, out);
+        return out;
+    }
+
+    std::string normalizeEmail(const std::string& email) {
+        std::string out;
+        normalizeEmailInto(email, out);
+        return out;
+    }
+
+    int boundedDistance(const std::string& a, const std::string& b, int limit) {
+        return distance(a.data(), a.size(), b.data(), b.size(), limit);
+    }
+
+    Report findDuplicates(const ChunkedRecords<Owner>& owners) {
+        trace::Span span("findDuplicates");
+        Report report;
+        size_t tasks = (owners.size() + OwnersPerTask - 1) / OwnersPerTask;
+
+        // Normalize and collect keys and grams, a slice of owners per task.
+        // Each slice's names go into one buffer of their own.
+        std::vector<Entry> entries(owners.size());
+        std::vector<std::string> taskNames(tasks);
+        std::vector<std::vector<Key>> taskKeys(tasks), taskGrams(tasks);
+        parallel::forEach(tasks, [&](size_t task) {
+            size_t begin = task * OwnersPerTask, end = std::min(owners.size(), begin + OwnersPerTask);
+            std::vector<size_t> offsets(end - begin);
+            std::string scratch;
+            for (size_t i = begin; i < end; i++) {
+                offsets[i - begin] = describeEntry(owners[i].name, owners[i].phone, owners[i].email,
+                    entries[i], taskNames[task], scratch);
+            }
+            for (size_t i = begin; i < end; i++) {
+                Entry& entry = entries[i];
+                entry.name = taskNames[task].data() + offsets[i - begin];
+                if (entry.length) taskKeys[task].emplace_back(keyOf('n', entry.name, entry.length), i);
+                if (entry.phone) taskKeys[task].emplace_back(entry.phone, i);
+                if (entry.email) taskKeys[task].emplace_back(entry.email, i);
+                addGrams(entry, i, taskGrams[task]);
+            }
+        });
+        std::vector<Key> keys, grams;
+        for (size_t task = 0; task < tasks; task++) {
+            keys.insert(keys.end(), taskKeys[task].begin(), taskKeys[task].end());
+            grams.insert(grams.end(), taskGrams[task].begin(), taskGrams[task].end());
+            std::vector<Key>().swap(taskKeys[task]);
+            std::vector<Key>().swap(taskGrams[task]);
+        }
+
+        // Names one edit apart share all but at most three of their grams,
+        // so ordering every owner's grams by how many owners have them,
+        // such a pair always shares one of the first PrefixGrams of each
+        // (prefix filtering). Only those become keys: they are the rarest
+        // and make the smallest groups.
+        const size_t PrefixGrams = 4;
+        sortByKey(grams);
+        std::vector<std::pair<size_t, uint64_t>> rarest(owners.size() * PrefixGrams,
+            std::make_pair(static_cast<size_t>(-1), uint64_t(0)));
+        forEachGroup(grams, [&](size_t begin, size_t end) {
+            std::pair<size_t, uint64_t> gram(end - begin, grams[begin].first);
+            for (size_t i = begin; i < end; i++) {
+                auto first = rarest.begin() + grams[i].second * PrefixGrams;
+                auto position = std::upper_bound(first, first + PrefixGrams, gram);
+                if (position != first + PrefixGrams) {
+                    std::copy_backward(position, first + PrefixGrams - 1, first + PrefixGrams);
+                    *position = gram;
+                }
+            }
+        });
+        std::vector<Key>().swap(grams);
+        for (size_t i = 0; i < rarest.size(); i++) {
+            // A gram only one owner has cannot pair anyone.
+            if (rarest[i].first != static_cast<size_t>(-1) && rarest[i].first > 1) {
+                keys.emplace_back(rarest[i].second, i / PrefixGrams);
+            }
+        }
+        std::vector<std::pair<size_t, uint64_t>>().swap(rarest);
+        sortByKey(keys);
+
+        // Owners sharing a key are candidates. Those that cannot match on
+        // length and characters alone are dropped straight away; the rest
+        // are compared once each, however many keys they share.
+        std::vector<std::pair<size_t, size_t>> pairs;
+        forEachGroup(keys, [&](size_t begin, size_t end) {
+            if (end - begin > MaxBlock) {
+                report.blocksSkipped++;
+                return;
+            }
+            for (size_t i = begin; i < end; i++) {
+                for (size_t j = i + 1; j < end; j++) {
+                    size_t x = keys[i].second, y = keys[j].second;
+                    if (x == y) continue;
+                    report.pairsCompared++;
+                    if (distanceLimit(entries[x], entries[y]) >= 0) {
+                        pairs.emplace_back(std::min(x, y), std::max(x, y));
+                    }
+                }
+            }
+        });
+        std::vector<Key>().swap(keys);
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        tasks = (pairs.size() + PairsPerTask - 1) / PairsPerTask;
+        std::vector<std::vector<Match>> taskMatches(tasks);
+        parallel::forEach(tasks, [&](size_t task) {
+            size_t end = std::min(pairs.size(), (task + 1) * PairsPerTask);
+            for (size_t i = task * PairsPerTask; i < end; i++) {
+                Match match;
+                if (score(entries[pairs[i].first], entries[pairs[i].second], match)) {
+                    match.first = pairs[i].first;
+                    match.second = pairs[i].second;
+                    taskMatches[task].push_back(match);
+                }
+            }
+        });
+        for (const auto& matches : taskMatches) {
+            report.matches.insert(report.matches.end(), matches.begin(), matches.end());
+        }
+        return report;
+    }
+
+    std::vector<Match> findSimilar(const ChunkedRecords<Owner>& owners, const std::string& name,
+        const std::string& phone, const std::string& email) {
+        stats::ScopedTimer timer(stats::Op::DuplicateCheck);
+        std::string candidateName, scratch;
+        Entry candidate;
+        describeEntry(name, phone, email, candidate, candidateName, scratch);
+        candidate.name = candidateName.data();
+
+        // Reused for every owner, so the pass allocates next to nothing.
+        std::string existingName;
+        Entry existing;
+        std::vector<Match> matches;
+        size_t i = 0;
+        for (const auto& owner : owners) {
+            existingName.clear();
+            describeEntry(owner.name, owner.phone, owner.email, existing, existingName, scratch);
+            existing.name = existingName.data();
+
+            Match match;
+            if (score(candidate, existing, match)) {
+                match.first = owners.size();
+                match.second = i;
+                matches.push_back(match);
+            }
+            i++;
+        }
+        return matches;
+    }
+
+    void printReport(std::ostream& out, const ChunkedRecords<Owner>& owners, const Report& report, size_t limit) {
+        auto describeOwner = [&owners](size_t position) {
+            const Owner& owner = owners[position];
+            return owner.name + " (" + owner.phone + ", " + owner.email + ")";
+        };
+        size_t shown = 0;
+        for (const auto& match : report.matches) {
+            if (limit && shown == limit) break;
+            out << describeOwner(match.first) << " and " << describeOwner(match.second) << ": "
+                << describe(match.reason) << ", names " << match.distance << " edit"
+                << (match.distance == 1 ? "" : "s") << " apart\n";
+            shown++;
+        }
+        if (shown < report.matches.size()) {
+            out << "... and " << (report.matches.size() - shown) << " more (vet_system --duplicates lists them all)\n";
+        }
+        out << report.matches.size() << " possible duplicates among " << owners.size() << " customers ("
+            << report.pairsCompared << " pairs compared, " << report.blocksSkipped
+            << " groups too common to compare)\n";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include "owner.h"
+#include "chunked_records.h"
+
+// Finds customers that were probably registered more than once ("Jon
+// Smith" and "John Smith" with the same phone number). Names are compared
+// after normalization: lower case, punctuation dropped, runs of spaces,
+// hyphens and dots reduced to one space. Phone numbers are compared by
+// their digits (a leading 44 read as 0) and emails without regard to case.
+namespace dedupe {
+    // Largest name edit distance counted when the phone or email matches.
+    const int MaxDistance = 2;
+
+    enum class Reason {
+        SamePhone,    // phone matches, names within MaxDistance
+        SameEmail,    // email matches, names within MaxDistance
+        SameName,     // names equal once normalized
+        SimilarName   // same email domain, names within one edit
+    };
+    const char* describe(Reason reason);
+
+    struct Match {
+        // Positions in the owners searched, first < second.
+        size_t first, second;
+        int distance;
+        Reason reason;
+    };
+
+    struct Report {
+        // Ordered by first, then second.
+        std::vector<Match> matches;
+        size_t pairsCompared = 0;
+        // Groups sharing a key too common to tell anything (a placeholder
+        // phone number, a trigram at a large email provider); not compared.
+        size_t blocksSkipped = 0;
+    };
+
+    std::string normalizeName(const std::string& name);
+    std::string normalizePhone(const std::string& phone);
+    std::string normalizeEmail(const std::string& email);
+
+    // Edit distance (insertions, deletions and substitutions) between a
+    // and b if it is at most limit, otherwise limit + 1.
+    int boundedDistance(const std::string& a, const std::string& b, int limit);
+
+    // Every pair of owners that is probably one customer. Only owners that
+    // share a normalized name, phone or email, or an email domain and a
+    // name trigram, are compared, on all processor cores.
+    Report findDuplicates(const ChunkedRecords<Owner>& owners);
+
+    // Owners a new customer with these details would probably duplicate,
+    // in order. first is owners.size(), standing for the new customer, and
+    // second the existing owner. One pass over owners with no index, so
+    // it can run on every registration.
+    std::vector<Match> findSimilar(const ChunkedRecords<Owner>& owners, const std::string& name,
+        const std::string& phone, const std::string& email);
+
+    // Lists the first limit matches (0 for all) with both owners' names,
+    // phones and emails, then the totals.
+    void printReport(std::ostream& out, const ChunkedRecords<Owner>& owners, const Report& report, size_t limit);
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "file_utils.h"
+#include "exceptions.h"
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace file_utils {
+    namespace {
+        struct Crc32Table {
+            uint32_t entries[256];
+
+            Crc32Table() {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int bit = 0; bit < 8; bit++) {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    entries[i] = c;
+                }
+            }
+        };
+
+        const Crc32Table crcTable;
+    }
+
+    uint32_t crc32(const char* data, size_t length, uint32_t crc) {
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc = crcTable.entries[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    uint32_t crc32(const std::string& data) {
+        return crc32(data.data(), data.size());
+    }
+
+    bool sync(FILE* file) {
+        if (fflush(file) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    bool truncate(FILE* file, uint64_t size) {
+        fflush(file);
+#if defined(_WIN32)
+        return _chsize_s(_fileno(file), static_cast<long long>(size)) == 0;
+#else
+        return ftruncate(fileno(file), static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    void writeDurably(const std::string& path, const std::string& contents) {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) {
+            throw FileWriteException(path);
+        }
+        bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        written = sync(file) && written;
+        fclose(file);
+        if (!written) {
+            throw FileWriteException(path);
+        }
+    }
+
+    bool readFile(const std::string& path, std::string& contents) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+        return true;
+    }
+
+    bool fileSize(const std::string& path, uint64_t& size) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) return false;
+        size = static_cast<uint64_t>(in.tellg());
+        return true;
+    }
+
+    bool seek(FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+        return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    bool checksumFile(const std::string& path, size_t& size, uint32_t& crc) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+        size = 0;
+        crc = 0;
+        char buffer[64 * 1024];
+        while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+            size_t count = static_cast<size_t>(in.gcount());
+            crc = crc32(buffer, count, crc);
+            size += count;
+        }
+        return true;
+    }
+
+    std::string rotatedPath(const std::string& path, int generation) {
+        return path + '.' + std::to_string(generation);
+    }
+
+    bool rotate(const std::string& path, int kept) {
+        remove(rotatedPath(path, kept).c_str());
+        for (int generation = kept - 1; generation >= 1; generation--) {
+            rename(rotatedPath(path, generation).c_str(), rotatedPath(path, generation + 1).c_str());
+        }
+        return rename(path.c_str(), rotatedPath(path, 1).c_str()) == 0;
+    }
+
+    bool replaceFile(const std::string& source, const std::string& target) {
+#if defined(_WIN32)
+        return MoveFileExA(source.c_str(), target.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        if (rename(source.c_str(), target.c_str()) != 0) return false;
+
+        // The rename itself lives in the directory, which needs its own sync.
+        size_t slash = target.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : target.substr(0, slash + 1);
+        int fd = open(directory.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+        return true;
+#endif
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+// Helpers for writing files that must survive a crash.
+namespace file_utils {
+    // CRC-32 (IEEE 802.3). Pass a previous result as crc to continue it.
+    uint32_t crc32(const char* data, size_t length, uint32_t crc = 0);
+    uint32_t crc32(const std::string& data);
+
+    // Flushes stdio buffers and asks the OS to put the data on disk.
+    bool sync(FILE* file);
+    // Cuts file to size bytes (beyond 2 GB on Windows too).
+    bool truncate(FILE* file, uint64_t size);
+
+    // Writes contents to path and syncs it. Throws FileWriteException.
+    void writeDurably(const std::string& path, const std::string& contents);
+
+    // Reads the whole file; returns false if it cannot be opened.
+    bool readFile(const std::string& path, std::string& contents);
+    // Size of a file in bytes; false if it cannot be opened.
+    bool fileSize(const std::string& path, uint64_t& size);
+    // Moves file to offset bytes from its start (beyond 2 GB on Windows too).
+    bool seek(FILE* file, uint64_t offset);
+
+    // Size and CRC-32 of a file, read in small chunks.
+    bool checksumFile(const std::string& path, size_t& size, uint32_t& crc);
+
+    // <path>.<generation>: the older parts of a file kept by rotate.
+    std::string rotatedPath(const std::string& path, int generation);
+    // Renames path to <path>.1, moving the older parts up one generation
+    // and deleting <path>.<kept>. Returns false if path itself could not
+    // be renamed (on Windows, while another process has it open).
+    bool rotate(const std::string& path, int kept);
+
+    // Replaces target with source in one step, so readers see either the
+    // old file or the new one (rename() cannot overwrite on Windows).
+    bool replaceFile(const std::string& source, const std::string& target);
+}
\ No newline at end of file
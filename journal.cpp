@@ -0,0 +1,235 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "journal.h"
+#include "exceptions.h"
+#include "trace.h"
+#include "file_utils.h"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <vector>
+#include <utility>
+#include <cstdio>
+
+namespace {
+    std::string checksumText(const std::string& payload) {
+        char text[9];
+        snprintf(text, sizeof(text), "%08x", static_cast<unsigned>(file_utils::crc32(payload)));
+        return text;
+    }
+
+    struct Record {
+        uint64_t sequence;
+        std::string payload;
+    };
+
+    // Reads the header and all complete records and returns the number of
+    // bytes they occupy. An empty stream reads as an empty journal with
+    // checkpoint 0.
+    long readJournal(std::istream& in, uint64_t& checkpoint, std::vector<Record>& records) {
+        checkpoint = 0;
+        records.clear();
+
+        std::string line;
+        if (!getline(in, line) || line.size() < 3 || line.compare(0, 2, "J ") != 0 ||
+            line.find_first_not_of("0123456789", 2) != std::string::npos) {
+            return 0;
+        }
+        checkpoint = std::stoull(line.substr(2));
+        long valid = static_cast<long>(in.tellg());
+
+        while (getline(in, line)) {
+            std::istringstream header(line);
+            char tag = 0;
+            Record record;
+            size_t length = 0;
+            std::string checksum;
+            if (!(header >> tag >> record.sequence >> length >> checksum) || tag != 'R') break;
+
+            record.payload.resize(length);
+            if (length > 0 && !in.read(&record.payload[0], static_cast<std::streamsize>(length))) break;
+            if (in.get() != '\n') break;
+            if (checksum != checksumText(record.payload)) break;
+            records.push_back(std::move(record));
+            valid = static_cast<long>(in.tellg());
+        }
+        return valid;
+    }
+
+    void writeHeader(FILE* f, uint64_t checkpoint) {
+        fprintf(f, "J %llu\n", static_cast<unsigned long long>(checkpoint));
+    }
+
+    bool writeRecord(FILE* f, uint64_t sequence, const std::string& payload) {
+        fprintf(f, "R %llu %llu %s\n", static_cast<unsigned long long>(sequence),
+            static_cast<unsigned long long>(payload.size()), checksumText(payload).c_str());
+        return fwrite(payload.data(), 1, payload.size(), f) == payload.size() && fputc('\n', f) != EOF;
+    }
+}
+
+Journal::Journal(const std::string& path) : path(path) {}
+
+Journal::~Journal() {
+    if (file) {
+        fclose(file);
+    }
+}
+
+void Journal::openForAppend() {
+    if (file) return;
+
+    file = fopen(path.c_str(), "ab");
+    if (!file) {
+        throw FileWriteException(path);
+    }
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        writeHeader(file, lastSeq);
+        if (!file_utils::sync(file)) {
+            throw FileWriteException(path);
+        }
+    }
+}
+
+uint64_t Journal::append(const std::string& payload, uint64_t sequence) {
+    trace::Span span("journal append");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sequence == 0) {
+        sequence = lastSeq + 1;
+    }
+    else if (sequence <= lastSeq) {
+        throw OperationFailedException("Journal record " + std::to_string(sequence) + " is out of order.");
+    }
+    openForAppend();
+
+    long start = ftell(file);
+    if (!writeRecord(file, sequence, payload) || !file_utils::sync(file)) {
+        file_utils::truncate(file, start);
+        throw FileWriteException(path);
+    }
+    lastSeq = sequence;
+    fileSize = ftell(file);
+    return sequence;
+}
+
+void Journal::replay(uint64_t after, const std::function<void(uint64_t, const std::string&)>& apply) {
+    trace::Span span("journal replay");
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64_t checkpoint = 0;
+    std::vector<Record> records;
+    long valid = 0;
+    std::ifstream in(path, std::ios::binary);
+    if (in.is_open()) {
+        valid = readJournal(in, checkpoint, records);
+    }
+
+    lastSeq = checkpoint > after ? checkpoint : after;
+    for (const auto& record : records) {
+        if (record.sequence <= lastSeq) continue;
+        apply(record.sequence, record.payload);
+        lastSeq = record.sequence;
+    }
+
+    // Cut off a torn or corrupt record so later appends are not hidden
+    // behind it.
+    openForAppend();
+    if (ftell(file) > valid) {
+        if (!file_utils::truncate(file, valid)) {
+            throw FileWriteException(path);
+        }
+        fseek(file, 0, SEEK_END);
+        if (valid == 0) {
+            writeHeader(file, lastSeq);
+        }
+        if (!file_utils::sync(file)) {
+            throw FileWriteException(path);
+        }
+    }
+    fileSize = ftell(file);
+}
+
+void Journal::scan(uint64_t after, const std::function<void(uint64_t, const std::string&)>& visit) const {
+    trace::Span span("journal scan");
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64_t checkpoint = 0;
+    std::vector<Record> records;
+    std::ifstream in(path, std::ios::binary);
+    if (in.is_open()) {
+        readJournal(in, checkpoint, records);
+    }
+
+    uint64_t last = checkpoint > after ? checkpoint : after;
+    for (const auto& record : records) {
+        if (record.sequence <= last) continue;
+        visit(record.sequence, record.payload);
+        last = record.sequence;
+    }
+}
+
+void Journal::compact(uint64_t sequence) {
+    trace::Span span("journal compact");
+
+    // Rewrite what is there now without holding the lock, so commits can
+    // keep appending meanwhile; only the records they add are copied
+    // under the lock at the end.
+    long copied;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        openForAppend();
+        copied = ftell(file);
+    }
+
+    std::string contents;
+    file_utils::readFile(path, contents);
+    contents.resize(static_cast<size_t>(copied));
+    std::istringstream existing(contents);
+    uint64_t checkpoint = 0;
+    std::vector<Record> records;
+    readJournal(existing, checkpoint, records);
+
+    std::string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if (!out) {
+        throw FileWriteException(tmpPath);
+    }
+    writeHeader(out, sequence);
+    bool written = true;
+    for (const auto& record : records) {
+        if (record.sequence > sequence) {
+            written = writeRecord(out, record.sequence, record.payload) && written;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fflush(file);
+    std::ifstream tail(path, std::ios::binary);
+    tail.seekg(copied);
+    std::string appended((std::istreambuf_iterator<char>(tail)), std::istreambuf_iterator<char>());
+    written = fwrite(appended.data(), 1, appended.size(), out) == appended.size() && written;
+    written = file_utils::sync(out) && written;
+    fclose(out);
+    if (!written) {
+        remove(tmpPath.c_str());
+        throw FileWriteException(tmpPath);
+    }
+
+    fclose(file);
+    file = nullptr;
+    if (!file_utils::replaceFile(tmpPath, path)) {
+        throw FileWriteException(path);
+    }
+    openForAppend();
+    fileSize = ftell(file);
+}
+
+uint64_t Journal::lastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastSeq;
+}
+
+long Journal::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fileSize;
+}
\ No newline at end of file
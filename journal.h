@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Append-only log of committed transactions. A commit writes one record
+// and syncs it to disk, so the CSV files only need rewriting at a
+// checkpoint (VMS::saveData), after which the journal is compacted.
+//
+// File layout: a header line "J <checkpoint>" naming the last sequence
+// number contained in every checkpoint kept (the previous one; see
+// checkpoint.h), then one record per commit:
+// "R <sequence> <length> <crc32>\n" followed by <length> payload bytes
+// and '\n'. The CRC (8 hex digits) covers the payload.
+class Journal {
+public:
+    explicit Journal(const std::string& path);
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Appends one record and syncs it to stable storage. Returns its
+    // sequence number: the next one, or the given sequence (which must be
+    // higher than the last) when a follower copies the primary's records.
+    // Throws FileWriteException; a failed append is truncated away so it
+    // never reaches a later replay.
+    uint64_t append(const std::string& payload, uint64_t sequence = 0);
+
+    // Passes every record newer than both after and the header's
+    // checkpoint to apply, in order, and continues numbering after the last
+    // one. Reading stops at the first incomplete record or checksum
+    // mismatch (a crash during append), which is then cut off.
+    void replay(uint64_t after, const std::function<void(uint64_t, const std::string&)>& apply);
+    // Passes the same records as replay would to visit, without changing
+    // the journal (for a quick look before the real replay).
+    void scan(uint64_t after, const std::function<void(uint64_t, const std::string&)>& visit) const;
+
+    // Records that everything up to and including sequence is in every
+    // checkpoint kept and drops those records. The file is replaced atomically;
+    // appends may continue while the rest is rewritten.
+    void compact(uint64_t sequence);
+
+    uint64_t lastSequence() const;
+    // Current file size in bytes, i.e. roughly the work a replay would do.
+    long size() const;
+
+private:
+    void openForAppend();
+
+    std::string path;
+    FILE* file = nullptr;
+    uint64_t lastSeq = 0;
+    long fileSize = 0;
+    mutable std::mutex mutex;
+};
\ No newline at end of file
@@ -0,0 +1,171 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "lazy_text.h"
+#include "csv_utils.h"
+#include "file_utils.h"
+#include "trace.h"
+#include <iostream>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdio>
+
+namespace lazy_text {
+    namespace {
+        const char* const DataFile = "pets.csv";
+        const uint64_t Moved = UINT64_MAX;
+
+        struct Location {
+            uint64_t offset;
+            uint32_t length;
+        };
+
+        typedef std::pair<uint32_t, std::shared_ptr<const std::string>> CacheEntry;
+
+        struct Store {
+            std::mutex mutex;
+            bool enabled = false;
+            size_t capacity = 0;
+            // Entry ids start at 1; 0 marks a resident LazyText.
+            std::vector<Location> locations{ Location{ Moved, 0 } };
+            std::list<CacheEntry> lru;  // most recently used first
+            std::unordered_map<uint32_t, std::list<CacheEntry>::iterator> cached;
+            size_t cachedBytes = 0;
+            uint64_t hits = 0, misses = 0;
+            FILE* file = nullptr;
+        };
+
+        Store& store() {
+            static Store instance;
+            return instance;
+        }
+
+        // Caller holds the store's mutex.
+        std::shared_ptr<const std::string> readLocked(Store& s, uint32_t id) {
+            const Location& location = s.locations[id];
+            if (location.offset == Moved) {
+                std::cerr << "Warning: text " << id << " is no longer in " << DataFile << std::endl;
+                return std::make_shared<const std::string>();
+            }
+            if (!s.file) {
+                s.file = fopen(DataFile, "rb");
+            }
+            std::string raw(location.length, '\0');
+            if (!s.file || !file_utils::seek(s.file, location.offset) ||
+                fread(&raw[0], 1, raw.size(), s.file) != raw.size()) {
+                std::cerr << "Warning: could not read from " << DataFile << std::endl;
+                return std::make_shared<const std::string>();
+            }
+            return std::make_shared<const std::string>(csv_utils::unescapeCSV(raw));
+        }
+
+        std::shared_ptr<const std::string> fetch(uint32_t id, bool remember) {
+            Store& s = store();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto found = s.cached.find(id);
+            if (found != s.cached.end()) {
+                s.hits++;
+                s.lru.splice(s.lru.begin(), s.lru, found->second);
+                return found->second->second;
+            }
+
+            trace::Span span("lazy text read");
+            s.misses++;
+            std::shared_ptr<const std::string> text = readLocked(s, id);
+            if (!remember || text->size() > s.capacity) {
+                return text;
+            }
+            s.lru.emplace_front(id, text);
+            s.cached[id] = s.lru.begin();
+            s.cachedBytes += text->size();
+            while (s.cachedBytes > s.capacity) {
+                s.cachedBytes -= s.lru.back().second->size();
+                s.cached.erase(s.lru.back().first);
+                s.lru.pop_back();
+            }
+            return text;
+        }
+    }
+
+    void enable(size_t cacheBytes) {
+        Store& s = store();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.enabled = true;
+        s.capacity = cacheBytes;
+    }
+
+    bool enabled() {
+        Store& s = store();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.enabled;
+    }
+
+    uint32_t add(uint64_t offset, uint32_t length) {
+        Store& s = store();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.locations.push_back(Location{ offset, length });
+        return static_cast<uint32_t>(s.locations.size() - 1);
+    }
+
+    bool replaceDataFile(const std::function<bool()>& replace,
+        const std::vector<std::pair<uint32_t, uint64_t>>& relocations) {
+        Store& s = store();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        // Windows cannot replace a file that is open.
+        if (s.file) {
+            fclose(s.file);
+            s.file = nullptr;
+        }
+        if (!replace()) {
+            return false;
+        }
+
+        std::vector<Location> moved(s.locations.size(), Location{ Moved, 0 });
+        for (const auto& relocation : relocations) {
+            moved[relocation.first] = Location{ relocation.second, s.locations[relocation.first].length };
+        }
+        s.locations.swap(moved);
+        return true;
+    }
+
+    CacheStats cacheStats() {
+        Store& s = store();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        CacheStats stats;
+        stats.entries = s.locations.size() - 1;
+        stats.cachedBytes = s.cachedBytes;
+        stats.capacityBytes = s.capacity;
+        stats.hits = s.hits;
+        stats.misses = s.misses;
+        return stats;
+    }
+}
+
+LazyText::LazyText(std::string text) {
+    if (!text.empty()) {
+        this->text = std::make_shared<const std::string>(std::move(text));
+    }
+}
+
+LazyText::LazyText(const char* text) : LazyText(std::string(text)) {}
+
+LazyText LazyText::onDisk(uint32_t id) {
+    LazyText field;
+    field.id = id;
+    return field;
+}
+
+std::string LazyText::str(bool remember) const {
+    if (id != 0) {
+        return *lazy_text::fetch(id, remember);
+    }
+    return text ? *text : std::string();
+}
+
+bool LazyText::empty() const {
+    return id == 0 && (!text || text->empty());
+}
+
+std::ostream& operator<<(std::ostream& out, const LazyText& text) {
+    return out << text.str();
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <ostream>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// A large text field (Pet::medicalHistory). Normally the text is held in
+// memory, shared between copies of the record (the snapshot and the pet
+// copies inside appointments). In memory-budget mode (lazy_text::enable)
+// loadData leaves long texts in pets.csv and keeps only their position;
+// they are read back on demand through a bounded LRU cache.
+class LazyText {
+public:
+    LazyText() = default;
+    LazyText(std::string text);
+    LazyText(const char* text);
+
+    // Text stored at the given entry of the on-disk index.
+    static LazyText onDisk(uint32_t id);
+
+    // The text, read from disk if it is not in memory. Pass remember =
+    // false for one-off scans (checkpoints) so they do not evict the cache.
+    std::string str(bool remember = true) const;
+    bool empty() const;
+
+    bool isResident() const { return id == 0; }
+    uint32_t diskId() const { return id; }
+    // The in-memory text, or nullptr for a field left on disk.
+    const std::string* resident() const { return text.get(); }
+    // Number of records sharing the in-memory text.
+    long shareCount() const { return text.use_count(); }
+
+private:
+    std::shared_ptr<const std::string> text;
+    uint32_t id = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const LazyText& text);
+
+// The on-disk index behind LazyText: entry -> offset and length of the
+// escaped CSV field in pets.csv. Thread-safe.
+namespace lazy_text {
+    // Switches memory-budget mode on for the next loadData, caching up to
+    // cacheBytes of text read back from disk.
+    void enable(size_t cacheBytes);
+    bool enabled();
+
+    // Fields shorter than this stay in memory even in memory-budget mode.
+    const size_t MinimumLength = 64;
+
+    // Records where a field is in pets.csv and returns its entry.
+    uint32_t add(uint64_t offset, uint32_t length);
+
+    // Replaces pets.csv by calling replace() and, if it succeeds, moves the
+    // given entries to their offsets in the new file, all without letting
+    // a read see the new file at an old offset. Entries not moved (records
+    // deleted since) can then only be served from the cache.
+    bool replaceDataFile(const std::function<bool()>& replace,
+        const std::vector<std::pair<uint32_t, uint64_t>>& relocations);
+
+    struct CacheStats {
+        size_t entries = 0;        // fields left on disk
+        size_t cachedBytes = 0;
+        size_t capacityBytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    CacheStats cacheStats();
+}
\ No newline at end of file
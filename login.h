@@ -1,8 +1,8 @@
-#pragma once
-#include <string>
-#include "vms.h"
-
-namespace ui {
-    std::string login(VMS& vms);
-    void createDefaultPasswordFiles();
+#pragma once
+#include <string>
+#include "vms.h"
+
+namespace ui {
+    std::string login(VMS& vms);
+    void createDefaultPasswordFiles();
 }
\ No newline at end of file
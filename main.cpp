@@ -1,45 +1,175 @@
-#define _CRT_SECURE_NO_WARNINGS
-#include "vms.h"
-#include "login.h"
-#include <iostream>
-
-int main() {
-    try {
-        ui::createDefaultPasswordFiles();
-
-        VMS vms;
-        vms.loadData();
-
-        while (true) {
-            std::string role = ui::login(vms);
-            if (role.empty()) {
-                std::cout << "Login failed. Try again? (y/n): ";
-                std::string choice;
-                std::getline(std::cin, choice);
-                if (choice != "y" && choice != "Y") {
-                    std::cout << "Exiting program.\n";
-                    break;
-                }
-                continue;
-            }
-
-            vms.displayMenu(role);
-            vms.saveData();
-
-            std::cout << "Do you want to log in again? (y/n): ";
-            std::string again;
-            std::getline(std::cin, again);
-            if (again != "y" && again != "Y") {
-                std::cout << "Thank you for using the Veterinary Management System. Goodbye!\n";
-                break;
-            }
-        }
-    }
-    catch (const std::exception& e) {
-        std::cout << "A critical error occurred: " << e.what() << std::endl;
-        std::cout << "The program will now exit." << std::endl;
-        return 1;
-    }
-
-    return 0;
+#define _CRT_SECURE_NO_WARNINGS
+#include "vms.h"
+#include "login.h"
+#include "batch.h"
+#include "trace.h"
+#include "change_feed.h"
+#include "replica.h"
+#include "lazy_text.h"
+#include "columnar.h"
+#include "csv_benchmark.h"
+#include "calendar.h"
+#include "parallel.h"
+#include "dedupe.h"
+#include <iostream>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    trace::nameThread("main");
+    try {
+        std::string batchScript;
+        std::string primaryDirectory;
+        std::string exportPath;
+        bool findDuplicates = false;
+        int commitEvery = 0;
+        int archiveAfterDays = -1;
+        bool readFeed = false;
+        uint64_t feedFrom = 0;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--batch" && i + 1 < argc) {
+                batchScript = argv[++i];
+            }
+            else if (arg == "--commit-every" && i + 1 < argc) {
+                commitEvery = std::atoi(argv[++i]);
+            }
+            else if (arg == "--trace" && i + 1 < argc) {
+                trace::start(argv[++i]);
+            }
+            else if (arg == "--memory-budget" && i + 1 < argc) {
+                lazy_text::enable(static_cast<size_t>(std::atoi(argv[++i])) << 20);
+            }
+            else if (arg == "--load-threads" && i + 1 < argc) {
+                parallel::setWorkerCount(static_cast<size_t>(std::atoi(argv[++i])));
+            }
+            else if (arg == "--archive-after" && i + 1 < argc) {
+                archiveAfterDays = std::atoi(argv[++i]);
+            }
+            else if (arg == "--csv-benchmark" && i + 1 < argc) {
+                return csv_benchmark::run(std::cout, static_cast<size_t>(std::atoi(argv[++i]))) ? 0 : 1;
+            }
+            else if (arg == "--self-test") {
+                return calendar::selfTest(std::cout) ? 0 : 1;
+            }
+            else if (arg == "--export" && i + 1 < argc) {
+                exportPath = argv[++i];
+            }
+            else if (arg == "--duplicates") {
+                findDuplicates = true;
+            }
+            else if (arg == "--follow" && i + 1 < argc) {
+                primaryDirectory = argv[++i];
+            }
+            else if (arg == "--feed-from" && i + 1 < argc) {
+                readFeed = true;
+                feedFrom = std::strtoull(argv[++i], nullptr, 10);
+            }
+            else {
+                std::cout << "Usage: vet_system [--batch <commands file> [--commit-every <n>]] [--trace <trace.json>]\n"
+                    << "                  [--archive-after <days>] [--memory-budget <cache MB>]\n"
+                    << "                  [--load-threads <n>]\n"
+                    << "       vet_system --export <file>\n"
+                    << "       vet_system --duplicates\n"
+                    << "       vet_system --csv-benchmark <MB per data set>\n"
+                    << "       vet_system --self-test\n"
+                    << "       vet_system --follow <primary directory>\n"
+                    << "       vet_system --feed-from <sequence>\n";
+                return 1;
+            }
+        }
+
+        // Prints the change feed after the given sequence, one event per
+        // line, for consumers that do not read vms.feed themselves.
+        if (readFeed) {
+            ChangeFeed::read("vms.feed", feedFrom, [](const ChangeEvent& event) {
+                std::cout << event.encode() << '\n';
+            });
+            return 0;
+        }
+
+        VMS vms;
+        if (archiveAfterDays >= 0) {
+            vms.setArchiveHorizon(archiveAfterDays);
+        }
+        bool interactive = exportPath.empty() && batchScript.empty() && primaryDirectory.empty() && !findDuplicates;
+        {
+            trace::Span span("startup");
+            if (!primaryDirectory.empty()) {
+                vms.setFollowing(true);
+                replica::bootstrap(primaryDirectory);
+            }
+            if (interactive) {
+                // The login prompt comes up while the data loads.
+                vms.startLoading(ui::createDefaultPasswordFiles);
+            }
+            else {
+                ui::createDefaultPasswordFiles();
+                vms.loadData();
+            }
+        }
+
+        if (!exportPath.empty()) {
+            size_t bytes = columnar::write(*vms.snapshot(), exportPath);
+            std::cout << "Exported owners, pets and appointments to " << exportPath
+                << " (" << bytes << " bytes).\n";
+            trace::flush();
+            return 0;
+        }
+
+        if (findDuplicates) {
+            std::shared_ptr<const Snapshot> view = vms.snapshot();
+            dedupe::printReport(std::cout, *view->owners, dedupe::findDuplicates(*view->owners), 0);
+            trace::flush();
+            return 0;
+        }
+
+        if (!batchScript.empty()) {
+            int failed = batch::run(vms, batchScript, commitEvery);
+            trace::flush();
+            return failed == 0 ? 0 : 2;
+        }
+
+        // A follower only falls through to the normal menus once promoted.
+        if (!primaryDirectory.empty() && !replica::run(vms, primaryDirectory)) {
+            trace::flush();
+            return 0;
+        }
+        vms.startReminders();
+
+        while (true) {
+            std::string role = ui::login(vms);
+            if (role.empty()) {
+                std::cout << "Login failed. Try again? (y/n): ";
+                std::string choice;
+                std::getline(std::cin, choice);
+                if (choice != "y" && choice != "Y") {
+                    std::cout << "Exiting program.\n";
+                    break;
+                }
+                continue;
+            }
+
+            vms.displayMenu(role);
+            vms.saveData();
+
+            std::cout << "Do you want to log in again? (y/n): ";
+            std::string again;
+            std::getline(std::cin, again);
+            if (again != "y" && again != "Y") {
+                std::cout << "Thank you for using the Veterinary Management System. Goodbye!\n";
+                break;
+            }
+        }
+        if (trace::isEnabled()) {
+            vms.waitForData();  // no spans may be open on the loading thread
+        }
+        trace::flush();
+    }
+    catch (const std::exception& e) {
+        std::cout << "A critical error occurred: " << e.what() << std::endl;
+        std::cout << "The program will now exit." << std::endl;
+        return 1;
+    }
+
+    return 0;
 }
\ No newline at end of file
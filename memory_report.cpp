@@ -0,0 +1,96 @@
+#include "memory_report.h"
+#include <iomanip>
+#include <string>
+
+namespace memory {
+    namespace {
+        // Strings up to this length live inside the std::string object itself.
+        const size_t ssoCapacity = std::string().capacity();
+
+        size_t stringHeap(Report& report, const std::string& s) {
+            report.strings++;
+            if (s.capacity() <= ssoCapacity) {
+                report.inlineStrings++;
+                return 0;
+            }
+            report.heapStrings++;
+            return s.capacity() + 1;
+        }
+
+        // A text left on disk costs nothing here; one held in memory is
+        // shared by every copy of the pet, so each is charged its share.
+        size_t textHeap(Report& report, const LazyText& text) {
+            const std::string* resident = text.resident();
+            if (!resident) {
+                report.strings++;
+                report.inlineStrings++;
+                return 0;
+            }
+            return (stringHeap(report, *resident) + sizeof(std::string)) / static_cast<size_t>(text.shareCount());
+        }
+
+        size_t petHeap(Report& report, const Pet& pet) {
+            return stringHeap(report, pet.name) + stringHeap(report, pet.breed) +
+                textHeap(report, pet.medicalHistory);
+        }
+
+        size_t ownerHeap(Report& report, const Owner& owner) {
+            return stringHeap(report, owner.name) + stringHeap(report, owner.address) +
+                stringHeap(report, owner.phone) + stringHeap(report, owner.email) +
+                stringHeap(report, owner.password);
+        }
+
+        void printRow(std::ostream& out, const char* label, const EntityUsage& usage) {
+            out << std::left << std::setw(14) << label << std::right
+                << std::setw(10) << usage.count
+                << std::setw(12) << usage.inlineBytes
+                << std::setw(14) << usage.stringHeapBytes
+                << std::setw(12) << usage.vectorSlackBytes
+                << std::setw(14) << usage.total() << "\n";
+        }
+    }
+
+    Report measure(const std::vector<Owner>& owners, const std::vector<Appointment>& appointments) {
+        Report report;
+
+        report.owners.count = owners.size();
+        report.owners.inlineBytes = owners.size() * sizeof(Owner);
+        report.owners.vectorSlackBytes = (owners.capacity() - owners.size()) * sizeof(Owner);
+        for (const auto& owner : owners) {
+            report.owners.stringHeapBytes += ownerHeap(report, owner);
+
+            report.pets.count += owner.pets.size();
+            report.pets.inlineBytes += owner.pets.size() * sizeof(Pet);
+            report.pets.vectorSlackBytes += (owner.pets.capacity() - owner.pets.size()) * sizeof(Pet);
+            for (const auto& pet : owner.pets) {
+                report.pets.stringHeapBytes += petHeap(report, pet);
+            }
+        }
+
+        report.appointments.count = appointments.size();
+        report.appointments.inlineBytes = appointments.size() * sizeof(Appointment);
+        report.appointments.vectorSlackBytes =
+            (appointments.capacity() - appointments.size()) * sizeof(Appointment);
+        for (const auto& appt : appointments) {
+            report.appointments.stringHeapBytes += stringHeap(report, appt.date) +
+                stringHeap(report, appt.time) + stringHeap(report, appt.status) +
+                stringHeap(report, appt.petName) + stringHeap(report, appt.ownerName);
+        }
+
+        return report;
+    }
+
+    void printReport(const Report& report, std::ostream& out) {
+        out << "\n--- Memory Usage (bytes) ---\n";
+        out << std::left << std::setw(14) << "Entity" << std::right
+            << std::setw(10) << "Count" << std::setw(12) << "Inline"
+            << std::setw(14) << "String heap" << std::setw(12) << "Slack" << std::setw(14) << "Total" << "\n";
+        printRow(out, "Owners", report.owners);
+        printRow(out, "Pets", report.pets);
+        printRow(out, "Appointments", report.appointments);
+        out << "Total: " << report.total() << " bytes\n";
+
+        out << "Strings: " << report.strings << " (" << report.inlineStrings << " inline/SSO, "
+            << report.heapStrings << " heap-allocated, SSO capacity " << ssoCapacity << ")\n";
+    }
+}
\ No newline at end of file
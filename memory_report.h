@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include "owner.h"
+#include "appointment.h"
+
+namespace memory {
+    // Bytes attributed to one kind of entity. "Inline" is sizeof() of the
+    // objects themselves, "string heap" the buffers of strings too long for
+    // the small-string optimisation and "slack" unused vector capacity.
+    struct EntityUsage {
+        size_t count = 0;
+        size_t inlineBytes = 0;
+        size_t stringHeapBytes = 0;
+        size_t vectorSlackBytes = 0;
+
+        size_t total() const { return inlineBytes + stringHeapBytes + vectorSlackBytes; }
+    };
+
+    struct Report {
+        EntityUsage owners;
+        EntityUsage pets;
+        EntityUsage appointments;
+
+        size_t strings = 0;
+        size_t inlineStrings = 0;   // fit in the SSO buffer
+        size_t heapStrings = 0;     // spilled to the heap
+
+        size_t total() const { return owners.total() + pets.total() + appointments.total(); }
+    };
+
+    // Walks the live collections and measures them; O(total records).
+    Report measure(const std::vector<Owner>& owners, const std::vector<Appointment>& appointments);
+
+    void printReport(const Report& report, std::ostream& out);
+}
\ No newline at end of file
@@ -1,8 +1,8 @@
-#pragma once
-#include <string>
-#include <vector>
-
-namespace ui {
-  
-    int displayRoleMenu(const std::string& title, const std::vector<std::string>& options, int maxOptions);
+#pragma once
+#include <string>
+#include <vector>
+
+namespace ui {
+  
+    int displayRoleMenu(const std::string& title, const std::vector<std::string>& options, int maxOptions);
 }
\ No newline at end of file
@@ -1,1118 +1,2253 @@
-#define _CRT_SECURE_NO_WARNINGS
-
-#include "vms.h"
-#include "exceptions.h"
-#include "csv_utils.h"
-#include "security.h"
-#include "menus.h"
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <limits>
-#include <algorithm>
-#include <regex>
-#include <ctime>
-#include <iomanip>
-
-// Private Helper Methods
-
-template<typename T>
-T VMS::getValidInput(const std::string& prompt, std::function<bool(const T&)> validator) {
-    T input;
-    while (true) {
-        std::cout << prompt;
-        if (std::cin >> input && validator(input)) {
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            return input;
-        }
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        std::cout << "Invalid input. Please try again.\n";
-    }
-}
-
-std::string VMS::getValidStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator) {
-    std::string input;
-    while (true) {
-        std::cout << prompt;
-        std::getline(std::cin, input);
-        if (validator(input)) return input;
-        std::cout << "Invalid input. Please try again.\n";
-    }
-}
-
-bool VMS::isValidName(const std::string& name) const {
-    return std::regex_match(name, std::regex(R"(^[A-Za-z\s\-']{2,50}$)"));
-}
-
-bool VMS::isValidAddress(const std::string& address) const {
-    return address.length() >= 5 && address.length() <= 100;
-}
-
-bool VMS::isValidEmail(const std::string& email) const {
-    return std::regex_match(email, std::regex(R"(^[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,}$)"));
-}
-
-bool VMS::isValidPhone(const std::string& phone) const {
-    return phone.length() == 11 && std::all_of(phone.begin(), phone.end(), ::isdigit);
-}
-
-bool VMS::isValidDate(const std::string& date) const {
-    // First check format with regex
-    if (!std::regex_match(date, std::regex(R"(^\d{4}-\d{2}-\d{2}$)"))) {
-        return false;
-    }
-
-    // Parse the date components
-    int year, month, day;
-    try {
-        year = std::stoi(date.substr(0, 4));
-        month = std::stoi(date.substr(5, 2));
-        day = std::stoi(date.substr(8, 2));
-    }
-    catch (...) {
-        return false;
-    }
-
-    // Check month range
-    if (month < 1 || month > 12) {
-        return false;
-    }
-
-    // Check day range based on month
-    int daysInMonth[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-
-    // Adjust February for leap years
-    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0))) {
-        daysInMonth[2] = 29;
-    }
-
-    if (day < 1 || day > daysInMonth[month]) {
-        return false;
-    }
-
-    return true;
-}
-
-bool VMS::isValidTime(const std::string& time) const {
-    return std::regex_match(time, std::regex(R"(^\d{2}:\d{2}$)"));
-}
-
-bool VMS::isValidPassword(const std::string& password) const {
-    return password.length() >= 6;
-}
-
-void VMS::updateAllAppointmentStatuses() {
-    for (auto& appointment : appointments) {
-        appointment.updateStatus();
-    }
-}
-
-int VMS::displayRoleMenu(const std::string& title, const std::vector<std::string>& options, int maxOptions) {
-    return ui::displayRoleMenu(title, options, maxOptions);
-}
-
-bool VMS::isDateTimeInFuture(const std::string& date, const std::string& time) const {
-    tm apptTime = {};
-    std::stringstream datetime(date + " " + time);
-    datetime >> std::get_time(&apptTime, "%Y-%m-%d %H:%M");
-    if (datetime.fail()) return false;
-
-    time_t apptTimestamp = mktime(&apptTime);
-    time_t now = std::time(nullptr);
-    return apptTimestamp > now;
-}
-
-bool VMS::hasTimeConflict(const std::string& date, const std::string& time) const {
-    for (const auto& appt : appointments) {
-        if (appt.date == date && appt.time == time && appt.status != "Cancelled") {
-            return true;
-        }
-    }
-    return false;
-}
-
-bool VMS::isDuplicateAppointment(const std::string& ownerName, const std::string& petName,
-    const std::string& date, const std::string& time) const {
-    for (const auto& appt : appointments) {
-        if (appt.owner.name == ownerName &&
-            appt.pet.name == petName &&
-            appt.date == date &&
-            appt.time == time &&
-            appt.status != "Cancelled") {
-            return true;
-        }
-    }
-    return false;
-}
-
-bool VMS::isValidStatusTransition(const std::string& currentStatus, const std::string& newStatus) {
-    if (currentStatus == newStatus) return true;
-
-    if (currentStatus == "Scheduled") {
-        return newStatus == "Completed" || newStatus == "Cancelled";
-    }
-    else if (currentStatus == "Completed") {
-        return false;
-    }
-    else if (currentStatus == "Cancelled") {
-        return false;
-    }
-
-    return false;
-}
-
-bool VMS::isVaccinationStatusAppropriate(int petAge, bool isVaccinated) {
-    if (petAge < 1 && !isVaccinated) {
-        return true;
-    }
-    return true;
-}
-
-// Public Methods
-
-void VMS::addOwner(const Owner& owner) {
-    owners.push_back(owner);
-}
-
-const std::vector<Owner>& VMS::getOwners() const {
-    return owners;
-}
-
-bool VMS::validateCustomerLogin(const std::string& name, const std::string& password) const {
-    for (const auto& owner : owners) {
-        if (owner.name == name && owner.password == password) {
-            return true;
-        }
-    }
-    return false;
-}
-
-bool VMS::validateName(const std::string& name) const {
-    return isValidName(name);
-}
-
-bool VMS::validateAddress(const std::string& address) const {
-    return isValidAddress(address);
-}
-
-bool VMS::validateEmail(const std::string& email) const {
-    return isValidEmail(email);
-}
-
-bool VMS::validatePhone(const std::string& phone) const {
-    return isValidPhone(phone);
-}
-
-bool VMS::validateDate(const std::string& date) const {
-    return isValidDate(date);
-}
-
-bool VMS::validateTime(const std::string& time) const {
-    return isValidTime(time);
-}
-
-bool VMS::validatePassword(const std::string& password) const {
-    return isValidPassword(password);
-}
-
-std::string VMS::getValidatedStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator) {
-    return getValidStringInput(prompt, validator);
-}
-
-template<typename T>
-T VMS::getValidatedInput(const std::string& prompt, std::function<bool(const T&)> validator) {
-    return getValidInput<T>(prompt, validator);
-}
-
-void VMS::viewPetAppointmentHistory() {
-    std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-        [this](const std::string& s) { return validateName(s); });
-    std::string petName = getValidatedStringInput("Enter pet's name: ",
-        [this](const std::string& s) { return validateName(s); });
-
-    bool found = false;
-    std::cout << "\nAppointment History for " << petName << ":\n";
-
-    for (const auto& appt : appointments) {
-        if (appt.pet.name == petName && appt.owner.name == ownerName) {
-            found = true;
-            std::cout << "Date: " << appt.date << " | Time: " << appt.time
-                << " | Status: " << appt.status << std::endl;
-        }
-    }
-
-    if (!found) {
-        std::cout << "No appointment history found for this pet.\n";
-    }
-}
-
-void VMS::viewPetMedicalHistory(const std::string& role) {
-    std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-        [this](const std::string& s) { return validateName(s); });
-    std::string petName = getValidatedStringInput("Enter pet's name: ",
-        [this](const std::string& s) { return validateName(s); });
-
-    bool found = false;
-    for (const auto& owner : owners) {
-        if (owner.name == ownerName) {
-            for (const auto& pet : owner.pets) {
-                if (pet.name == petName) {
-                    found = true;
-
-                    std::cout << "\n--- Medical History for " << pet.name << " ---\n";
-                    std::cout << "Owner: " << owner.name << "\n";
-                    std::cout << "Breed: " << pet.breed << "\n";
-                    std::cout << "Age: " << pet.age << "\n";
-                    std::cout << "Vaccination Status: " << (pet.vaccinated ? "Vaccinated" : "Not Vaccinated") << "\n";
-                    std::cout << "\nMedical History:\n";
-
-                    if (pet.medicalHistory.empty()) {
-                        std::cout << "No medical history recorded.\n";
-                    }
-                    else {
-                        std::cout << pet.medicalHistory << "\n";
-                    }
-
-                    if (role == "admin" || role == "vet") {
-                        std::cout << "\nAppointment History:\n";
-                        bool hasAppointments = false;
-                        for (const auto& appt : appointments) {
-                            if (appt.pet.name == petName && appt.owner.name == ownerName) {
-                                hasAppointments = true;
-                                std::cout << "Date: " << appt.date << " | Time: " << appt.time
-                                    << " | Status: " << appt.status << std::endl;
-                            }
-                        }
-
-                        if (!hasAppointments) {
-                            std::cout << "No appointment history found for this pet.\n";
-                        }
-
-                        std::cout << "\nMedical History Management Options:\n";
-                        std::cout << "1. Add new entry to medical history\n";
-                        std::cout << "2. Replace entire medical history\n";
-                        std::cout << "3. Return to previous menu\n";
-
-                        int choice = getValidatedInput<int>("Enter choice (1-3): ",
-                            [](int c) { return c >= 1 && c <= 3; });
-
-                        if (choice == 3) {
-                            break;
-                        }
-
-                        std::string newMedHist;
-
-                        if (choice == 1) {
-                            newMedHist = getValidatedStringInput("Enter new medical history entry: ",
-                                [](const std::string&) { return true; });
-
-                            time_t now = time(nullptr);
-                            tm* ltm = localtime(&now);
-                            char dateBuffer[11];
-                            strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d", ltm);
-
-                            for (auto& updateOwner : owners) {
-                                if (updateOwner.name == ownerName) {
-                                    for (auto& updatePet : updateOwner.pets) {
-                                        if (updatePet.name == petName) {
-                                            if (!updatePet.medicalHistory.empty()) {
-                                                updatePet.medicalHistory += "\n\n";
-                                            }
-                                            updatePet.medicalHistory += "[" + std::string(dateBuffer) + "] " + newMedHist;
-
-                                            for (auto& appt : appointments) {
-                                                if (appt.pet.name == petName && appt.owner.name == ownerName) {
-                                                    appt.pet = updatePet;
-                                                }
-                                            }
-
-                                            saveData();
-                                            std::cout << "Medical history updated successfully!\n";
-                                            break;
-                                        }
-                                    }
-                                    break;
-                                }
-                            }
-                        }
-                        else if (choice == 2) {
-                            newMedHist = getValidatedStringInput("Enter new comprehensive medical history: ",
-                                [](const std::string&) { return true; });
-
-                            for (auto& updateOwner : owners) {
-                                if (updateOwner.name == ownerName) {
-                                    for (auto& updatePet : updateOwner.pets) {
-                                        if (updatePet.name == petName) {
-                                            updatePet.medicalHistory = newMedHist;
-
-                                            for (auto& appt : appointments) {
-                                                if (appt.pet.name == petName && appt.owner.name == ownerName) {
-                                                    appt.pet = updatePet;
-                                                }
-                                            }
-
-                                            saveData();
-                                            std::cout << "Medical history replaced successfully!\n";
-                                            break;
-                                        }
-                                    }
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                    break;
-                }
-            }
-            break;
-        }
-    }
-
-    if (!found) {
-        std::cout << "Pet not found.\n";
-    }
-}
-
-void VMS::displayCustomerMenu(const std::string& customerName) {
-    Owner* customer = nullptr;
-    for (auto& owner : owners) {
-        if (owner.name == customerName) {
-            customer = &owner;
-            break;
-        }
-    }
-
-    if (!customer) {
-        std::cout << "Customer not found!\n";
-        return;
-    }
-
-    std::vector<std::string> options = {
-        "View My Profile",
-        "View My Pets",
-        "View My Appointments",
-        "Add New Pet",
-        "Schedule Appointment",
-        "View Pet Appointment History"
-    };
-    int maxFunctionalOption = options.size();
-
-    while (true) {
-        std::cout << "\n--- Customer Menu (" << customerName << ") ---\n";
-        for (size_t i = 0; i < options.size(); i++) {
-            std::cout << (i + 1) << ". " << options[i] << "\n";
-        }
-        int exitOption = options.size() + 1;
-        std::cout << exitOption << ". Back to Main Menu\n";
-
-        int choice = getValidatedInput<int>("Enter choice: ",
-            [maxFunctionalOption, exitOption](int c) {
-                return (c >= 1 && c <= maxFunctionalOption) || c == exitOption;
-            });
-
-        if (choice == exitOption) return;
-
-        switch (choice) {
-        case 1: {
-            std::cout << "\nYour Profile:\n";
-            std::cout << "Name: " << customer->name << "\n";
-            std::cout << "Age: " << customer->age << "\n";
-            std::cout << "Address: " << customer->address << "\n";
-            std::cout << "Phone: " << customer->phone << "\n";
-            std::cout << "Email: " << customer->email << "\n";
-            break;
-        }
-        case 2: {
-            if (customer->pets.empty()) {
-                std::cout << "You have no pets registered.\n";
-            }
-            else {
-                std::cout << "\nYour Pets:\n";
-                for (const auto& pet : customer->pets) {
-                    std::cout << "- " << pet.name << " (" << pet.breed << "), Age: " << pet.age
-                        << ", Vaccinated: " << (pet.vaccinated ? "Yes" : "No") << "\n";
-                }
-            }
-            break;
-        }
-        case 3: {
-            bool found = false;
-            std::cout << "\nYour Appointments:\n";
-            for (const auto& appt : appointments) {
-                if (appt.owner.name == customerName) {
-                    found = true;
-                    std::cout << "Date: " << appt.date << " | Time: " << appt.time
-                        << " | Pet: " << appt.pet.name << " | Status: " << appt.status << std::endl;
-                }
-            }
-            if (!found) std::cout << "No appointments found.\n";
-            break;
-        }
-        case 4: {
-            std::string name = getValidatedStringInput("Enter pet name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string breed = getValidatedStringInput("Enter pet breed: ",
-                [this](const std::string& s) { return validateName(s); });
-            int age = getValidatedInput<int>("Enter pet age: ",
-                [](int a) { return a > 0 && a < 30; });
-            std::string medHist = getValidatedStringInput("Enter medical history: ",
-                [](const std::string&) { return true; });
-            bool vaccinated = getValidatedInput<bool>("Is pet vaccinated? (1 for Yes, 0 for No): ",
-                [](bool) { return true; });
-
-            if (!isVaccinationStatusAppropriate(age, vaccinated)) {
-                std::cout << "Warning: Vaccination status may not be appropriate for this pet's age.\n";
-                std::string confirm = getValidatedStringInput("Continue anyway? (y/n): ",
-                    [](const std::string& s) { return s == "y" || s == "n"; });
-                if (confirm == "n") break;
-            }
-
-            customer->addPet(Pet(name, breed, age, medHist, vaccinated));
-            saveData();
-            std::cout << "Pet added successfully!\n";
-            break;
-        }
-        case 5: {
-            if (customer->pets.empty()) {
-                std::cout << "You need to add a pet first!\n";
-                break;
-            }
-
-            std::cout << "Select a pet:\n";
-            for (size_t i = 0; i < customer->pets.size(); i++) {
-                std::cout << i + 1 << ". " << customer->pets[i].name << "\n";
-            }
-            int petChoice = getValidatedInput<int>("Enter pet number: ",
-                [customer](int c) { return c > 0 && c <= static_cast<int>(customer->pets.size()); });
-
-            std::string date = getValidatedStringInput("Enter date (YYYY-MM-DD): ",
-                [this](const std::string& s) { return validateDate(s); });
-            std::string time = getValidatedStringInput("Enter time (HH:MM): ",
-                [this](const std::string& s) { return validateTime(s); });
-
-            if (!isDateTimeInFuture(date, time)) {
-                std::cout << "Error: Cannot schedule appointments in the past.\n";
-                break;
-            }
-
-            if (hasTimeConflict(date, time)) {
-                std::cout << "Error: There is already an appointment at this time.\n";
-                break;
-            }
-
-            if (isDuplicateAppointment(customer->name, customer->pets[petChoice - 1].name, date, time)) {
-                std::cout << "Error: This pet already has an appointment at this time.\n";
-                break;
-            }
-
-            appointments.push_back(Appointment(date, time, customer->pets[petChoice - 1], *customer, "Scheduled"));
-            saveData();
-            std::cout << "Appointment scheduled successfully!\n";
-            break;
-        }
-        case 6: {
-            if (customer->pets.empty()) {
-                std::cout << "You have no pets registered.\n";
-                break;
-            }
-
-            std::cout << "Select a pet to view appointment history:\n";
-            for (size_t i = 0; i < customer->pets.size(); i++) {
-                std::cout << i + 1 << ". " << customer->pets[i].name << "\n";
-            }
-            int petChoice = getValidatedInput<int>("Enter pet number: ",
-                [customer](int c) { return c > 0 && c <= static_cast<int>(customer->pets.size()); });
-
-            std::string petName = customer->pets[petChoice - 1].name;
-            bool found = false;
-            std::cout << "\nAppointment History for " << petName << ":\n";
-
-            for (const auto& appt : appointments) {
-                if (appt.pet.name == petName && appt.owner.name == customer->name) {
-                    found = true;
-                    std::cout << "Date: " << appt.date << " | Time: " << appt.time
-                        << " | Status: " << appt.status << std::endl;
-                }
-            }
-
-            if (!found) {
-                std::cout << "No appointment history found for this pet.\n";
-            }
-            break;
-        }
-        }
-    }
-}
-
-void VMS::displayPetsMenu(const std::string& role) {
-    std::vector<std::string> options = { "View All Pets", "View Pet Medical History" };
-    int maxFunctionalOption = 2;
-
-    if (role == "admin" || role == "staff") {
-        options.push_back("Update Pet");
-        maxFunctionalOption = 3;
-    }
-    if (role == "admin") {
-        options.push_back("Delete Pet");
-        maxFunctionalOption = 4;
-    }
-
-    while (true) {
-        int choice = displayRoleMenu("Pets Menu", options, maxFunctionalOption);
-        if (choice == -1) return;
-
-        switch (choice) {
-        case 1: {
-            if (owners.empty()) {
-                std::cout << "No owners found.\n";
-            }
-            else {
-                for (const auto& owner : owners) {
-                    if (!owner.pets.empty()) {
-                        std::cout << "\nOwner: " << owner.name << "\n";
-                        for (const auto& pet : owner.pets) {
-                            std::cout << "- " << pet.name << " (" << pet.breed << "), Age: " << pet.age
-                                << ", Vaccinated: " << (pet.vaccinated ? "Yes" : "No") << "\n";
-                        }
-                    }
-                }
-            }
-            break;
-        }
-        case 2: {
-            viewPetMedicalHistory(role);
-            break;
-        }
-        case 3: {
-            if (role != "admin" && role != "staff") {
-                std::cout << "Access denied.\n";
-                break;
-            }
-            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string petName = getValidatedStringInput("Enter pet's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            bool found = false;
-            for (auto& owner : owners) {
-                if (owner.name == ownerName) {
-                    for (auto& pet : owner.pets) {
-                        if (pet.name == petName) {
-                            found = true;
-                            std::cout << "Current pet details:\n";
-                            std::cout << "Name: " << pet.name << "\nBreed: " << pet.breed << "\nAge: " << pet.age
-                                << "\nMedical History: " << pet.medicalHistory << "\nVaccinated: "
-                                << (pet.vaccinated ? "Yes" : "No") << "\n";
-
-                            std::string newMedHist = getValidatedStringInput("Enter new medical history: ",
-                                [](const std::string&) { return true; });
-                            bool newVaccinated = getValidatedInput<bool>("Update vaccination status? (1 for Yes, 0 for No): ",
-                                [](bool) { return true; });
-
-                            pet.medicalHistory = newMedHist;
-                            pet.vaccinated = newVaccinated;
-
-                            for (auto& appt : appointments) {
-                                if (appt.pet.name == petName && appt.owner.name == ownerName) {
-                                    appt.pet = pet;
-                                }
-                            }
-
-                            saveData();
-                            std::cout << "Pet updated successfully!\n";
-                            break;
-                        }
-                    }
-                }
-            }
-            if (!found) std::cout << "Pet not found.\n";
-            break;
-        }
-        case 4: {
-            if (role != "admin") {
-                std::cout << "Access denied. Admin only.\n";
-                break;
-            }
-            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string petName = getValidatedStringInput("Enter pet's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            bool found = false;
-            for (auto itOwner = owners.begin(); itOwner != owners.end(); ++itOwner) {
-                if (itOwner->name == ownerName) {
-                    for (auto itPet = itOwner->pets.begin(); itPet != itOwner->pets.end(); ++itPet) {
-                        if (itPet->name == petName) {
-                            found = true;
-                            itOwner->pets.erase(itPet);
-
-                            std::vector<Appointment> updatedAppointments;
-                            for (const auto& appt : appointments) {
-                                if (!(appt.pet.name == petName && appt.owner.name == ownerName)) {
-                                    updatedAppointments.push_back(appt);
-                                }
-                            }
-                            appointments = updatedAppointments;
-
-                            saveData();
-                            std::cout << "Pet deleted successfully!\n";
-                            break;
-                        }
-                    }
-                }
-            }
-            if (!found) std::cout << "Pet not found.\n";
-            break;
-        }
-        }
-    }
-}
-
-void VMS::displayAppointmentMenu(const std::string& role) {
-    std::vector<std::string> options = { "View All Appointments" };
-    int maxFunctionalOption = 1;
-    if (role == "admin" || role == "staff") {
-        options.push_back("Schedule Appointment");
-        options.push_back("Update Appointment");
-        maxFunctionalOption = 3;
-    }
-    if (role == "admin" || role == "vet") {
-        options.push_back("Cancel Appointment");
-        maxFunctionalOption = 4;
-    }
-
-    while (true) {
-        int choice = displayRoleMenu("Appointments Menu", options, maxFunctionalOption);
-        if (choice == -1) return;
-
-        switch (choice) {
-        case 1: {
-            if (appointments.empty()) {
-                std::cout << "No appointments found.\n";
-            }
-            else {
-                for (const auto& appt : appointments) {
-                    std::cout << "Date: " << appt.date << " | Time: " << appt.time
-                        << " | Pet: " << appt.pet.name << " | Owner: " << appt.owner.name
-                        << " | Status: " << appt.status << "\n";
-                }
-            }
-            break;
-        }
-        case 2: {
-            if (role != "admin" && role != "staff") {
-                std::cout << "Access denied.\n";
-                break;
-            }
-            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string petName = getValidatedStringInput("Enter pet's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string date = getValidatedStringInput("Enter date (YYYY-MM-DD): ",
-                [this](const std::string& s) { return validateDate(s); });
-            std::string time = getValidatedStringInput("Enter time (HH:MM): ",
-                [this](const std::string& s) { return validateTime(s); });
-
-            if (!isDateTimeInFuture(date, time)) {
-                std::cout << "Error: Cannot schedule appointments in the past.\n";
-                break;
-            }
-
-            if (hasTimeConflict(date, time)) {
-                std::cout << "Error: There is already an appointment at this time.\n";
-                break;
-            }
-
-            if (isDuplicateAppointment(ownerName, petName, date, time)) {
-                std::cout << "Error: This pet already has an appointment at this time.\n";
-                break;
-            }
-
-            bool found = false;
-            for (const auto& owner : owners) {
-                if (owner.name == ownerName) {
-                    for (const auto& pet : owner.pets) {
-                        if (pet.name == petName) {
-                            found = true;
-                            appointments.push_back(Appointment(date, time, pet, owner, "Scheduled"));
-                            saveData();
-                            std::cout << "Appointment scheduled successfully!\n";
-                            break;
-                        }
-                    }
-                }
-            }
-            if (!found) std::cout << "Owner/pet not found.\n";
-            break;
-        }
-        case 3: {
-            if (role != "admin" && role != "staff") {
-                std::cout << "Access denied.\n";
-                break;
-            }
-            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string petName = getValidatedStringInput("Enter pet's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string date = getValidatedStringInput("Enter appointment date: ",
-                [this](const std::string& s) { return validateDate(s); });
-            std::string time = getValidatedStringInput("Enter appointment time: ",
-                [this](const std::string& s) { return validateTime(s); });
-
-            bool found = false;
-            for (auto& appt : appointments) {
-                if (appt.owner.name == ownerName && appt.pet.name == petName &&
-                    appt.date == date && appt.time == time) {
-                    found = true;
-
-                    std::string newStatus = getValidatedStringInput("Enter new status (Scheduled/Completed/Cancelled): ",
-                        [&appt, this](const std::string& s) {
-                            if (s == "Scheduled" && appt.isInPast()) {
-                                std::cout << "Cannot set a past appointment to Scheduled status.\n";
-                                return false;
-                            }
-                            if (!isValidStatusTransition(appt.status, s)) {
-                                std::cout << "Invalid status transition from " << appt.status << " to " << s << ".\n";
-                                return false;
-                            }
-                            return s == "Scheduled" || s == "Completed" || s == "Cancelled";
-                        });
-
-                    appt.status = newStatus;
-                    saveData();
-                    std::cout << "Appointment updated successfully!\n";
-                    break;
-                }
-            }
-            if (!found) std::cout << "Appointment not found.\n";
-            break;
-        }
-        case 4: {
-            if (role != "admin" && role != "vet") {
-                std::cout << "Access denied. Admin/vet only.\n";
-                break;
-            }
-            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string petName = getValidatedStringInput("Enter pet's name: ",
-                [this](const std::string& s) { return validateName(s); });
-            std::string date = getValidatedStringInput("Enter appointment date: ",
-                [this](const std::string& s) { return validateDate(s); });
-            std::string time = getValidatedStringInput("Enter appointment time: ",
-                [this](const std::string& s) { return validateTime(s); });
-
-            bool found = false;
-            for (auto it = appointments.begin(); it != appointments.end(); ++it) {
-                if (it->owner.name == ownerName && it->pet.name == petName &&
-                    it->date == date && it->time == time) {
-                    found = true;
-
-                    it->status = "Cancelled";
-                    saveData();
-                    std::cout << "Appointment cancelled successfully!\n";
-                    break;
-                }
-            }
-            if (!found) std::cout << "Appointment not found.\n";
-            break;
-        }
-        }
-    }
-}
-
-void VMS::displayOwnersMenu(const std::string& role) {
-    std::vector<std::string> options = { "View All Owners" };
-    int maxFunctionalOption = 1;
-
-    if (role == "admin" || role == "staff") {
-        options.push_back("Add New Owner");
-        options.push_back("Update Owner");
-        maxFunctionalOption = 3;
-    }
-    if (role == "admin") {
-        options.push_back("Delete Owner");
-        maxFunctionalOption = 4;
-    }
-
-    while (true) {
-        int choice = displayRoleMenu("Owners Menu", options, maxFunctionalOption);
-        if (choice == -1) return;
-
-        switch (choice) {
-        case 1: {
-            if (owners.empty()) {
-                std::cout << "No owners found.\n";
-            }
-            else {
-                for (const auto& owner : owners) {
-                    std::cout << "\nName: " << owner.name << "\nAge: " << owner.age
-                        << "\nAddress: " << owner.address << "\nPhone: " << owner.phone
-                        << "\nEmail: " << owner.email << "\n";
-                }
-            }
-            break;
-        }
-        case 2: {
-            if (role != "admin" && role != "staff") {
-                std::cout << "Access denied.\n";
-                break;
-            }
-            std::string name = getValidatedStringInput("Enter owner name: ",
-                [this](const std::string& s) { return validateName(s); });
-
-            bool nameExists = false;
-            for (const auto& owner : owners) {
-                if (owner.name == name) {
-                    nameExists = true;
-                    break;
-                }
-            }
-            if (nameExists) {
-                std::cout << "An owner with this name already exists. Please use a different name.\n";
-                break;
-            }
-
-            int age = getValidatedInput<int>("Enter owner age: ",
-                [](int a) { return a >= 18 && a <= 120; });
-            std::string address = getValidatedStringInput("Enter address: ",
-                [this](const std::string& s) { return validateAddress(s); });
-            std::string phone = getValidatedStringInput("Enter phone (11 digits): ",
-                [this](const std::string& s) { return validatePhone(s); });
-            std::string email = getValidatedStringInput("Enter email: ",
-                [this](const std::string& s) { return validateEmail(s); });
-            std::string password = getValidatedStringInput("Enter password (min 6 characters): ",
-                [this](const std::string& s) { return validatePassword(s); });
-
-            owners.push_back(Owner(name, age, address, phone, email, security::simpleEncrypt(password)));
-            saveData();
-            std::cout << "Owner added successfully!\n";
-            break;
-        }
-        case 3: {
-            if (role != "admin" && role != "staff") {
-                std::cout << "Access denied.\n";
-                break;
-            }
-            std::string name = getValidatedStringInput("Enter owner name to update: ",
-                [this](const std::string& s) { return validateName(s); });
-            bool found = false;
-            for (auto& owner : owners) {
-                if (owner.name == name) {
-                    found = true;
-                    std::cout << "Current details:\n";
-                    std::cout << "Name: " << owner.name << "\nAge: " << owner.age
-                        << "\nAddress: " << owner.address << "\nPhone: " << owner.phone
-                        << "\nEmail: " << owner.email << "\n";
-
-                    std::string newAddress = getValidatedStringInput("Enter new address: ",
-                        [this](const std::string& s) { return validateAddress(s); });
-                    std::string newPhone = getValidatedStringInput("Enter new phone: ",
-                        [this](const std::string& s) { return validatePhone(s); });
-                    std::string newEmail = getValidatedStringInput("Enter new email: ",
-                        [this](const std::string& s) { return validateEmail(s); });
-
-                    owner.address = newAddress;
-                    owner.phone = newPhone;
-                    owner.email = newEmail;
-
-                    for (auto& appt : appointments) {
-                        if (appt.owner.name == name) {
-                            appt.owner = owner;
-                        }
-                    }
-
-                    saveData();
-                    std::cout << "Owner updated successfully!\n";
-                    break;
-                }
-            }
-            if (!found) std::cout << "Owner not found.\n";
-            break;
-        }
-        case 4: {
-            if (role != "admin") {
-                std::cout << "Access denied. Admin only.\n";
-                break;
-            }
-            std::string name = getValidatedStringInput("Enter owner name to delete: ",
-                [this](const std::string& s) { return validateName(s); });
-            bool found = false;
-            for (auto it = owners.begin(); it != owners.end(); ++it) {
-                if (it->name == name) {
-                    found = true;
-
-                    // Remove all appointments for this owner
-                    std::vector<Appointment> updatedAppointments;
-                    for (const auto& appt : appointments) {
-                        if (appt.owner.name != name) {
-                            updatedAppointments.push_back(appt);
-                        }
-                    }
-                    appointments = updatedAppointments;
-
-                    owners.erase(it);
-                    saveData();
-                    std::cout << "Owner deleted successfully!\n";
-                    break;
-                }
-            }
-            if (!found) std::cout << "Owner not found.\n";
-            break;
-        }
-        }
-    }
-}
-
-void VMS::displayMenu(const std::string& role) {
-    updateAllAppointmentStatuses(); // Update appointment statuses first
-
-    std::vector<std::string> options;
-
-    if (role == "admin") {
-        options = { "View Profile", "Pets Menu", "Appointments Menu", "Owners Menu" };
-    }
-    else if (role == "vet") {
-        options = { "View Profile", "Pets Menu", "Appointments Menu" };
-    }
-    else if (role == "staff") {
-        options = { "View Profile", "Pets Menu", "Appointments Menu", "Owners Menu" };
-    }
-    else {
-        // Customer menu
-        displayCustomerMenu(role);
-        return;
-    }
-
-    while (true) {
-        int choice = displayRoleMenu("Main Menu", options, options.size());
-        if (choice == -1) {
-            return; // Exit to login screen
-        }
-
-        switch (choice) {
-        case 1:
-            // View Profile
-            std::cout << "\nCurrent Role: " <<
-                (role == "admin" ? "Administrator" :
-                    role == "vet" ? "Veterinarian" :
-                    role == "staff" ? "Staff Member" : "Customer") << "\n";
-            break;
-        case 2:
-            displayPetsMenu(role);
-            break;
-        case 3:
-            displayAppointmentMenu(role);
-            break;
-        case 4:
-            if (role == "admin" || role == "staff") {
-                displayOwnersMenu(role);
-            }
-            break;
-        }
-    }
-}
-
-void VMS::saveData() {
-    try {
-        updateAllAppointmentStatuses(); // Update statuses before saving
-
-        // Save owners
-        std::ofstream ownerFile("owners.csv");
-        if (!ownerFile.is_open()) {
-            throw FileWriteException("owners.csv");
-        }
-        for (const auto& owner : owners) {
-            ownerFile << owner.toCSV() << "\n";
-        }
-        ownerFile.close();
-
-        // Save pets
-        std::ofstream petFile("pets.csv");
-        if (!petFile.is_open()) {
-            throw FileWriteException("pets.csv");
-        }
-        for (const auto& owner : owners) {
-            for (const auto& pet : owner.pets) {
-                petFile << csv_utils::escapeCSV(owner.name) << "," << pet.toCSV() << "\n";
-            }
-        }
-        petFile.close();
-
-        // Save appointments
-        std::ofstream apptFile("appointments.csv");
-        if (!apptFile.is_open()) {
-            throw FileWriteException("appointments.csv");
-        }
-        for (const auto& appt : appointments) {
-            apptFile << appt.toCSV() << "\n";
-        }
-        apptFile.close();
-
-    }
-    catch (const FileWriteException& e) {
-        std::cerr << "Error saving data: " << e.what() << std::endl;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Unexpected error saving data: " << e.what() << std::endl;
-    }
-}
-
-void VMS::loadData() {
-    try {
-        // Load owners
-        std::ifstream ownerFile("owners.csv");
-        if (ownerFile.is_open()) {
-            std::string line;
-            while (getline(ownerFile, line)) {
-                if (!line.empty()) {
-                    owners.push_back(Owner::fromCSV(line));
-                }
-            }
-            ownerFile.close();
-        }
-
-        // Load pets
-        std::ifstream petFile("pets.csv");
-        if (petFile.is_open()) {
-            std::string line;
-            while (getline(petFile, line)) {
-                if (!line.empty()) {
-                    size_t commaPos = line.find(',');
-                    std::string ownerName = csv_utils::unescapeCSV(line.substr(0, commaPos));
-                    std::string petData = line.substr(commaPos + 1);
-
-                    for (auto& owner : owners) {
-                        if (owner.name == ownerName) {
-                            owner.addPet(Pet::fromCSV(petData));
-                            break;
-                        }
-                    }
-                }
-            }
-            petFile.close();
-        }
-
-        // Load appointments
-        std::ifstream apptFile("appointments.csv");
-        if (apptFile.is_open()) {
-            std::string line;
-            while (getline(apptFile, line)) {
-                if (!line.empty()) {
-                    appointments.push_back(Appointment::fromCSV(line, owners));
-                }
-            }
-            apptFile.close();
-        }
-
-        updateAllAppointmentStatuses(); // Update statuses after loading
-
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error loading data: " << e.what() << std::endl;
-    }
-}
-
-// Explicit template instantiations
-template int VMS::getValidInput<int>(const std::string&, std::function<bool(const int&)>);
-template bool VMS::getValidInput<bool>(const std::string&, std::function<bool(const bool&)>);
-template int VMS::getValidatedInput<int>(const std::string&, std::function<bool(const int&)>);
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "vms.h"
+#include "exceptions.h"
+#include "csv_utils.h"
+#include "security.h"
+#include "menus.h"
+#include "stats.h"
+#include "trace.h"
+#include "memory_report.h"
+#include "checkpoint.h"
+#include "data_loader.h"
+#include "dedupe.h"
+#include "calendar.h"
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <regex>
+#include <iomanip>
+#include <mutex>
+#include <shared_mutex>
+
+// Private Helper Methods
+
+template<typename T>
+T VMS::getValidInput(const std::string& prompt, std::function<bool(const T&)> validator) {
+    T input;
+    while (true) {
+        std::cout << prompt;
+        if (std::cin >> input && validator(input)) {
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return input;
+        }
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        std::cout << "Invalid input. Please try again.\n";
+    }
+}
+
+std::string VMS::getValidStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator) {
+    std::string input;
+    while (true) {
+        std::cout << prompt;
+        std::getline(std::cin, input);
+        if (validator(input)) return input;
+        std::cout << "Invalid input. Please try again.\n";
+    }
+}
+
+bool VMS::isValidName(const std::string& name) const {
+    stats::ScopedTimer timer(stats::Op::ValidateName);
+    return std::regex_match(name, std::regex(R"(^[A-Za-z\s\-']{2,50}$)"));
+}
+
+bool VMS::isValidAddress(const std::string& address) const {
+    stats::ScopedTimer timer(stats::Op::ValidateAddress);
+    return address.length() >= 5 && address.length() <= 100;
+}
+
+bool VMS::isValidEmail(const std::string& email) const {
+    stats::ScopedTimer timer(stats::Op::ValidateEmail);
+    return std::regex_match(email, std::regex(R"(^[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,}$)"));
+}
+
+bool VMS::isValidPhone(const std::string& phone) const {
+    stats::ScopedTimer timer(stats::Op::ValidatePhone);
+    return phone.length() == 11 && std::all_of(phone.begin(), phone.end(), ::isdigit);
+}
+
+bool VMS::isValidDate(const std::string& date) const {
+    stats::ScopedTimer timer(stats::Op::ValidateDate);
+    long days;
+    return calendar::parseDate(date, days);
+}
+
+bool VMS::isValidTime(const std::string& time) const {
+    stats::ScopedTimer timer(stats::Op::ValidateTime);
+    int minutes;
+    return calendar::parseTime(time, minutes);
+}
+
+bool VMS::isValidPassword(const std::string& password) const {
+    stats::ScopedTimer timer(stats::Op::ValidatePassword);
+    return password.length() >= 6;
+}
+
+void VMS::updateAllAppointmentStatuses() {
+    if (following) return;
+    stats::ScopedTimer timer(stats::Op::UpdateStatuses);
+    trace::Span span("updateAllAppointmentStatuses");
+    Transaction tx;
+    {
+        std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+        if (stageCompletedAppointments(tx)) {
+            publishSnapshot();
+        }
+    }
+    // An appointment cancelled in between is rejected and keeps its status.
+    try {
+        commitStaged(tx, true);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error updating appointment statuses: " << e.what() << std::endl;
+    }
+}
+
+bool VMS::stageCompletedAppointments(Transaction& tx) {
+    bool orphansChanged = false;
+    for (auto& appointment : appointments) {
+        if (appointment.status != "Scheduled" || appointment.deleted || !appointment.isInPast()) {
+            continue;
+        }
+        // No mutation can name an appointment whose pet is gone, and its
+        // status follows from the clock alone, so it changes in place.
+        if (appointment.petName.empty()) {
+            analytics.statusChanged(appointment.date, "Scheduled", "Completed");
+            appointment.status = "Completed";
+            appointmentsChanged = true;
+            orphansChanged = true;
+            continue;
+        }
+        tx.updateAppointmentStatus(appointment.ownerName, appointment.petName,
+            appointment.date, appointment.time, "Completed");
+    }
+    return orphansChanged;
+}
+
+namespace {
+    // Every chunk of table copied afresh.
+    template<typename Record>
+    std::shared_ptr<const ChunkedRecords<Record>> copyChunks(const std::vector<Record>& table) {
+        typedef ChunkedRecords<Record> Chunked;
+        std::vector<typename Chunked::ChunkPtr> chunks;
+        size_t count = (table.size() + Chunked::ChunkSlots - 1) / Chunked::ChunkSlots;
+        chunks.reserve(count);
+        for (size_t chunk = 0; chunk < count; chunk++) {
+            chunks.push_back(Chunked::copy(table, chunk));
+        }
+        return std::make_shared<const Chunked>(std::move(chunks));
+    }
+
+    // previous with the chunks that hold slots copied afresh from table;
+    // the rest are shared.
+    template<typename Record>
+    std::shared_ptr<const ChunkedRecords<Record>> updateChunks(
+        const std::shared_ptr<const ChunkedRecords<Record>>& previous, const std::vector<Record>& table,
+        std::vector<size_t> slots) {
+        typedef ChunkedRecords<Record> Chunked;
+        if (slots.empty()) {
+            return previous;
+        }
+        std::sort(slots.begin(), slots.end());
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+        std::vector<typename Chunked::ChunkPtr> chunks = previous->chunks();
+        for (size_t first = 0; first < slots.size();) {
+            size_t chunk = slots[first] / Chunked::ChunkSlots;
+            size_t last = first;
+            while (last < slots.size() && slots[last] / Chunked::ChunkSlots == chunk) {
+                last++;
+            }
+            if (chunks.size() <= chunk) {
+                chunks.resize(chunk + 1, std::make_shared<const typename Chunked::Chunk>());
+            }
+            chunks[chunk] = Chunked::overlay(chunks[chunk], table, chunk, slots.data() + first, slots.data() + last);
+            first = last;
+        }
+        return std::make_shared<const Chunked>(std::move(chunks));
+    }
+
+    void insertSorted(std::vector<size_t>& positions, size_t position) {
+        if (positions.empty() || positions.back() < position) {
+            positions.push_back(position);
+        }
+        else {
+            positions.insert(std::lower_bound(positions.begin(), positions.end(), position), position);
+        }
+    }
+
+    void eraseSorted(std::vector<size_t>& positions, size_t position) {
+        auto it = std::lower_bound(positions.begin(), positions.end(), position);
+        if (it != positions.end() && *it == position) {
+            positions.erase(it);
+        }
+    }
+}
+
+void VMS::publishSnapshot() {
+    std::shared_ptr<const Snapshot> previous = std::atomic_load(&published);
+    bool ownersDirty = ownersChanged.exchange(false) || !previous;
+    bool appointmentsDirty = appointmentsChanged.exchange(false) || !previous;
+    bool namesDirty = !previous || previous->names != nameFilter;
+    if (!ownersDirty && !appointmentsDirty && !namesDirty) {
+        return;
+    }
+    installSnapshot(ownersDirty ? copyChunks(owners) : previous->owners,
+        appointmentsDirty ? copyChunks(appointments) : previous->appointments, journal.lastSequence());
+}
+
+void VMS::publishSnapshot(const UndoLog& changes, uint64_t journalSequence) {
+    std::shared_ptr<const Snapshot> previous = std::atomic_load(&published);
+    std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+    installSnapshot(updateChunks(previous->owners, owners, changes.ownerSlots),
+        updateChunks(previous->appointments, appointments, changes.appointmentSlots), journalSequence);
+}
+
+void VMS::installSnapshot(std::shared_ptr<const Snapshot::Owners> nextOwners,
+    std::shared_ptr<const Snapshot::Appointments> nextAppointments, uint64_t journalSequence) {
+    std::shared_ptr<const Snapshot> previous = std::atomic_load(&published);
+    auto next = std::make_shared<Snapshot>();
+    next->version = previous ? previous->version + 1 : 1;
+    next->journalSequence = journalSequence;
+    next->owners = std::move(nextOwners);
+    next->appointments = std::move(nextAppointments);
+    next->names = nameFilter;
+
+    std::atomic_store(&published, std::shared_ptr<const Snapshot>(next));
+}
+
+void VMS::touchOwner(const Owner& owner, UndoLog* undo) {
+    if (undo) {
+        undo->ownerSlots.push_back(static_cast<size_t>(&owner - owners.data()));
+    }
+}
+
+void VMS::touchAppointment(const Appointment& appt, UndoLog* undo) {
+    if (undo) {
+        undo->appointmentSlots.push_back(static_cast<size_t>(&appt - appointments.data()));
+    }
+}
+
+void VMS::rebuildIndexes() {
+    appointmentsByDay.clear();
+    ownerSlots.clear();
+    ownerAppointments.assign(owners.size(), std::vector<size_t>());
+    duplicateOwnerNames = false;
+    for (size_t i = 0; i < owners.size(); i++) {
+        if (!owners[i].deleted && !ownerSlots.emplace(owners[i].name, i).second) {
+            duplicateOwnerNames = true;
+        }
+    }
+    for (size_t i = 0; i < appointments.size(); i++) {
+        if (!appointments[i].deleted) {
+            indexAppointment(i);
+        }
+    }
+}
+
+void VMS::indexAppointment(size_t slot) {
+    const Appointment& appt = appointments[slot];
+    insertSorted(appointmentsByDay[appt.date], slot);
+    auto owner = ownerSlots.find(appt.ownerName);
+    if (owner != ownerSlots.end()) {
+        insertSorted(ownerAppointments[owner->second], slot);
+    }
+}
+
+void VMS::unindexAppointment(size_t slot) {
+    const Appointment& appt = appointments[slot];
+    auto day = appointmentsByDay.find(appt.date);
+    if (day != appointmentsByDay.end()) {
+        eraseSorted(day->second, slot);
+        if (day->second.empty()) {
+            appointmentsByDay.erase(day);
+        }
+    }
+    auto owner = ownerSlots.find(appt.ownerName);
+    if (owner != ownerSlots.end()) {
+        eraseSorted(ownerAppointments[owner->second], slot);
+    }
+}
+
+void VMS::setOwnerDeleted(size_t slot, bool deleted) {
+    Owner& owner = owners[slot];
+    owner.deleted = deleted;
+    if (deleted) {
+        ownerSlots.erase(owner.name);
+        if (duplicateOwnerNames) {
+            // Only possible with hand-edited CSV files: the next owner with
+            // the name is found from now on, as before the delete.
+            for (size_t i = slot + 1; i < owners.size(); i++) {
+                if (!owners[i].deleted && owners[i].name == owner.name) {
+                    ownerSlots.emplace(owner.name, i);
+                    break;
+                }
+            }
+        }
+        analytics.ownerRemoved(owner);
+        for (const auto& pet : owner.pets) {
+            analytics.petRemoved(pet);
+        }
+        deletedOwners++;
+    }
+    else {
+        ownerSlots[owner.name] = slot;
+        analytics.ownerAdded(owner);
+        for (const auto& pet : owner.pets) {
+            analytics.petAdded(pet);
+        }
+        deletedOwners--;
+    }
+}
+
+void VMS::setAppointmentDeleted(size_t slot, bool deleted) {
+    Appointment& appt = appointments[slot];
+    if (deleted) {
+        unindexAppointment(slot);
+        analytics.appointmentRemoved(appt.date, appt.status);
+        deletedAppointments++;
+    }
+    else {
+        indexAppointment(slot);
+        analytics.appointmentAdded(appt.date, appt.status);
+        deletedAppointments--;
+    }
+    appt.deleted = deleted;
+}
+
+std::vector<size_t> VMS::deleteAppointments(size_t ownerSlot, const std::string* petName, UndoLog* undo) {
+    std::vector<size_t> removed;
+    for (size_t index : ownerAppointments[ownerSlot]) {
+        if (!petName || appointments[index].petName == *petName) {
+            removed.push_back(index);
+        }
+    }
+    for (size_t index : removed) {
+        setAppointmentDeleted(index, true);
+        touchAppointment(appointments[index], undo);
+    }
+    return removed;
+}
+
+bool VMS::compactionDue() const {
+    return (deletedOwners > 0 && deletedOwners * 4 >= owners.size())
+        || (deletedAppointments > 0 && deletedAppointments * 4 >= appointments.size());
+}
+
+bool VMS::compact(bool force) {
+    if (deletedOwners == 0 && deletedAppointments == 0) return false;
+    if (!force && !compactionDue()) return false;
+    trace::Span span("compact");
+
+    owners.erase(std::remove_if(owners.begin(), owners.end(),
+        [](const Owner& owner) { return owner.deleted; }), owners.end());
+    appointments.erase(std::remove_if(appointments.begin(), appointments.end(),
+        [](const Appointment& appt) { return appt.deleted; }), appointments.end());
+    // Give back what the tombstones made the tables grow by, without
+    // undoing the headroom of ordinary growth.
+    if (owners.capacity() > 2 * owners.size()) owners.shrink_to_fit();
+    if (appointments.capacity() > 2 * appointments.size()) appointments.shrink_to_fit();
+    deletedOwners = 0;
+    deletedAppointments = 0;
+    rebuildIndexes();
+    // Slots have moved, so the next version is copied whole.
+    ownersChanged = true;
+    appointmentsChanged = true;
+    return true;
+}
+
+void VMS::rebuildNameFilter(bool force) {
+    if (!force && nameFilter && nameFilter->size() <= nameFilter->capacity()
+        && staleFilterKeys * 4 <= nameFilter->size()) return;
+    trace::Span span("rebuildNameFilter");
+
+    size_t keys = 0;
+    for (const auto& owner : owners) {
+        if (!owner.deleted) keys += 1 + owner.pets.size();
+    }
+    // Room for the data to double before the filter fills up.
+    nameFilter = std::make_shared<BloomFilter>(2 * keys);
+    staleFilterKeys = 0;
+    for (const auto& owner : owners) {
+        if (!owner.deleted) addNames(owner);
+    }
+}
+
+void VMS::addNames(const Owner& owner) {
+    if (!nameFilter) return;
+    nameFilter->add(BloomFilter::hashOf(owner.name));
+    for (const auto& pet : owner.pets) {
+        nameFilter->add(BloomFilter::hashOf(owner.name, pet.name));
+    }
+}
+
+void VMS::setArchiveHorizon(int days) {
+    archiveAfterDays = days;
+}
+
+void VMS::setFollowing(bool follow) {
+    following = follow;
+}
+
+void VMS::archiveOldAppointments() {
+    if (archiveAfterDays <= 0) return;
+    trace::Span span("archiveOldAppointments");
+
+    std::string cutoff = calendar::civilFromDays(calendar::today() - archiveAfterDays);
+
+    // Completed and cancelled are final states, so archived rows never
+    // need to change again.
+    std::vector<ArchivedAppointment> old;
+    auto hot = std::stable_partition(appointments.begin(), appointments.end(),
+        [&cutoff](const Appointment& appt) { return appt.status == "Scheduled" || appt.date >= cutoff; });
+    for (auto it = hot; it != appointments.end(); ++it) {
+        old.push_back(ArchivedAppointment{ it->ownerName, it->petName, it->date, it->time, it->status });
+    }
+    if (old.empty()) return;
+
+    appointments.erase(hot, appointments.end());
+    rebuildIndexes();
+    appointmentsChanged = true;
+    std::shared_ptr<const Snapshot> current = std::atomic_load(&published);
+    archive.add(std::move(old), current ? current->version + 1 : 1);
+}
+
+void VMS::countArchived(Analytics& counters) const {
+    archive.countByDay([&counters](const std::string& date, const std::string& status, long count) {
+        counters.addArchived(date, status, count);
+    });
+}
+
+void VMS::printAppointmentHistory(const Snapshot& view, const std::string& ownerName,
+    const std::string& petName) const {
+    std::vector<ArchivedAppointment> rows;
+    for (const auto& appt : *view.appointments) {
+        if (appt.petName == petName && appt.ownerName == ownerName) {
+            rows.push_back(ArchivedAppointment{ ownerName, petName, appt.date, appt.time, appt.status });
+        }
+    }
+    archive.forPet(ownerName, petName, [&rows](const ArchivedAppointment& row) {
+        rows.push_back(row);
+    });
+
+    if (rows.empty()) {
+        std::cout << "No appointment history found for this pet.\n";
+        return;
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const ArchivedAppointment& a, const ArchivedAppointment& b) {
+        return a.date != b.date ? a.date < b.date : a.time < b.time;
+    });
+    for (const auto& row : rows) {
+        std::cout << "Date: " << row.date << " | Time: " << row.time
+            << " | Status: " << row.status << std::endl;
+    }
+}
+
+int VMS::displayRoleMenu(const std::string& title, const std::vector<std::string>& options, int maxOptions) {
+    return ui::displayRoleMenu(title, options, maxOptions);
+}
+
+bool VMS::isDateTimeInFuture(const std::string& date, const std::string& time) const {
+    long long start;
+    if (!calendar::parseDateTime(date, time, start)) return false;
+    return start * 60 > calendar::localSeconds();
+}
+
+bool VMS::hasTimeConflict(const std::string& date, const std::string& time) const {
+    stats::ScopedTimer timer(stats::Op::TimeConflict);
+    auto day = appointmentsByDay.find(date);
+    if (day == appointmentsByDay.end()) return false;
+
+    for (size_t index : day->second) {
+        const Appointment& appt = appointments[index];
+        if (appt.time == time && appt.status != "Cancelled") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VMS::isDuplicateAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) const {
+    auto day = appointmentsByDay.find(date);
+    if (day == appointmentsByDay.end()) return false;
+
+    for (size_t index : day->second) {
+        const Appointment& appt = appointments[index];
+        if (appt.ownerName == ownerName &&
+            appt.petName == petName &&
+            appt.date == date &&
+            appt.time == time &&
+            appt.status != "Cancelled") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VMS::isValidStatusTransition(const std::string& currentStatus, const std::string& newStatus) {
+    if (currentStatus == newStatus) return true;
+
+    if (currentStatus == "Scheduled") {
+        return newStatus == "Completed" || newStatus == "Cancelled";
+    }
+    else if (currentStatus == "Completed") {
+        return false;
+    }
+    else if (currentStatus == "Cancelled") {
+        return false;
+    }
+
+    return false;
+}
+
+bool VMS::isVaccinationStatusAppropriate(int petAge, bool isVaccinated) {
+    if (petAge < 1 && !isVaccinated) {
+        return true;
+    }
+    return true;
+}
+
+Owner* VMS::findOwner(const std::string& ownerName) {
+    stats::ScopedTimer timer(stats::Op::OwnerLookup);
+    auto slot = ownerSlots.find(ownerName);
+    return slot == ownerSlots.end() ? nullptr : &owners[slot->second];
+}
+
+Pet* VMS::findPet(Owner& owner, const std::string& petName) {
+    stats::ScopedTimer timer(stats::Op::PetLookup);
+    for (auto& pet : owner.pets) {
+        if (pet.name == petName) {
+            return &pet;
+        }
+    }
+    return nullptr;
+}
+
+Appointment* VMS::findAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) {
+    auto day = appointmentsByDay.find(date);
+    if (day == appointmentsByDay.end()) return nullptr;
+
+    for (size_t index : day->second) {
+        Appointment& appt = appointments[index];
+        if (appt.ownerName == ownerName && appt.petName == petName && appt.time == time) {
+            return &appt;
+        }
+    }
+    return nullptr;
+}
+
+// Public Methods
+
+std::shared_ptr<const Snapshot> VMS::snapshot() const {
+    std::shared_ptr<const Snapshot> current = std::atomic_load(&published);
+    if (!current) {
+        auto empty = std::make_shared<Snapshot>();
+        empty->owners = std::make_shared<const Snapshot::Owners>();
+        empty->appointments = std::make_shared<const Snapshot::Appointments>();
+        return empty;
+    }
+    return current;
+}
+
+memory::Report VMS::measureMemory() const {
+    std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+    return memory::measure(owners, appointments);
+}
+
+bool VMS::validateCustomerLogin(const std::string& name, const std::string& password) const {
+    waitForCredentials();
+    if (credentials.verifyCustomer(name, password)) {
+        return true;
+    }
+    // Passwords still in the legacy cipher are only rehashed by the full
+    // load; check again once it is done.
+    if (dataReady.valid() && dataReady.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        waitForData();
+        return credentials.verifyCustomer(name, password);
+    }
+    return false;
+}
+
+bool VMS::authenticateStaff(const std::string& role, const std::string& password) {
+    waitForCredentials();
+    return credentials.verifyStaff(role, password);
+}
+
+bool VMS::customerExists(const std::string& name) const {
+    waitForCredentials();
+    return credentials.hasCustomer(name);
+}
+
+bool VMS::validateName(const std::string& name) const {
+    return isValidName(name);
+}
+
+bool VMS::validateAddress(const std::string& address) const {
+    return isValidAddress(address);
+}
+
+bool VMS::validateEmail(const std::string& email) const {
+    return isValidEmail(email);
+}
+
+bool VMS::validatePhone(const std::string& phone) const {
+    return isValidPhone(phone);
+}
+
+bool VMS::validateDate(const std::string& date) const {
+    return isValidDate(date);
+}
+
+bool VMS::validateTime(const std::string& time) const {
+    return isValidTime(time);
+}
+
+bool VMS::validatePassword(const std::string& password) const {
+    return isValidPassword(password);
+}
+
+std::string VMS::getValidatedStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator) {
+    return getValidStringInput(prompt, validator);
+}
+
+template<typename T>
+T VMS::getValidatedInput(const std::string& prompt, std::function<bool(const T&)> validator) {
+    return getValidInput<T>(prompt, validator);
+}
+
+// Transactions
+//
+// commit() takes every lock the staged mutations need up front, in the
+// order documented in striped_locks.h, and holds them until the journal
+// record is written and the new version published. Other transactions therefore never see (or build on)
+// changes that might still be rolled back. The operations below assume
+// those locks are held; they only take storageMutex themselves.
+
+void VMS::commit(Transaction& tx) {
+    waitForData();
+    commitStaged(tx, false);
+}
+
+std::vector<CommitFailure> VMS::commitValid(Transaction& tx) {
+    waitForData();
+    return commitStaged(tx, true);
+}
+
+std::vector<CommitFailure> VMS::commitStaged(Transaction& tx, bool skipRejected) {
+    trace::Span span("commit");
+    std::vector<CommitFailure> failures;
+    const std::vector<Mutation>& mutations = tx.mutations();
+    if (mutations.empty()) return failures;
+
+    bool structural = false;
+    std::vector<std::string> ownerKeys, dayKeys;
+    for (const auto& mutation : mutations) {
+        structural = structural || mutation.isStructural();
+        ownerKeys.push_back(mutation.ownerKey());
+        std::string day = mutation.dayKey();
+        if (!day.empty()) {
+            dayKeys.push_back(day);
+        }
+    }
+
+    bool compacting = false;
+    {
+        std::unique_lock<std::shared_timed_mutex> exclusive(structureMutex, std::defer_lock);
+        std::shared_lock<std::shared_timed_mutex> shared(structureMutex, std::defer_lock);
+        std::unique_ptr<StripeGuard> ownerLock, dayLock;
+        if (structural) {
+            exclusive.lock();
+        }
+        else {
+            shared.lock();
+            ownerLock.reset(new StripeGuard(ownerLocks, ownerKeys));
+            dayLock.reset(new StripeGuard(dayLocks, dayKeys));
+        }
+
+        UndoLog undo;
+        std::string payload;
+        std::vector<Mutation> applied;
+        for (size_t i = 0; i < mutations.size(); i++) {
+            try {
+                applyMutation(mutations[i], &undo, false);
+                mutations[i].encode(payload);
+                applied.push_back(mutations[i]);
+            }
+            catch (const OperationFailedException& e) {
+                if (!skipRejected) {
+                    rollback(undo);
+                    throw;
+                }
+                failures.push_back(CommitFailure{ i, e.what() });
+            }
+            catch (...) {
+                rollback(undo);
+                throw;
+            }
+        }
+
+        if (payload.empty()) {
+            return failures;
+        }
+        // Held from the journal write to the snapshot so the feed and the
+        // versions see commits in journal order.
+        std::lock_guard<std::mutex> order(feedOrderMutex);
+        uint64_t sequence;
+        try {
+            sequence = journal.append(payload);
+        }
+        catch (...) {
+            rollback(undo);
+            throw;
+        }
+        feed.publish(sequence, applied);
+        reminders.apply(applied);
+
+        // Every change applied so far has been journaled, so the snapshot
+        // cannot include work that is later rolled back. The stripes still
+        // keep other commits off the slots this one wrote, and commits on
+        // other owners and days carry on meanwhile.
+        if (structural) {
+            rebuildNameFilter(false);
+        }
+        publishSnapshot(undo, sequence);
+        std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+        compacting = compactionDue();
+    }
+    // Compacting takes the exclusive lock, so it runs on the checkpoint
+    // thread rather than holding up this session.
+    if (compacting) {
+        requestCompaction();
+    }
+    tx.clear();
+
+    // Keep replay after a crash short: checkpoint once the journal grows
+    // past a few megabytes. The checkpoint runs from the snapshot just
+    // published, so commits carry on meanwhile.
+    if (journal.size() >= CheckpointJournalBytes) {
+        requestCheckpoint();
+    }
+    return failures;
+}
+
+void VMS::applyReplicated(uint64_t journalSequence, const std::vector<Mutation>& mutations) {
+    trace::Span span("apply replicated commit");
+    {
+        std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+        UndoLog undo;
+        std::string payload;
+        std::vector<Mutation> applied;
+        for (const auto& mutation : mutations) {
+            try {
+                applyMutation(mutation, &undo, true);
+                mutation.encode(payload);
+                applied.push_back(mutation);
+            }
+            catch (const OperationFailedException& e) {
+                std::cerr << "Replicated record " << journalSequence << " (" << mutation.name() << "): "
+                    << e.what() << std::endl;
+            }
+        }
+
+        // Journaled even if nothing applied, so the position is kept.
+        std::lock_guard<std::mutex> order(feedOrderMutex);
+        try {
+            journal.append(payload, journalSequence);
+        }
+        catch (...) {
+            rollback(undo);
+            throw;
+        }
+        feed.publish(journalSequence, applied);
+        reminders.apply(applied);
+        rebuildNameFilter(false);
+        publishSnapshot(undo, journalSequence);
+        if (compactionDue()) {
+            requestCompaction();
+        }
+    }
+
+    if (journal.size() >= CheckpointJournalBytes) {
+        requestCheckpoint();
+    }
+}
+
+uint64_t VMS::lastCommittedSequence() const {
+    return journal.lastSequence();
+}
+
+void VMS::rollback(UndoLog& undo) {
+    trace::Span span("rollback");
+    while (!undo.steps.empty()) {
+        undo.steps.back()();
+        undo.steps.pop_back();
+    }
+}
+
+void VMS::applyMutation(const Mutation& mutation, UndoLog* undo, bool replaying) {
+    const std::vector<std::string>& f = mutation.fields;
+    switch (mutation.type) {
+    case Mutation::Type::RegisterOwner: {
+        Owner owner(f[0], std::stoi(f[1]), f[2], f[3], f[4], f[5]);
+        owner.registered = f[6];
+        registerOwner(std::move(owner), undo);
+        break;
+    }
+    case Mutation::Type::UpdateOwner:
+        updateOwnerContact(f[0], f[1], f[2], f[3], undo);
+        break;
+    case Mutation::Type::DeleteOwner:
+        deleteOwner(f[0], undo);
+        break;
+    case Mutation::Type::AddPet:
+        addPet(f[0], Pet(f[1], f[2], std::stoi(f[3]), f[4], f[5] == "1"), undo);
+        break;
+    case Mutation::Type::UpdatePet:
+        updatePet(f[0], f[1], f[2], f[3] == "1", undo);
+        break;
+    case Mutation::Type::DeletePet:
+        deletePet(f[0], f[1], undo);
+        break;
+    case Mutation::Type::AddNote:
+        addMedicalNote(f[0], f[1], f[2], undo);
+        break;
+    case Mutation::Type::SetHistory:
+        replaceMedicalHistory(f[0], f[1], f[2], undo);
+        break;
+    case Mutation::Type::Schedule:
+        scheduleAppointment(f[0], f[1], f[2], f[3], undo, replaying);
+        break;
+    case Mutation::Type::SetStatus:
+        updateAppointmentStatus(f[0], f[1], f[2], f[3], f[4], undo, replaying);
+        break;
+    case Mutation::Type::Cancel:
+        cancelAppointment(f[0], f[1], f[2], f[3], undo);
+        break;
+    }
+}
+
+// Operations
+//
+// Each one validates before it changes anything, so a rejected operation
+// leaves no trace. When undo is given, the inverse change is recorded;
+// rollback runs those in reverse, so each one sees exactly the state its
+// operation left behind.
+
+void VMS::registerOwner(Owner owner, UndoLog* undo) {
+    trace::Span span("registerOwner");
+    if (findOwner(owner.name)) {
+        throw OperationFailedException("An owner with this name already exists. Please use a different name.");
+    }
+    credentials.setCustomer(owner.name, owner.password);
+    analytics.ownerAdded(owner);
+    std::string name = owner.name;
+    ownerSlots.emplace(name, owners.size());
+    owners.push_back(std::move(owner));
+    ownerAppointments.emplace_back();
+    addNames(owners.back());
+    touchOwner(owners.back(), undo);
+
+    if (undo) {
+        undo->steps.push_back([this, name]() {
+            analytics.ownerRemoved(owners.back());
+            staleFilterKeys += 1 + owners.back().pets.size();
+            ownerSlots.erase(name);
+            owners.pop_back();
+            ownerAppointments.pop_back();
+            credentials.removeCustomer(name);
+        });
+    }
+}
+
+void VMS::updateOwnerContact(const std::string& name, const std::string& address,
+    const std::string& phone, const std::string& email, UndoLog* undo) {
+    trace::Span span("updateOwnerContact");
+    Owner* owner = findOwner(name);
+    if (!owner) {
+        throw OperationFailedException("Owner not found.");
+    }
+
+    if (undo) {
+        std::string oldAddress = owner->address, oldPhone = owner->phone, oldEmail = owner->email;
+        undo->steps.push_back([this, name, oldAddress, oldPhone, oldEmail]() {
+            updateOwnerContact(name, oldAddress, oldPhone, oldEmail, nullptr);
+        });
+    }
+
+    owner->address = address;
+    owner->phone = phone;
+    owner->email = email;
+    touchOwner(*owner, undo);
+}
+
+void VMS::deleteOwner(const std::string& name, UndoLog* undo) {
+    trace::Span span("deleteOwner");
+    stats::ScopedTimer timer(stats::Op::DeleteOwner);
+    auto found = ownerSlots.find(name);
+    if (found == ownerSlots.end()) {
+        throw OperationFailedException("Owner not found.");
+    }
+    size_t slot = found->second;
+
+    // The owner's appointments go first, while the owner still indexes them.
+    std::vector<size_t> removed = deleteAppointments(slot, nullptr, undo);
+    setOwnerDeleted(slot, true);
+    touchOwner(owners[slot], undo);
+    credentials.removeCustomer(name);
+    staleFilterKeys += 1 + owners[slot].pets.size();
+
+    if (undo) {
+        undo->steps.push_back([this, slot, removed]() {
+            setOwnerDeleted(slot, false);
+            for (size_t index : removed) {
+                setAppointmentDeleted(index, false);
+            }
+            credentials.setCustomer(owners[slot].name, owners[slot].password);
+            staleFilterKeys -= 1 + owners[slot].pets.size();
+        });
+    }
+}
+
+void VMS::addPet(const std::string& ownerName, Pet pet, UndoLog* undo) {
+    trace::Span span("addPet");
+    Owner* owner = findOwner(ownerName);
+    if (!owner) {
+        throw OperationFailedException("Owner not found.");
+    }
+    analytics.petAdded(pet);
+    if (nameFilter) {
+        nameFilter->add(BloomFilter::hashOf(ownerName, pet.name));
+    }
+    owner->addPet(std::move(pet));
+    touchOwner(*owner, undo);
+
+    if (undo) {
+        undo->steps.push_back([this, ownerName]() {
+            std::vector<Pet>& pets = findOwner(ownerName)->pets;
+            analytics.petRemoved(pets.back());
+            staleFilterKeys++;
+            pets.pop_back();
+        });
+    }
+}
+
+void VMS::updatePet(const std::string& ownerName, const std::string& petName,
+    const LazyText& medicalHistory, bool vaccinated, UndoLog* undo) {
+    trace::Span span("updatePet");
+    Owner* owner = findOwner(ownerName);
+    Pet* pet = owner ? findPet(*owner, petName) : nullptr;
+    if (!pet) {
+        throw OperationFailedException("Pet not found.");
+    }
+
+    if (undo) {
+        LazyText oldHistory = pet->medicalHistory;
+        bool oldVaccinated = pet->vaccinated;
+        undo->steps.push_back([this, ownerName, petName, oldHistory, oldVaccinated]() {
+            updatePet(ownerName, petName, oldHistory, oldVaccinated, nullptr);
+        });
+    }
+
+    analytics.vaccinationChanged(*pet, vaccinated);
+    pet->medicalHistory = medicalHistory;
+    pet->vaccinated = vaccinated;
+    touchOwner(*owner, undo);
+}
+
+void VMS::deletePet(const std::string& ownerName, const std::string& petName, UndoLog* undo) {
+    trace::Span span("deletePet");
+    stats::ScopedTimer timer(stats::Op::DeletePet);
+    auto found = ownerSlots.find(ownerName);
+    if (found != ownerSlots.end()) {
+        size_t slot = found->second;
+        std::vector<Pet>& pets = owners[slot].pets;
+        for (auto itPet = pets.begin(); itPet != pets.end(); ++itPet) {
+            if (itPet->name == petName) {
+                // A pet is only ever one of a handful, so it is erased
+                // outright; its appointments are tombstoned.
+                std::vector<size_t> removed = deleteAppointments(slot, &petName, undo);
+                analytics.petRemoved(*itPet);
+
+                if (undo) {
+                    size_t position = static_cast<size_t>(itPet - pets.begin());
+                    undo->steps.push_back([this, slot, position, deleted = std::move(*itPet), removed]() {
+                        std::vector<Pet>& restored = owners[slot].pets;
+                        restored.insert(restored.begin() + position, deleted);
+                        analytics.petAdded(deleted);
+                        staleFilterKeys--;
+                        for (size_t index : removed) {
+                            setAppointmentDeleted(index, false);
+                        }
+                    });
+                }
+                pets.erase(itPet);
+                touchOwner(owners[slot], undo);
+                staleFilterKeys++;
+                return;
+            }
+        }
+    }
+    throw OperationFailedException("Pet not found.");
+}
+
+void VMS::addMedicalNote(const std::string& ownerName, const std::string& petName,
+    const std::string& entry, UndoLog* undo) {
+    trace::Span span("addMedicalNote");
+    Owner* owner = findOwner(ownerName);
+    Pet* pet = owner ? findPet(*owner, petName) : nullptr;
+    if (!pet) {
+        throw OperationFailedException("Pet not found.");
+    }
+
+    std::string history = pet->medicalHistory.str();
+    if (!history.empty()) {
+        history += "\n\n";
+    }
+    history += entry;
+    replaceMedicalHistory(ownerName, petName, history, undo);
+}
+
+void VMS::replaceMedicalHistory(const std::string& ownerName, const std::string& petName,
+    const LazyText& medicalHistory, UndoLog* undo) {
+    trace::Span span("replaceMedicalHistory");
+    Owner* owner = findOwner(ownerName);
+    Pet* pet = owner ? findPet(*owner, petName) : nullptr;
+    if (!pet) {
+        throw OperationFailedException("Pet not found.");
+    }
+
+    if (undo) {
+        LazyText oldHistory = pet->medicalHistory;
+        undo->steps.push_back([this, ownerName, petName, oldHistory]() {
+            replaceMedicalHistory(ownerName, petName, oldHistory, nullptr);
+        });
+    }
+
+    pet->medicalHistory = medicalHistory;
+    touchOwner(*owner, undo);
+}
+
+void VMS::scheduleAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time, UndoLog* undo, bool replaying) {
+    trace::Span span("scheduleAppointment");
+    stats::ScopedTimer timer(stats::Op::Schedule);
+    if (!replaying && !isDateTimeInFuture(date, time)) {
+        throw OperationFailedException("Error: Cannot schedule appointments in the past.");
+    }
+
+    {
+        std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+        if (hasTimeConflict(date, time)) {
+            throw OperationFailedException("Error: There is already an appointment at this time.");
+        }
+
+        if (isDuplicateAppointment(ownerName, petName, date, time)) {
+            throw OperationFailedException("Error: This pet already has an appointment at this time.");
+        }
+    }
+
+    Owner* owner = findOwner(ownerName);
+    Pet* pet = owner ? findPet(*owner, petName) : nullptr;
+    if (!pet) {
+        throw OperationFailedException("Owner/pet not found.");
+    }
+
+    // The day stripe keeps other bookings for this date out between the
+    // conflict check above and the insert below.
+    std::unique_lock<std::shared_timed_mutex> storage(storageMutex);
+    appointments.emplace_back(date, time, petName, ownerName, "Scheduled");
+    size_t slot = appointments.size() - 1;
+    indexAppointment(slot);
+    touchAppointment(appointments[slot], undo);
+    analytics.appointmentAdded(date, "Scheduled");
+
+    if (undo) {
+        // Transactions on other days may append after it, so the slot is
+        // tombstoned rather than popped.
+        undo->steps.push_back([this, slot]() {
+            std::unique_lock<std::shared_timed_mutex> storage(storageMutex);
+            setAppointmentDeleted(slot, true);
+        });
+    }
+}
+
+void VMS::updateAppointmentStatus(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time, const std::string& newStatus,
+    UndoLog* undo, bool replaying) {
+    trace::Span span("updateAppointmentStatus");
+    std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+
+    Appointment* appt = findAppointment(ownerName, petName, date, time);
+    if (!appt) {
+        throw OperationFailedException("Appointment not found.");
+    }
+
+    if (newStatus != "Scheduled" && newStatus != "Completed" && newStatus != "Cancelled") {
+        throw OperationFailedException("Invalid status " + newStatus + ".");
+    }
+    // A replayed change was checked when it was committed; the clock and
+    // the automatic status sweep may disagree with it now.
+    if (!replaying) {
+        if (newStatus == "Scheduled" && appt->isInPast()) {
+            throw OperationFailedException("Cannot set a past appointment to Scheduled status.");
+        }
+        if (!isValidStatusTransition(appt->status, newStatus)) {
+            throw OperationFailedException("Invalid status transition from " + appt->status + " to " + newStatus + ".");
+        }
+    }
+
+    if (undo) {
+        recordStatusUndo(*appt, *undo);
+    }
+    analytics.statusChanged(date, appt->status, newStatus);
+    appt->status = newStatus;
+    touchAppointment(*appt, undo);
+}
+
+void VMS::cancelAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time, UndoLog* undo) {
+    trace::Span span("cancelAppointment");
+    std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+
+    Appointment* appt = findAppointment(ownerName, petName, date, time);
+    if (!appt) {
+        throw OperationFailedException("Appointment not found.");
+    }
+
+    if (undo) {
+        recordStatusUndo(*appt, *undo);
+    }
+    analytics.statusChanged(date, appt->status, "Cancelled");
+    appt->status = "Cancelled";
+    touchAppointment(*appt, undo);
+}
+
+void VMS::recordStatusUndo(const Appointment& appt, UndoLog& undo) {
+    std::string ownerName = appt.ownerName, petName = appt.petName;
+    std::string date = appt.date, time = appt.time, oldStatus = appt.status;
+    undo.steps.push_back([this, ownerName, petName, date, time, oldStatus]() {
+        std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+        Appointment* appt = findAppointment(ownerName, petName, date, time);
+        analytics.statusChanged(date, appt->status, oldStatus);
+        appt->status = oldStatus;
+    });
+}
+
+void VMS::viewPetAppointmentHistory() {
+    trace::Span span("viewPetAppointmentHistory");
+    std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+        [this](const std::string& s) { return validateName(s); });
+    std::string petName = getValidatedStringInput("Enter pet's name: ",
+        [this](const std::string& s) { return validateName(s); });
+
+    std::cout << "\nAppointment History for " << petName << ":\n";
+    printAppointmentHistory(*snapshot(), ownerName, petName);
+}
+
+void VMS::viewPetMedicalHistory(const std::string& role) {
+    trace::Span span("viewPetMedicalHistory");
+    std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+        [this](const std::string& s) { return validateName(s); });
+    std::string petName = getValidatedStringInput("Enter pet's name: ",
+        [this](const std::string& s) { return validateName(s); });
+
+    std::shared_ptr<const Snapshot> view = snapshot();
+    const Pet* pet = view->findPet(ownerName, petName);
+    if (!pet) {
+        std::cout << "Pet not found.\n";
+        return;
+    }
+
+    std::cout << "\n--- Medical History for " << pet->name << " ---\n";
+    std::cout << "Owner: " << ownerName << "\n";
+    std::cout << "Breed: " << pet->breed << "\n";
+    std::cout << "Age: " << pet->age << "\n";
+    std::cout << "Vaccination Status: " << (pet->vaccinated ? "Vaccinated" : "Not Vaccinated") << "\n";
+    std::cout << "\nMedical History:\n";
+
+    if (pet->medicalHistory.empty()) {
+        std::cout << "No medical history recorded.\n";
+    }
+    else {
+        std::cout << pet->medicalHistory << "\n";
+    }
+
+    if (role == "admin" || role == "vet") {
+        std::cout << "\nAppointment History:\n";
+        printAppointmentHistory(*snapshot(), ownerName, petName);
+
+        std::cout << "\nMedical History Management Options:\n";
+        std::cout << "1. Add new entry to medical history\n";
+        std::cout << "2. Replace entire medical history\n";
+        std::cout << "3. Return to previous menu\n";
+
+        int choice = getValidatedInput<int>("Enter choice (1-3): ",
+            [](int c) { return c >= 1 && c <= 3; });
+
+        if (choice == 3) {
+            return;
+        }
+
+        try {
+            if (choice == 1) {
+                std::string newMedHist = getValidatedStringInput("Enter new medical history entry: ",
+                    [](const std::string&) { return true; });
+                Transaction tx;
+                tx.addMedicalNote(ownerName, petName, newMedHist);
+                commit(tx);
+                std::cout << "Medical history updated successfully!\n";
+            }
+            else if (choice == 2) {
+                std::string newMedHist = getValidatedStringInput("Enter new comprehensive medical history: ",
+                    [](const std::string&) { return true; });
+                Transaction tx;
+                tx.replaceMedicalHistory(ownerName, petName, newMedHist);
+                commit(tx);
+                std::cout << "Medical history replaced successfully!\n";
+            }
+        }
+        catch (const OperationFailedException& e) {
+            std::cout << e.what() << "\n";
+        }
+        catch (const FileWriteException& e) {
+            std::cout << e.what() << "\n";
+        }
+    }
+}
+
+void VMS::displayCustomerMenu(const std::string& customerName) {
+    std::vector<std::string> options = {
+        "View My Profile",
+        "View My Pets",
+        "View My Appointments",
+        "Add New Pet",
+        "Schedule Appointment",
+        "View Pet Appointment History"
+    };
+    int maxFunctionalOption = options.size();
+
+    while (true) {
+        // Looked up in a fresh snapshot each time round, so the record
+        // cannot move or change while the menu uses it.
+        std::shared_ptr<const Snapshot> view = snapshot();
+        const Owner* customer = view->findOwner(customerName);
+        if (!customer) {
+            std::cout << "Customer not found!\n";
+            return;
+        }
+
+        std::cout << "\n--- Customer Menu (" << customerName << ") ---\n";
+        for (size_t i = 0; i < options.size(); i++) {
+            std::cout << (i + 1) << ". " << options[i] << "\n";
+        }
+        int exitOption = options.size() + 1;
+        std::cout << exitOption << ". Back to Main Menu\n";
+
+        int choice = getValidatedInput<int>("Enter choice: ",
+            [maxFunctionalOption, exitOption](int c) {
+                return (c >= 1 && c <= maxFunctionalOption) || c == exitOption;
+            });
+
+        if (choice == exitOption) return;
+
+        switch (choice) {
+        case 1: {
+            std::cout << "\nYour Profile:\n";
+            std::cout << "Name: " << customer->name << "\n";
+            std::cout << "Age: " << customer->age << "\n";
+            std::cout << "Address: " << customer->address << "\n";
+            std::cout << "Phone: " << customer->phone << "\n";
+            std::cout << "Email: " << customer->email << "\n";
+            break;
+        }
+        case 2: {
+            if (customer->pets.empty()) {
+                std::cout << "You have no pets registered.\n";
+            }
+            else {
+                std::cout << "\nYour Pets:\n";
+                for (const auto& pet : customer->pets) {
+                    std::cout << "- " << pet.name << " (" << pet.breed << "), Age: " << pet.age
+                        << ", Vaccinated: " << (pet.vaccinated ? "Yes" : "No") << "\n";
+                }
+            }
+            break;
+        }
+        case 3: {
+            bool found = false;
+            std::cout << "\nYour Appointments:\n";
+            for (const auto& appt : *view->appointments) {
+                if (appt.ownerName == customerName) {
+                    found = true;
+                    std::cout << "Date: " << appt.date << " | Time: " << appt.time
+                        << " | Pet: " << appt.petName << " | Status: " << appt.status << std::endl;
+                }
+            }
+            if (!found) std::cout << "No appointments found.\n";
+            break;
+        }
+        case 4: {
+            std::string name = getValidatedStringInput("Enter pet name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string breed = getValidatedStringInput("Enter pet breed: ",
+                [this](const std::string& s) { return validateName(s); });
+            int age = getValidatedInput<int>("Enter pet age: ",
+                [](int a) { return a > 0 && a < 30; });
+            std::string medHist = getValidatedStringInput("Enter medical history: ",
+                [](const std::string&) { return true; });
+            bool vaccinated = getValidatedInput<bool>("Is pet vaccinated? (1 for Yes, 0 for No): ",
+                [](bool) { return true; });
+
+            if (!isVaccinationStatusAppropriate(age, vaccinated)) {
+                std::cout << "Warning: Vaccination status may not be appropriate for this pet's age.\n";
+                std::string confirm = getValidatedStringInput("Continue anyway? (y/n): ",
+                    [](const std::string& s) { return s == "y" || s == "n"; });
+                if (confirm == "n") break;
+            }
+
+            try {
+                Transaction tx;
+                tx.addPet(customer->name, Pet(name, breed, age, medHist, vaccinated));
+                commit(tx);
+                std::cout << "Pet added successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 5: {
+            if (customer->pets.empty()) {
+                std::cout << "You need to add a pet first!\n";
+                break;
+            }
+
+            std::cout << "Select a pet:\n";
+            for (size_t i = 0; i < customer->pets.size(); i++) {
+                std::cout << i + 1 << ". " << customer->pets[i].name << "\n";
+            }
+            int petChoice = getValidatedInput<int>("Enter pet number: ",
+                [customer](int c) { return c > 0 && c <= static_cast<int>(customer->pets.size()); });
+
+            std::string date = getValidatedStringInput("Enter date (YYYY-MM-DD): ",
+                [this](const std::string& s) { return validateDate(s); });
+            std::string time = getValidatedStringInput("Enter time (HH:MM): ",
+                [this](const std::string& s) { return validateTime(s); });
+
+            try {
+                Transaction tx;
+                tx.scheduleAppointment(customer->name, customer->pets[petChoice - 1].name, date, time);
+                commit(tx);
+                std::cout << "Appointment scheduled successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 6: {
+            if (customer->pets.empty()) {
+                std::cout << "You have no pets registered.\n";
+                break;
+            }
+
+            std::cout << "Select a pet to view appointment history:\n";
+            for (size_t i = 0; i < customer->pets.size(); i++) {
+                std::cout << i + 1 << ". " << customer->pets[i].name << "\n";
+            }
+            int petChoice = getValidatedInput<int>("Enter pet number: ",
+                [customer](int c) { return c > 0 && c <= static_cast<int>(customer->pets.size()); });
+
+            std::string petName = customer->pets[petChoice - 1].name;
+            std::cout << "\nAppointment History for " << petName << ":\n";
+            printAppointmentHistory(*view, customer->name, petName);
+            break;
+        }
+        }
+    }
+}
+
+void VMS::displayPetsMenu(const std::string& role) {
+    std::vector<std::string> options = { "View All Pets", "View Pet Medical History" };
+    int maxFunctionalOption = 2;
+
+    if (role == "admin" || role == "staff") {
+        options.push_back("Update Pet");
+        maxFunctionalOption = 3;
+    }
+    if (role == "admin") {
+        options.push_back("Delete Pet");
+        maxFunctionalOption = 4;
+    }
+
+    while (true) {
+        int choice = displayRoleMenu("Pets Menu", options, maxFunctionalOption);
+        if (choice == -1) return;
+
+        switch (choice) {
+        case 1: {
+            std::shared_ptr<const Snapshot> view = snapshot();
+            if (view->owners->empty()) {
+                std::cout << "No owners found.\n";
+            }
+            else {
+                for (const auto& owner : *view->owners) {
+                    if (!owner.pets.empty()) {
+                        std::cout << "\nOwner: " << owner.name << "\n";
+                        for (const auto& pet : owner.pets) {
+                            std::cout << "- " << pet.name << " (" << pet.breed << "), Age: " << pet.age
+                                << ", Vaccinated: " << (pet.vaccinated ? "Yes" : "No") << "\n";
+                        }
+                    }
+                }
+            }
+            break;
+        }
+        case 2: {
+            viewPetMedicalHistory(role);
+            break;
+        }
+        case 3: {
+            if (role != "admin" && role != "staff") {
+                std::cout << "Access denied.\n";
+                break;
+            }
+            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string petName = getValidatedStringInput("Enter pet's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::shared_ptr<const Snapshot> view = snapshot();
+            const Pet* pet = view->findPet(ownerName, petName);
+            if (!pet) {
+                std::cout << "Pet not found.\n";
+                break;
+            }
+            std::cout << "Current pet details:\n";
+            std::cout << "Name: " << pet->name << "\nBreed: " << pet->breed << "\nAge: " << pet->age
+                << "\nMedical History: " << pet->medicalHistory << "\nVaccinated: "
+                << (pet->vaccinated ? "Yes" : "No") << "\n";
+
+            std::string newMedHist = getValidatedStringInput("Enter new medical history: ",
+                [](const std::string&) { return true; });
+            bool newVaccinated = getValidatedInput<bool>("Update vaccination status? (1 for Yes, 0 for No): ",
+                [](bool) { return true; });
+
+            try {
+                Transaction tx;
+                tx.updatePet(ownerName, petName, newMedHist, newVaccinated);
+                commit(tx);
+                std::cout << "Pet updated successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 4: {
+            if (role != "admin") {
+                std::cout << "Access denied. Admin only.\n";
+                break;
+            }
+            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string petName = getValidatedStringInput("Enter pet's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            try {
+                Transaction tx;
+                tx.deletePet(ownerName, petName);
+                commit(tx);
+                std::cout << "Pet deleted successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        }
+    }
+}
+
+void VMS::displayAppointmentMenu(const std::string& role) {
+    std::vector<std::string> options = { "View All Appointments" };
+    int maxFunctionalOption = 1;
+    if (role == "admin" || role == "staff") {
+        options.push_back("Schedule Appointment");
+        options.push_back("Update Appointment");
+        maxFunctionalOption = 3;
+    }
+    if (role == "admin" || role == "vet") {
+        options.push_back("Cancel Appointment");
+        maxFunctionalOption = 4;
+    }
+
+    while (true) {
+        int choice = displayRoleMenu("Appointments Menu", options, maxFunctionalOption);
+        if (choice == -1) return;
+
+        switch (choice) {
+        case 1: {
+            std::shared_ptr<const Snapshot> view = snapshot();
+            if (view->appointments->empty()) {
+                std::cout << "No appointments found.\n";
+            }
+            else {
+                for (const auto& appt : *view->appointments) {
+                    std::cout << "Date: " << appt.date << " | Time: " << appt.time
+                        << " | Pet: " << appt.petName << " | Owner: " << appt.ownerName
+                        << " | Status: " << appt.status << "\n";
+                }
+            }
+            break;
+        }
+        case 2: {
+            if (role != "admin" && role != "staff") {
+                std::cout << "Access denied.\n";
+                break;
+            }
+            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string petName = getValidatedStringInput("Enter pet's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string date = getValidatedStringInput("Enter date (YYYY-MM-DD): ",
+                [this](const std::string& s) { return validateDate(s); });
+            std::string time = getValidatedStringInput("Enter time (HH:MM): ",
+                [this](const std::string& s) { return validateTime(s); });
+
+            try {
+                Transaction tx;
+                tx.scheduleAppointment(ownerName, petName, date, time);
+                commit(tx);
+                std::cout << "Appointment scheduled successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 3: {
+            if (role != "admin" && role != "staff") {
+                std::cout << "Access denied.\n";
+                break;
+            }
+            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string petName = getValidatedStringInput("Enter pet's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string date = getValidatedStringInput("Enter appointment date: ",
+                [this](const std::string& s) { return validateDate(s); });
+            std::string time = getValidatedStringInput("Enter appointment time: ",
+                [this](const std::string& s) { return validateTime(s); });
+
+            // commit checks the transition again against the live data.
+            std::shared_ptr<const Snapshot> view = snapshot();
+            const Appointment* appt = view->findAppointment(ownerName, petName, date, time);
+            if (!appt) {
+                std::cout << "Appointment not found.\n";
+                break;
+            }
+
+            std::string newStatus = getValidatedStringInput("Enter new status (Scheduled/Completed/Cancelled): ",
+                [appt, this](const std::string& s) {
+                    if (s == "Scheduled" && appt->isInPast()) {
+                        std::cout << "Cannot set a past appointment to Scheduled status.\n";
+                        return false;
+                    }
+                    if (!isValidStatusTransition(appt->status, s)) {
+                        std::cout << "Invalid status transition from " << appt->status << " to " << s << ".\n";
+                        return false;
+                    }
+                    return s == "Scheduled" || s == "Completed" || s == "Cancelled";
+                });
+
+            try {
+                Transaction tx;
+                tx.updateAppointmentStatus(ownerName, petName, date, time, newStatus);
+                commit(tx);
+                std::cout << "Appointment updated successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 4: {
+            if (role != "admin" && role != "vet") {
+                std::cout << "Access denied. Admin/vet only.\n";
+                break;
+            }
+            std::string ownerName = getValidatedStringInput("Enter owner's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string petName = getValidatedStringInput("Enter pet's name: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::string date = getValidatedStringInput("Enter appointment date: ",
+                [this](const std::string& s) { return validateDate(s); });
+            std::string time = getValidatedStringInput("Enter appointment time: ",
+                [this](const std::string& s) { return validateTime(s); });
+
+            try {
+                Transaction tx;
+                tx.cancelAppointment(ownerName, petName, date, time);
+                commit(tx);
+                std::cout << "Appointment cancelled successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        }
+    }
+}
+
+void VMS::displayOwnersMenu(const std::string& role) {
+    std::vector<std::string> options = { "View All Owners" };
+    int maxFunctionalOption = 1;
+
+    if (role == "admin" || role == "staff") {
+        options.push_back("Add New Owner");
+        options.push_back("Update Owner");
+        maxFunctionalOption = 3;
+    }
+    if (role == "admin") {
+        options.push_back("Delete Owner");
+        maxFunctionalOption = 4;
+    }
+
+    while (true) {
+        int choice = displayRoleMenu("Owners Menu", options, maxFunctionalOption);
+        if (choice == -1) return;
+
+        switch (choice) {
+        case 1: {
+            std::shared_ptr<const Snapshot> view = snapshot();
+            if (view->owners->empty()) {
+                std::cout << "No owners found.\n";
+            }
+            else {
+                for (const auto& owner : *view->owners) {
+                    std::cout << "\nName: " << owner.name << "\nAge: " << owner.age
+                        << "\nAddress: " << owner.address << "\nPhone: " << owner.phone
+                        << "\nEmail: " << owner.email << "\n";
+                }
+            }
+            break;
+        }
+        case 2: {
+            if (role != "admin" && role != "staff") {
+                std::cout << "Access denied.\n";
+                break;
+            }
+            std::string name = getValidatedStringInput("Enter owner name: ",
+                [this](const std::string& s) { return validateName(s); });
+
+            if (snapshot()->findOwner(name)) {
+                std::cout << "An owner with this name already exists. Please use a different name.\n";
+                break;
+            }
+
+            int age = getValidatedInput<int>("Enter owner age: ",
+                [](int a) { return a >= 18 && a <= 120; });
+            std::string address = getValidatedStringInput("Enter address: ",
+                [this](const std::string& s) { return validateAddress(s); });
+            std::string phone = getValidatedStringInput("Enter phone (11 digits): ",
+                [this](const std::string& s) { return validatePhone(s); });
+            std::string email = getValidatedStringInput("Enter email: ",
+                [this](const std::string& s) { return validateEmail(s); });
+
+            std::shared_ptr<const Snapshot> view = snapshot();
+            std::vector<dedupe::Match> similar = dedupe::findSimilar(*view->owners, name, phone, email);
+            if (!similar.empty()) {
+                std::cout << "This customer may already be registered as:\n";
+                for (const auto& match : similar) {
+                    const Owner& owner = (*view->owners)[match.second];
+                    std::cout << "  " << owner.name << " (" << owner.phone << ", " << owner.email << "): "
+                        << dedupe::describe(match.reason) << "\n";
+                }
+                bool proceed = getValidatedInput<bool>("Register as a new customer anyway? (1 for Yes, 0 for No): ",
+                    [](bool) { return true; });
+                if (!proceed) break;
+            }
+
+            std::string password = getValidatedStringInput("Enter password (min 6 characters): ",
+                [this](const std::string& s) { return validatePassword(s); });
+
+            try {
+                Transaction tx;
+                tx.registerOwner(Owner(name, age, address, phone, email, security::hashPassword(password)));
+                commit(tx);
+                std::cout << "Owner added successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 3: {
+            if (role != "admin" && role != "staff") {
+                std::cout << "Access denied.\n";
+                break;
+            }
+            std::string name = getValidatedStringInput("Enter owner name to update: ",
+                [this](const std::string& s) { return validateName(s); });
+            std::shared_ptr<const Snapshot> view = snapshot();
+            const Owner* owner = view->findOwner(name);
+            if (!owner) {
+                std::cout << "Owner not found.\n";
+                break;
+            }
+            std::cout << "Current details:\n";
+            std::cout << "Name: " << owner->name << "\nAge: " << owner->age
+                << "\nAddress: " << owner->address << "\nPhone: " << owner->phone
+                << "\nEmail: " << owner->email << "\n";
+
+            std::string newAddress = getValidatedStringInput("Enter new address: ",
+                [this](const std::string& s) { return validateAddress(s); });
+            std::string newPhone = getValidatedStringInput("Enter new phone: ",
+                [this](const std::string& s) { return validatePhone(s); });
+            std::string newEmail = getValidatedStringInput("Enter new email: ",
+                [this](const std::string& s) { return validateEmail(s); });
+
+            try {
+                Transaction tx;
+                tx.updateOwnerContact(name, newAddress, newPhone, newEmail);
+                commit(tx);
+                std::cout << "Owner updated successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        case 4: {
+            if (role != "admin") {
+                std::cout << "Access denied. Admin only.\n";
+                break;
+            }
+            std::string name = getValidatedStringInput("Enter owner name to delete: ",
+                [this](const std::string& s) { return validateName(s); });
+            try {
+                Transaction tx;
+                tx.deleteOwner(name);
+                commit(tx);
+                std::cout << "Owner deleted successfully!\n";
+            }
+            catch (const OperationFailedException& e) {
+                std::cout << e.what() << "\n";
+            }
+            catch (const FileWriteException& e) {
+                std::cout << e.what() << "\n";
+            }
+            break;
+        }
+        }
+    }
+}
+
+void VMS::displayStatisticsMenu() {
+    std::vector<std::string> options = { "View Statistics", "Memory Usage", "Dump Statistics to File", "Reset Statistics" };
+
+    while (true) {
+        int choice = displayRoleMenu("System Statistics", options, options.size());
+        if (choice == -1) return;
+
+        switch (choice) {
+        case 1:
+            stats::printReport(std::cout);
+            break;
+        case 2:
+            memory::printReport(measureMemory(), std::cout);
+            std::cout << "Archived appointments (on disk): " << archive.size() << "\n";
+            if (lazy_text::enabled()) {
+                lazy_text::CacheStats cache = lazy_text::cacheStats();
+                std::cout << "Medical histories left on disk: " << cache.entries << ", cache "
+                    << cache.cachedBytes << " of " << cache.capacityBytes << " bytes, "
+                    << cache.hits << " hits, " << cache.misses << " misses\n";
+            }
+            break;
+        case 3: {
+            std::string filename = getValidatedStringInput("Enter file name: ",
+                [](const std::string& s) { return !s.empty(); });
+            std::ofstream file(filename);
+            if (!file.is_open()) {
+                std::cout << FileWriteException(filename).what() << "\n";
+                break;
+            }
+            stats::printReport(file);
+            memory::printReport(measureMemory(), file);
+            std::cout << "Statistics written to " << filename << ".\n";
+            break;
+        }
+        case 4:
+            stats::reset();
+            std::cout << "Statistics reset.\n";
+            break;
+        }
+    }
+}
+
+void VMS::displayReportsMenu() {
+    std::vector<std::string> options = { "Appointments by Day and Week", "Cancellation Rate",
+        "Vaccination Coverage", "New Customers", "Verify Counters", "Possible Duplicate Customers" };
+
+    auto printCounts = [](const std::string& label, const Analytics::AppointmentCounts& counts) {
+        std::cout << label << ": " << counts.total() << " appointments (" << counts.scheduled << " scheduled, "
+            << counts.completed << " completed, " << counts.cancelled << " cancelled)\n";
+    };
+
+    while (true) {
+        int choice = displayRoleMenu("Reports", options, options.size());
+        if (choice == -1) return;
+
+        switch (choice) {
+        case 1: {
+            std::string date = getValidatedStringInput("Enter date (YYYY-MM-DD): ",
+                [this](const std::string& s) { return validateDate(s); });
+            printCounts(date, analytics.day(date));
+            printCounts("Week of " + Analytics::weekOf(date), analytics.week(date));
+            break;
+        }
+        case 2: {
+            Analytics::AppointmentCounts totals = analytics.totals();
+            printCounts("All", totals);
+            if (totals.total() > 0) {
+                std::ios::fmtflags flags = std::cout.flags();
+                std::cout << std::fixed << std::setprecision(1) << "Cancellation rate: "
+                    << 100.0 * totals.cancelled / totals.total() << "%\n";
+                std::cout.flags(flags);
+            }
+            break;
+        }
+        case 3: {
+            std::vector<Analytics::Coverage> rows = analytics.coverage();
+            if (rows.empty()) {
+                std::cout << "No pets registered.\n";
+                break;
+            }
+            std::ios::fmtflags flags = std::cout.flags();
+            std::cout << std::fixed << std::setprecision(1);
+            for (const auto& row : rows) {
+                std::cout << row.breed << ", aged " << Analytics::ageBandName(row.ageBand) << ": "
+                    << row.vaccinated << " of " << row.pets << " vaccinated ("
+                    << 100.0 * row.vaccinated / row.pets << "%)\n";
+            }
+            std::cout.flags(flags);
+            break;
+        }
+        case 4: {
+            std::string date = getValidatedStringInput("Enter date (YYYY-MM-DD): ",
+                [this](const std::string& s) { return validateDate(s); });
+            Analytics::Customers customers = analytics.customers(date);
+            std::cout << "Registered on " << date << ": " << customers.onDay << "\n"
+                << "Registered in week of " << Analytics::weekOf(date) << ": " << customers.inWeek << "\n"
+                << "All customers: " << customers.total << " (" << customers.undated
+                << " registered before dates were recorded)\n";
+            break;
+        }
+        case 5: {
+            // Recount under the exclusive lock so no commit is half applied.
+            Analytics recount;
+            std::vector<std::string> differences;
+            {
+                std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+                if (compact(true)) {
+                    publishSnapshot();
+                }
+                recount.rebuild(owners, appointments);
+                countArchived(recount);
+                differences = analytics.compare(recount);
+            }
+            if (differences.empty()) {
+                std::cout << "All counters match a full recount.\n";
+            }
+            for (const auto& difference : differences) {
+                std::cout << difference << "\n";
+            }
+            break;
+        }
+        case 6: {
+            std::shared_ptr<const Snapshot> view = snapshot();
+            dedupe::printReport(std::cout, *view->owners, dedupe::findDuplicates(*view->owners), 20);
+            break;
+        }
+        }
+    }
+}
+
+void VMS::displayMenu(const std::string& role) {
+    waitForData();
+    updateAllAppointmentStatuses(); // Update appointment statuses first
+
+    std::vector<std::string> options;
+
+    if (role == "admin") {
+        options = { "View Profile", "Pets Menu", "Appointments Menu", "Owners Menu", "System Statistics", "Reports" };
+    }
+    else if (role == "vet") {
+        options = { "View Profile", "Pets Menu", "Appointments Menu" };
+    }
+    else if (role == "staff") {
+        options = { "View Profile", "Pets Menu", "Appointments Menu", "Owners Menu" };
+    }
+    else {
+        // Customer menu
+        displayCustomerMenu(role);
+        return;
+    }
+
+    while (true) {
+        int choice = displayRoleMenu("Main Menu", options, options.size());
+        if (choice == -1) {
+            return; // Exit to login screen
+        }
+
+        switch (choice) {
+        case 1:
+            // View Profile
+            std::cout << "\nCurrent Role: " <<
+                (role == "admin" ? "Administrator" :
+                    role == "vet" ? "Veterinarian" :
+                    role == "staff" ? "Staff Member" : "Customer") << "\n";
+            break;
+        case 2:
+            displayPetsMenu(role);
+            break;
+        case 3:
+            displayAppointmentMenu(role);
+            break;
+        case 4:
+            if (role == "admin" || role == "staff") {
+                displayOwnersMenu(role);
+            }
+            break;
+        case 5:
+            if (role == "admin") {
+                displayStatisticsMenu();
+            }
+            break;
+        case 6:
+            if (role == "admin") {
+                displayReportsMenu();
+            }
+            break;
+        }
+    }
+}
+
+void VMS::saveData() {
+    waitForData();
+    stats::ScopedTimer timer(stats::Op::SaveData);
+    trace::Span span("saveData");
+    try {
+        updateAllAppointmentStatuses(); // Update statuses before saving
+        {
+            std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+            compact(true);  // the checkpoint rewrites the files anyway
+            archiveOldAppointments();
+            rebuildNameFilter(false);
+            publishSnapshot();
+        }
+        writeCheckpoint();
+    }
+    catch (const FileWriteException& e) {
+        std::cerr << "Error saving data: " << e.what() << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Unexpected error saving data: " << e.what() << std::endl;
+    }
+}
+
+void VMS::writeCheckpoint() {
+    std::lock_guard<std::mutex> saving(saveMutex);
+    std::shared_ptr<const Snapshot> view = snapshot();
+
+    // Appointments archived since the last checkpoint leave
+    // appointments.csv and enter their segment in the same step.
+    std::vector<std::pair<std::string, std::string>> extraFiles(1);
+    if (!archive.prepareSegment(view->version, view->journalSequence, extraFiles[0].first, extraFiles[0].second)) {
+        extraFiles.clear();
+    }
+    uint64_t fallback;
+    try {
+        fallback = checkpoint::write(*view, extraFiles);
+    }
+    catch (...) {
+        if (!extraFiles.empty()) archive.segmentWritten(false);
+        throw;
+    }
+    if (!extraFiles.empty()) archive.segmentWritten(true);
+    // The journal is how loadData re-publishes events the feed did not
+    // get to write, so they must be on disk before it is compacted. It
+    // keeps what the previous checkpoint lacks, in case recover() has to
+    // fall back to it.
+    feed.flush();
+    journal.compact(fallback);
+}
+
+void VMS::requestCheckpoint() {
+    requestBackgroundWork(checkpointRequested);
+}
+
+void VMS::requestCompaction() {
+    requestBackgroundWork(compactionRequested);
+}
+
+void VMS::requestBackgroundWork(bool& requested) {
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    if (!checkpointThread.joinable()) {
+        checkpointThread = std::thread(&VMS::checkpointLoop, this);
+    }
+    requested = true;
+    checkpointWake.notify_one();
+}
+
+void VMS::checkpointLoop() {
+    trace::nameThread("checkpoint");
+    std::unique_lock<std::mutex> lock(checkpointMutex);
+    while (true) {
+        checkpointWake.wait(lock, [this]() { return checkpointRequested || compactionRequested || stopping; });
+        if (stopping) return;
+        bool checkpointing = checkpointRequested, compacting = compactionRequested;
+        checkpointRequested = false;
+        compactionRequested = false;
+
+        lock.unlock();
+        if (compacting) {
+            trace::Span span("background compaction");
+            std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+            if (compact(false)) {
+                publishSnapshot();
+            }
+        }
+        if (checkpointing) {
+            try {
+                trace::Span span("background checkpoint");
+                writeCheckpoint();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Background checkpoint failed: " << e.what() << std::endl;
+            }
+        }
+        lock.lock();
+    }
+}
+
+VMS::~VMS() {
+    reminders.stop();
+    {
+        std::lock_guard<std::mutex> lock(checkpointMutex);
+        stopping = true;
+        checkpointWake.notify_one();
+    }
+    if (checkpointThread.joinable()) {
+        checkpointThread.join();
+    }
+    if (loaderThread.joinable()) {
+        loaderThread.join();
+    }
+}
+
+void VMS::recoverCheckpoint() {
+    if (!recovered) {
+        checkpointed = checkpoint::recover();
+        recovered = true;
+    }
+}
+
+void VMS::startLoading(std::function<void()> prepare) {
+    // On the caller's thread, so a data set that cannot be recovered stops
+    // the program before the login prompt.
+    recoverCheckpoint();
+    credentialsReady = credentialsLoaded.get_future().share();
+    dataReady = dataLoaded.get_future().share();
+    loaderThread = std::thread([this, prepare]() {
+        trace::nameThread("loader");
+        try {
+            prepare();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error preparing startup: " << e.what() << std::endl;
+        }
+        loadData();
+        signalCredentials();  // if loading failed before getting that far
+        dataLoaded.set_value();
+    });
+}
+
+void VMS::waitForCredentials() const {
+    if (credentialsReady.valid()) {
+        credentialsReady.wait();
+    }
+}
+
+void VMS::waitForData() const {
+    if (dataReady.valid() && dataReady.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        std::cout << "Loading data, please wait...\n";
+        dataReady.wait();
+    }
+}
+
+void VMS::startReminders() {
+    auto seed = [this]() {
+        if (dataReady.valid()) {
+            dataReady.wait();
+        }
+        std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+        for (const auto& appt : appointments) {
+            if (!appt.deleted && appt.status == "Scheduled") {
+                reminders.restore(appt.ownerName, appt.petName, appt.date, appt.time);
+            }
+        }
+    };
+    // Runs on the reminder thread, so it takes the locks a commit would.
+    auto check = [this](Reminder& reminder) {
+        std::shared_lock<std::shared_timed_mutex> structure(structureMutex);
+        StripeGuard ownerLock(ownerLocks, { reminder.ownerName });
+        StripeGuard dayLock(dayLocks, { reminder.date });
+        std::shared_lock<std::shared_timed_mutex> storage(storageMutex);
+        Appointment* appt = findAppointment(reminder.ownerName, reminder.petName, reminder.date, reminder.time);
+        if (!appt || appt->status != "Scheduled") {
+            return false;
+        }
+        if (Owner* owner = findOwner(reminder.ownerName)) {
+            reminder.phone = owner->phone;
+            reminder.email = owner->email;
+        }
+        return true;
+    };
+    reminders.start(seed, check);
+}
+
+void VMS::signalCredentials() {
+    if (credentialsReady.valid() && !credentialsSignalled) {
+        credentialsSignalled = true;
+        credentialsLoaded.set_value();
+    }
+}
+
+void VMS::loadCredentials(uint64_t checkpointed) {
+    trace::Span span("load credentials");
+    credentials.rebuildCustomers(data_loader::loadCredentials());
+    journal.scan(checkpointed, [this](uint64_t, const std::string& payload) {
+        Mutation mutation;
+        size_t pos = 0;
+        while (pos < payload.size() && Mutation::decode(payload, pos, mutation)) {
+            if (mutation.type == Mutation::Type::RegisterOwner) {
+                credentials.setCustomer(mutation.fields[0], mutation.fields[5]);
+            }
+            else if (mutation.type == Mutation::Type::DeleteOwner) {
+                credentials.removeCustomer(mutation.fields[0]);
+            }
+        }
+    });
+    signalCredentials();
+}
+
+void VMS::loadData() {
+    stats::ScopedTimer timer(stats::Op::LoadData);
+    trace::Span span("loadData");
+    std::unique_lock<std::shared_timed_mutex> structure(structureMutex);
+    recoverCheckpoint();
+    bool loaded = false;
+    try {
+        if (credentialsReady.valid()) {
+            loadCredentials(checkpointed);
+        }
+        uint64_t inFeed = feed.open();
+        archive.open();
+
+        // Load owners, pets and appointments
+        {
+            trace::Span fileSpan("load CSV files");
+            data_loader::load(owners, appointments);
+        }
+
+        rebuildIndexes();
+        rebuildNameFilter(true);
+        analytics.rebuild(owners, appointments);
+        countArchived(analytics);
+
+        // Roll forward transactions committed since the last checkpoint.
+        // Commits the feed had not written yet are published again.
+        journal.replay(checkpointed, [this, inFeed](uint64_t sequence, const std::string& payload) {
+            std::vector<Mutation> mutations;
+            Mutation mutation;
+            size_t pos = 0;
+            while (pos < payload.size()) {
+                if (!Mutation::decode(payload, pos, mutation)) {
+                    std::cerr << "Skipping malformed journal record " << sequence << std::endl;
+                    return;
+                }
+                mutations.push_back(mutation);
+            }
+            for (const auto& m : mutations) {
+                try {
+                    applyMutation(m, nullptr, true);
+                }
+                catch (const OperationFailedException& e) {
+                    std::cerr << "Journal record " << sequence << " (" << m.name() << "): " << e.what() << std::endl;
+                }
+            }
+            if (sequence > inFeed) {
+                feed.publish(sequence, mutations);
+            }
+        });
+
+        // Start from dense tables. Logins may have used the early
+        // credentials until now; these also have the rehashed legacy
+        // passwords.
+        compact(true);
+        rebuildNameFilter(false);
+        credentials.rebuildCustomers(owners);
+        loaded = true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading data: " << e.what() << std::endl;
+    }
+    // Whatever was loaded, so every later version can build on this one.
+    ownersChanged = true;
+    appointmentsChanged = true;
+    publishSnapshot();
+
+    // A commit of its own, so it runs once the locks are released.
+    structure.unlock();
+    if (loaded) {
+        updateAllAppointmentStatuses(); // Update statuses after loading
+    }
+}
+
+// Explicit template instantiations
+template int VMS::getValidInput<int>(const std::string&, std::function<bool(const int&)>);
+template bool VMS::getValidInput<bool>(const std::string&, std::function<bool(const bool&)>);
+template int VMS::getValidatedInput<int>(const std::string&, std::function<bool(const int&)>);
 template bool VMS::getValidatedInput<bool>(const std::string&, std::function<bool(const bool&)>);
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "mutation.h"
+
+namespace {
+    const char* const typeNames[] = {
+        "register-owner",
+        "update-owner",
+        "delete-owner",
+        "add-pet",
+        "update-pet",
+        "delete-pet",
+        "add-note",
+        "set-history",
+        "schedule",
+        "set-status",
+        "cancel"
+    };
+    const size_t typeCount = sizeof(typeNames) / sizeof(typeNames[0]);
+    static_assert(typeCount == static_cast<size_t>(Mutation::Type::Cancel) + 1,
+        "typeNames must have one entry per Mutation::Type");
+
+    const size_t fieldCounts[] = { 7, 4, 1, 6, 4, 2, 3, 3, 4, 5, 4 };
+}
+
+const char* Mutation::name() const {
+    return typeNames[static_cast<size_t>(type)];
+}
+
+size_t Mutation::fieldCount(Type type) {
+    return fieldCounts[static_cast<size_t>(type)];
+}
+
+std::string Mutation::dayKey() const {
+    if (type == Type::Schedule || type == Type::SetStatus || type == Type::Cancel) {
+        return fields[2];
+    }
+    return "";
+}
+
+bool Mutation::isStructural() const {
+    return type == Type::RegisterOwner || type == Type::DeleteOwner || type == Type::DeletePet;
+}
+
+void Mutation::encode(std::string& out) const {
+    out += name();
+    for (const auto& field : fields) {
+        out += '|';
+        out += std::to_string(field.size());
+        out += ':';
+        out += field;
+    }
+    out += '\n';
+}
+
+bool Mutation::decode(const std::string& data, size_t& pos, Mutation& out) {
+    size_t end = data.find_first_of("|\n", pos);
+    if (end == std::string::npos) return false;
+
+    std::string typeName = data.substr(pos, end - pos);
+    size_t type = 0;
+    while (type < typeCount && typeName != typeNames[type]) type++;
+    if (type == typeCount) return false;
+
+    out.type = static_cast<Type>(type);
+    out.fields.clear();
+    pos = end;
+    while (pos < data.size() && data[pos] == '|') {
+        size_t colon = data.find(':', pos + 1);
+        if (colon == std::string::npos || colon == pos + 1) return false;
+
+        size_t length = 0;
+        for (size_t i = pos + 1; i < colon; i++) {
+            if (data[i] < '0' || data[i] > '9') return false;
+            length = length * 10 + static_cast<size_t>(data[i] - '0');
+        }
+        if (colon + 1 + length > data.size()) return false;
+
+        out.fields.push_back(data.substr(colon + 1, length));
+        pos = colon + 1 + length;
+    }
+
+    if (pos >= data.size() || data[pos] != '\n') return false;
+    pos++;
+    return out.fields.size() == fieldCount(out.type);
+}
\ No newline at end of file
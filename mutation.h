@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// One change to the data. Transactions stage mutations, VMS applies them
+// and the journal stores them, so replaying a journal reproduces exactly
+// what was committed.
+struct Mutation {
+    enum class Type {
+        RegisterOwner,  // name, age, address, phone, email, password hash, registered
+        UpdateOwner,    // name, address, phone, email
+        DeleteOwner,    // name
+        AddPet,         // owner, pet, breed, age, medical history, vaccinated (1/0)
+        UpdatePet,      // owner, pet, medical history, vaccinated (1/0)
+        DeletePet,      // owner, pet
+        AddNote,        // owner, pet, timestamped entry
+        SetHistory,     // owner, pet, medical history
+        Schedule,       // owner, pet, date, time
+        SetStatus,      // owner, pet, date, time, status
+        Cancel          // owner, pet, date, time
+    };
+
+    Type type;
+    std::vector<std::string> fields;
+
+    const char* name() const;
+    // Number of fields a mutation of the given type carries.
+    static size_t fieldCount(Type type);
+
+    // Owner the mutation belongs to; every type has one.
+    const std::string& ownerKey() const { return fields[0]; }
+    // Calendar day touched, or empty if the mutation does not touch one.
+    std::string dayKey() const;
+    // True if it inserts or erases owners or erases appointments.
+    bool isStructural() const;
+
+    // Length-prefixed encoding: name, then "|<length>:<bytes>" per field,
+    // then '\n'. Any byte may appear in a field.
+    void encode(std::string& out) const;
+    // Decodes one mutation starting at pos and advances pos past it.
+    // Returns false if the data is malformed or truncated.
+    static bool decode(const std::string& data, size_t& pos, Mutation& out);
+};
\ No newline at end of file
@@ -1,41 +1,34 @@
-#include "owner.h"
-#include "csv_utils.h"
-#include <sstream>
-
-Owner::Owner(std::string n, int a, std::string addr, std::string ph, std::string em, std::string pw)
-    : name(n), age(a), address(addr), phone(ph), email(em), password(pw) {
-}
-
-void Owner::addPet(const Pet& pet) {
-    pets.push_back(pet);
-}
-
-std::string Owner::toCSV() const {
-    return csv_utils::escapeCSV(name) + "," +
-        std::to_string(age) + "," +
-        csv_utils::escapeCSV(address) + "," +
-        csv_utils::escapeCSV(phone) + "," +
-        csv_utils::escapeCSV(email) + "," +
-        csv_utils::escapeCSV(password);
-}
-
-Owner Owner::fromCSV(const std::string& line) {
-    std::stringstream ss(line);
-    std::string name, ageStr, address, phone, email, password;
-
-    getline(ss, name, ',');
-    getline(ss, ageStr, ',');
-    getline(ss, address, ',');
-    getline(ss, phone, ',');
-    getline(ss, email, ',');
-    getline(ss, password, ',');
-
-    return Owner(
-        csv_utils::unescapeCSV(name),
-        std::stoi(ageStr),
-        csv_utils::unescapeCSV(address),
-        csv_utils::unescapeCSV(phone),
-        csv_utils::unescapeCSV(email),
-        csv_utils::unescapeCSV(password)
-    );
+#include "owner.h"
+#include "csv_utils.h"
+#include <utility>
+
+Owner::Owner(std::string n, int a, std::string addr, std::string ph, std::string em, std::string pw)
+    : name(std::move(n)), address(std::move(addr)), phone(std::move(ph)), email(std::move(em)), password(std::move(pw)), age(a) {
+}
+
+void Owner::addPet(Pet pet) {
+    pets.push_back(std::move(pet));
+}
+
+void Owner::writeCSV(csv_utils::CsvWriter& out) const {
+    out.field(name);
+    out.field(static_cast<long long>(age));
+    out.field(address);
+    out.field(phone);
+    out.field(email);
+    out.field(password);
+    out.field(registered);
+}
+
+Owner Owner::fromCSV(const std::vector<csv_utils::CsvField>& fields) {
+    Owner owner(
+        csv_utils::fieldValue(fields, 0),
+        std::stoi(csv_utils::fieldValue(fields, 1)),
+        csv_utils::fieldValue(fields, 2),
+        csv_utils::fieldValue(fields, 3),
+        csv_utils::fieldValue(fields, 4),
+        csv_utils::fieldValue(fields, 5)
+    );
+    owner.registered = csv_utils::fieldValue(fields, 6);
+    return owner;
 }
\ No newline at end of file
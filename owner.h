@@ -1,16 +1,24 @@
-#pragma once
-#include <string>
-#include <vector>
-#include "pet.h"
-
-class Owner {
-public:
-    std::string name, address, phone, email, password;
-    int age;
-    std::vector<Pet> pets;
-
-    Owner(std::string n, int a, std::string addr, std::string ph, std::string em, std::string pw = "");
-    void addPet(const Pet& pet);
-    std::string toCSV() const;
-    static Owner fromCSV(const std::string& line);
+#pragma once
+#include <string>
+#include <vector>
+#include "pet.h"
+
+namespace csv_utils { class CsvWriter; struct CsvField; }
+
+class Owner {
+public:
+    std::string name, address, phone, email, password;
+    // Date the customer registered (YYYY-MM-DD); empty for customers
+    // created before it was recorded.
+    std::string registered;
+    int age;
+    // Tombstone: set while VMS keeps a deleted owner's slot until the next
+    // compaction. Snapshots skip deleted records.
+    bool deleted = false;
+    std::vector<Pet> pets;
+
+    Owner(std::string n, int a, std::string addr, std::string ph, std::string em, std::string pw = "");
+    void addPet(Pet pet);
+    void writeCSV(csv_utils::CsvWriter& out) const;
+    static Owner fromCSV(const std::vector<csv_utils::CsvField>& fields);
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstddef>
+
+// Runs independent pieces of work on all hardware threads (startup
+// loading). Work items must not take VMS locks.
+namespace parallel {
+    namespace detail {
+        inline std::atomic<size_t>& configuredWorkers() {
+            static std::atomic<size_t> count{ 0 };
+            return count;
+        }
+    }
+
+    // Threads forEach uses: the number set below, or else the number of
+    // hardware threads, at least 1.
+    inline size_t workerCount() {
+        size_t configured = detail::configuredWorkers().load(std::memory_order_relaxed);
+        if (configured > 0) {
+            return configured;
+        }
+        unsigned count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    // 0 restores the default.
+    inline void setWorkerCount(size_t count) {
+        detail::configuredWorkers().store(count, std::memory_order_relaxed);
+    }
+
+    // Calls work(i) for every i in [0, count) on up to workerCount()
+    // threads, the caller included. Items are handed out in order as
+    // threads become free, so uneven items still balance. If work throws,
+    // no further items are started and the first exception is rethrown
+    // once every thread has stopped.
+    template<typename Work>
+    void forEach(size_t count, Work work) {
+        std::atomic<size_t> next{ 0 };
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto run = [&]() {
+            size_t i;
+            while ((i = next.fetch_add(1)) < count) {
+                try {
+                    work(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                    next = count;
+                }
+            }
+        };
+
+        size_t threads = workerCount() < count ? workerCount() : count;
+        std::vector<std::thread> helpers;
+        for (size_t t = 1; t < threads; t++) {
+            helpers.emplace_back(run);
+        }
+        run();
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
\ No newline at end of file
@@ -1,34 +1,39 @@
-#include "pet.h"
-#include "csv_utils.h"
-#include <sstream>
-
-Pet::Pet(std::string n, std::string b, int a, std::string mh, bool v)
-    : name(n), breed(b), age(a), medicalHistory(mh), vaccinated(v) {
-}
-
-std::string Pet::toCSV() const {
-    return csv_utils::escapeCSV(name) + "," +
-        csv_utils::escapeCSV(breed) + "," +
-        std::to_string(age) + "," +
-        csv_utils::escapeCSV(medicalHistory) + "," +
-        (vaccinated ? "Yes" : "No");
-}
-
-Pet Pet::fromCSV(const std::string& line) {
-    std::stringstream ss(line);
-    std::string name, breed, ageStr, medHist, vacc;
-
-    getline(ss, name, ',');
-    getline(ss, breed, ',');
-    getline(ss, ageStr, ',');
-    getline(ss, medHist, ',');
-    getline(ss, vacc, ',');
-
-    return Pet(
-        csv_utils::unescapeCSV(name),
-        csv_utils::unescapeCSV(breed),
-        std::stoi(ageStr),
-        csv_utils::unescapeCSV(medHist),
-        vacc == "Yes"
-    );
+#include "pet.h"
+#include "csv_utils.h"
+#include <utility>
+
+Pet::Pet(std::string n, std::string b, int a, LazyText mh, bool v)
+    : name(std::move(n)), breed(std::move(b)), medicalHistory(std::move(mh)), age(a), vaccinated(v) {
+}
+
+void Pet::writeCSV(csv_utils::CsvWriter& out, uint64_t* historyOffset) const {
+    out.field(name);
+    out.field(breed);
+    out.field(static_cast<long long>(age));
+    if (historyOffset) {
+        *historyOffset = out.position() + 1;  // after the comma
+    }
+    out.field(medicalHistory.str(false));
+    out.field(vaccinated ? "Yes" : "No", vaccinated ? 3 : 2);
+}
+
+Pet Pet::fromCSV(const std::vector<csv_utils::CsvField>& fields, size_t first, bool lazyHistory) {
+    LazyText history;
+    size_t historyIndex = first + 3;
+    if (lazyHistory && historyIndex < fields.size() &&
+        fields[historyIndex].length >= lazy_text::MinimumLength && lazy_text::enabled()) {
+        history = LazyText::onDisk(lazy_text::add(fields[historyIndex].offset,
+            static_cast<uint32_t>(fields[historyIndex].length)));
+    }
+    else {
+        history = csv_utils::fieldValue(fields, historyIndex);
+    }
+
+    return Pet(
+        csv_utils::fieldValue(fields, first),
+        csv_utils::fieldValue(fields, first + 1),
+        std::stoi(csv_utils::fieldValue(fields, first + 2)),
+        std::move(history),
+        csv_utils::fieldValue(fields, first + 4) == "Yes"
+    );
 }
\ No newline at end of file
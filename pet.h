@@ -1,13 +1,24 @@
-#pragma once
-#include <string>
-
-class Pet {
-public:
-    std::string name, breed, medicalHistory;
-    int age;
-    bool vaccinated;
-
-    Pet(std::string n, std::string b, int a, std::string mh, bool v);
-    std::string toCSV() const;
-    static Pet fromCSV(const std::string& line);
-};
\ No newline at end of file
+#pragma once
+#include <string>
+#include <cstdint>
+#include <vector>
+#include "lazy_text.h"
+
+namespace csv_utils { class CsvWriter; struct CsvField; }
+
+class Pet {
+public:
+    std::string name, breed;
+    LazyText medicalHistory;
+    int age;
+    bool vaccinated;
+
+    Pet(std::string n, std::string b, int a, LazyText mh, bool v);
+    // Appends the pet's fields to the current row. historyOffset, if
+    // given, receives out's position where the medical history starts.
+    void writeCSV(csv_utils::CsvWriter& out, uint64_t* historyOffset = nullptr) const;
+    // Reads the pet from fields[first] on. With lazyHistory, a long
+    // medical history is left on disk in memory-budget mode (see
+    // lazy_text.h); the fields must then come from pets.csv.
+    static Pet fromCSV(const std::vector<csv_utils::CsvField>& fields, size_t first = 0, bool lazyHistory = false);
+};
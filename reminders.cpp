@@ -0,0 +1,361 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "reminders.h"
+#include "calendar.h"
+#include "file_utils.h"
+#include "trace.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+
+const int ReminderScheduler::LeadHours[2] = { 48, 2 };
+
+namespace {
+    // Enough to hold the outbox's last line.
+    const uint64_t TailBytes = 64 * 1024;
+    // Once the outbox passes RotateBytes it becomes <path>.1, as for the
+    // change feed, and <path>.<KeptFiles> is removed.
+    const uint64_t RotateBytes = 64 * 1024 * 1024;
+    const int KeptFiles = 4;
+
+    long long currentMinute() {
+        long long seconds = calendar::localSeconds();
+        return seconds / 60 - (seconds % 60 < 0 ? 1 : 0);
+    }
+
+    std::string keyOf(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time) {
+        std::string key;
+        key.reserve(ownerName.size() + petName.size() + date.size() + time.size() + 3);
+        key += ownerName;
+        key += '\0';
+        key += petName;
+        key += '\0';
+        key += date;
+        key += '\0';
+        key += time;
+        return key;
+    }
+
+    std::string formatMinute(long long minute) {
+        long long days = minute / calendar::MinutesPerDay - (minute % calendar::MinutesPerDay < 0 ? 1 : 0);
+        int ofDay = static_cast<int>(minute - days * calendar::MinutesPerDay);
+        char clock[16];
+        snprintf(clock, sizeof(clock), " %02d:%02d", ofDay / 60, ofDay % 60);
+        return calendar::civilFromDays(static_cast<long>(days)) + clock;
+    }
+
+    // Reads the end of an outbox file. Sets size, and keep to where its
+    // last complete line ends, and returns the minute that line was sent,
+    // or -1 if there is none.
+    long long readTail(const std::string& path, uint64_t& size, uint64_t& keep) {
+        size = keep = 0;
+        if (!file_utils::fileSize(path, size) || size == 0) return -1;
+
+        std::ifstream in(path, std::ios::binary);
+        uint64_t from = size > TailBytes ? size - TailBytes : 0;
+        in.seekg(static_cast<std::streamoff>(from));
+        std::string tail((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        size_t end = tail.rfind('\n');
+        keep = end != std::string::npos ? from + end + 1 : from == 0 ? 0 : size;
+        if (end == std::string::npos) return -1;
+        size_t start = end > 0 ? tail.rfind('\n', end - 1) : std::string::npos;
+        start = start == std::string::npos ? 0 : start + 1;
+        std::string line = tail.substr(start, end - start);
+        long long stamp;
+        if (line.size() > 16 && line[10] == ' ' &&
+            calendar::parseDateTime(line.data(), 10, line.data() + 11, 5, stamp)) {
+            return stamp;
+        }
+        return -1;
+    }
+}
+
+ReminderScheduler::ReminderScheduler(const std::string& path) : path(path) {}
+
+ReminderScheduler::~ReminderScheduler() {
+    stop();
+    if (file) {
+        fclose(file);
+    }
+}
+
+void ReminderScheduler::start(std::function<void()> seed, std::function<bool(Reminder&)> check) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (worker.joinable()) return;
+
+    // Anything due more than the longest lead ago belongs to an
+    // appointment that has started, so there is no point looking further
+    // back. Without an outbox nothing has been sent and nothing is owed.
+    long long now = currentMinute();
+    long long sent = openOutbox();
+    long long oldest = now - LeadHours[0] * 60;
+    horizon = sent < 0 ? now : std::max(sent, oldest);
+    wheel.reset(new TimerWheel(horizon + 1));
+    accepting = true;
+    worker = std::thread(&ReminderScheduler::run, this, std::move(seed), std::move(check));
+}
+
+void ReminderScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        accepting = false;
+        wake.notify_one();
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+long long ReminderScheduler::openOutbox() {
+    uint64_t size = 0, keep = 0;
+    long long last = readTail(path, size, keep);
+    if (keep < size) {
+        // A batch cut short by a crash; its complete lines went out.
+        FILE* existing = fopen(path.c_str(), "r+b");
+        if (!existing || !file_utils::truncate(existing, keep)) {
+            std::cerr << "Error: Could not write to file " << path << std::endl;
+            keep = size;
+        }
+        if (existing) fclose(existing);
+    }
+    openedSize = keep;
+    if (last < 0) {
+        // Rotated just before the program stopped.
+        last = readTail(file_utils::rotatedPath(path, 1), size, keep);
+    }
+
+    openFile();
+    return last;
+}
+
+void ReminderScheduler::openFile() {
+    file = fopen(path.c_str(), "ab");
+    if (!file) {
+        std::cerr << "Error: Could not open file " << path << std::endl;
+    }
+    out.reset(new csv_utils::CsvWriter(file));
+}
+
+void ReminderScheduler::restore(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    arm(ownerName, petName, date, time, horizon);
+}
+
+void ReminderScheduler::schedule(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    arm(ownerName, petName, date, time, std::numeric_limits<long long>::min());
+}
+
+void ReminderScheduler::arm(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time, long long after) {
+    long long start;
+    if (!calendar::parseDateTime(date, time, start)) return;
+    if (!accepting || start <= wheel->next()) return;
+    std::string key = keyOf(ownerName, petName, date, time);
+    if (keys.count(key)) return;
+
+    uint32_t id;
+    if (!freeBookings.empty()) {
+        id = freeBookings.back();
+        freeBookings.pop_back();
+    }
+    else {
+        id = static_cast<uint32_t>(bookings.size());
+        bookings.emplace_back();
+    }
+    Booking& booking = bookings[id];
+    booking.key = &keys.emplace(std::move(key), id).first->first;
+    booking.start = start;
+    bool armed = false;
+    for (int lead = 0; lead < 2; lead++) {
+        long long deadline = start - LeadHours[lead] * 60;
+        booking.timers[lead] = TimerWheel::None;
+        if (deadline > after) {
+            booking.timers[lead] = wheel->add(deadline, id * 2 + lead);
+            armed = true;
+        }
+    }
+    if (!armed) {
+        disarm(id);
+    }
+}
+
+void ReminderScheduler::cancel(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!accepting) return;
+    auto found = keys.find(keyOf(ownerName, petName, date, time));
+    if (found != keys.end()) {
+        disarm(found->second);
+    }
+}
+
+void ReminderScheduler::apply(const std::vector<Mutation>& mutations) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!accepting) return;
+    }
+    for (const auto& mutation : mutations) {
+        const std::vector<std::string>& f = mutation.fields;
+        switch (mutation.type) {
+        case Mutation::Type::Schedule:
+            schedule(f[0], f[1], f[2], f[3]);
+            break;
+        // The only transition into Scheduled is from Scheduled, which
+        // changes nothing.
+        case Mutation::Type::SetStatus:
+            if (f[4] != "Scheduled") {
+                cancel(f[0], f[1], f[2], f[3]);
+            }
+            break;
+        case Mutation::Type::Cancel:
+            cancel(f[0], f[1], f[2], f[3]);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+size_t ReminderScheduler::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return wheel ? wheel->size() : 0;
+}
+
+void ReminderScheduler::disarm(uint32_t id) {
+    Booking& booking = bookings[id];
+    for (int lead = 0; lead < 2; lead++) {
+        if (booking.timers[lead] != TimerWheel::None) {
+            wheel->cancel(booking.timers[lead]);
+            booking.timers[lead] = TimerWheel::None;
+        }
+    }
+    keys.erase(keys.find(*booking.key));
+    booking.key = nullptr;
+    freeBookings.push_back(id);
+}
+
+std::vector<Reminder> ReminderScheduler::takeDue(long long minute) {
+    std::vector<uint32_t> expired;
+    wheel->advance(minute, expired);
+
+    std::vector<std::pair<long long, Reminder>> due;
+    for (uint32_t payload : expired) {
+        uint32_t id = payload / 2;
+        int lead = static_cast<int>(payload % 2);
+        Booking& booking = bookings[id];
+        booking.timers[lead] = TimerWheel::None;
+
+        // The 48-hour reminder is left out once the 2-hour one is due too,
+        // and neither goes out once the appointment has started.
+        long long start = booking.start;
+        bool superseded = lead == 0 && start - LeadHours[1] * 60 <= minute;
+        if (!superseded && start > minute) {
+            Reminder reminder;
+            const std::string& key = *booking.key;
+            size_t pet = key.find('\0') + 1;
+            size_t date = key.find('\0', pet) + 1;
+            size_t time = key.find('\0', date) + 1;
+            reminder.ownerName = key.substr(0, pet - 1);
+            reminder.petName = key.substr(pet, date - 1 - pet);
+            reminder.date = key.substr(date, time - 1 - date);
+            reminder.time = key.substr(time);
+            reminder.hoursBefore = LeadHours[lead];
+            due.emplace_back(start - LeadHours[lead] * 60, std::move(reminder));
+        }
+        if (booking.timers[0] == TimerWheel::None && booking.timers[1] == TimerWheel::None) {
+            disarm(id);
+        }
+    }
+
+    std::stable_sort(due.begin(), due.end(),
+        [](const std::pair<long long, Reminder>& a, const std::pair<long long, Reminder>& b) {
+            return a.first < b.first;
+        });
+    std::vector<Reminder> reminders;
+    reminders.reserve(due.size());
+    for (auto& entry : due) {
+        reminders.push_back(std::move(entry.second));
+    }
+    return reminders;
+}
+
+void ReminderScheduler::run(std::function<void()> seed, std::function<bool(Reminder&)> check) {
+    trace::nameThread("reminders");
+    try {
+        seed();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Appointment reminders stopped: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(mutex);
+        accepting = false;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        long long minute = currentMinute();
+        std::vector<Reminder> due = takeDue(minute);
+        lock.unlock();
+
+        std::vector<Reminder> sent;
+        for (auto& reminder : due) {
+            if (check(reminder)) {
+                sent.push_back(std::move(reminder));
+            }
+        }
+        if (!sent.empty()) {
+            write(sent, minute);
+        }
+
+        lock.lock();
+        long long second = calendar::localSeconds() % 60;
+        long long untilNextMinute = 60 - (second < 0 ? second + 60 : second);
+        wake.wait_for(lock, std::chrono::seconds(untilNextMinute), [this]() { return stopping; });
+    }
+}
+
+void ReminderScheduler::write(const std::vector<Reminder>& sent, long long minute) {
+    trace::Span span("reminders write");
+    std::string sentAt = formatMinute(minute);
+    for (const auto& reminder : sent) {
+        out->field(sentAt);
+        out->field(static_cast<long long>(reminder.hoursBefore));
+        out->field(reminder.ownerName);
+        out->field(reminder.petName);
+        out->field(reminder.date);
+        out->field(reminder.time);
+        out->field(reminder.phone);
+        out->field(reminder.email);
+        out->endRow();
+    }
+    if (!file || !out->flush() || !file_utils::sync(file)) {
+        std::cerr << "Error: Could not write to file " << path << std::endl;
+        return;
+    }
+    if (openedSize + out->position() >= RotateBytes) {
+        rotate();
+    }
+}
+
+void ReminderScheduler::rotate() {
+    trace::Span span("reminders rotate");
+    openedSize += out->position();
+    out.reset();
+    if (file) fclose(file);
+    file = nullptr;
+    // If a reader has the file open where that prevents it (Windows), it is
+    // tried again after the next batch.
+    if (file_utils::rotate(path, KeptFiles)) {
+        openedSize = 0;
+    }
+    openFile();
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include "mutation.h"
+#include "timer_wheel.h"
+#include "csv_utils.h"
+
+// A reminder that has fallen due for one appointment.
+struct Reminder {
+    std::string ownerName, petName, date, time;
+    int hoursBefore = 0;
+    // Filled in by the check passed to ReminderScheduler::start.
+    std::string phone, email;
+};
+
+// Sends a reminder 48 hours and 2 hours before every scheduled appointment
+// by appending it to an outbox file (vms.outbox) for whatever delivers
+// them. Each line holds the minute it was sent (YYYY-MM-DD HH:MM), the
+// hours before, owner, pet, date, time, phone and email.
+//
+// Deadlines are kept in a TimerWheel of local minutes, so arming or
+// cancelling an appointment's reminders is O(1) however many are pending.
+// A background thread wakes once a minute and writes what has fallen due
+// as one synced batch. A reminder whose deadline passed before it was
+// armed (an appointment booked 30 hours ahead) is sent straight away,
+// unless a later one for the same appointment is due too. After a
+// restart, reminders that fell due while the program was stopped are
+// sent on the same terms; the last line of the outbox shows how far it
+// had got. Once the outbox reaches 64 MB it is rotated like the change
+// feed: it becomes vms.outbox.1 and the older parts move up to .4.
+class ReminderScheduler {
+public:
+    static const int LeadHours[2];
+
+    explicit ReminderScheduler(const std::string& path);
+    ~ReminderScheduler();
+    ReminderScheduler(const ReminderScheduler&) = delete;
+    ReminderScheduler& operator=(const ReminderScheduler&) = delete;
+
+    // Starts the background thread. It first runs seed, which is expected
+    // to pass every scheduled appointment to restore(). check is then
+    // called for each reminder as it falls due, without any scheduler lock
+    // held; it fills in the contact details and returns false if the
+    // appointment is no longer scheduled (it was deleted with its owner
+    // or pet, which is not reported here).
+    void start(std::function<void()> seed, std::function<bool(Reminder&)> check);
+    // Stops the thread; reminders not yet due are dropped.
+    void stop();
+
+    // restore, schedule, cancel and apply are all ignored until start, and
+    // an appointment whose reminders are already armed is left as it is.
+
+    // Arms the reminders of an appointment booked before the program
+    // started, except those dealt with before it last stopped.
+    void restore(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time);
+    // Arms the reminders of an appointment booked just now; any already
+    // past their deadline go out at the next minute.
+    void schedule(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time);
+    void cancel(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time);
+    // Arms or cancels reminders for the Schedule, SetStatus and Cancel
+    // mutations of one commit.
+    void apply(const std::vector<Mutation>& mutations);
+
+    // Reminders armed and not yet due.
+    size_t pending() const;
+
+private:
+    // One appointment with reminders still armed. key is the map entry's
+    // owner, pet, date and time separated by '\0'.
+    struct Booking {
+        const std::string* key;
+        long long start;  // calendar::minuteStamp of the appointment
+        TimerWheel::Handle timers[2];
+    };
+
+    // Minute of the last batch in the outbox, or -1 if there is none;
+    // truncates a torn last line.
+    long long openOutbox();
+    void openFile();
+    // Renames the outbox to <path>.1 and starts a new one.
+    void rotate();
+    void run(std::function<void()> seed, std::function<bool(Reminder&)> check);
+    // Arms the reminders with a deadline after the given minute.
+    void arm(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time, long long after);
+    void disarm(uint32_t id);
+    // Removes the timers due by minute from the wheel and returns their
+    // reminders, earliest deadline first, leaving out superseded ones.
+    std::vector<Reminder> takeDue(long long minute);
+    void write(const std::vector<Reminder>& sent, long long minute);
+
+    std::string path;
+    FILE* file = nullptr;
+    std::unique_ptr<csv_utils::CsvWriter> out;
+    // Size of the outbox when out was opened on it.
+    uint64_t openedSize = 0;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool accepting = false;
+    bool stopping = false;
+    // Reminders due at or before horizon were dealt with before the
+    // program last started; they are not armed again.
+    long long horizon = 0;
+    std::unique_ptr<TimerWheel> wheel;
+    std::unordered_map<std::string, uint32_t> keys;
+    std::vector<Booking> bookings;
+    std::vector<uint32_t> freeBookings;
+};
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "replica.h"
+#include "exceptions.h"
+#include "checkpoint.h"
+#include "change_feed.h"
+#include "archive.h"
+#include "file_utils.h"
+#include "menus.h"
+#include "trace.h"
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+namespace replica {
+    namespace {
+        // How often the feed is checked for new commits, i.e. the lag
+        // added on top of the primary's own write latency.
+        const std::chrono::milliseconds PollInterval(10);
+
+        std::string inDirectory(const std::string& directory, const std::string& name) {
+            return directory.empty() ? name : directory + "/" + name;
+        }
+
+        int64_t nowMillis() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        // Applies the primary's feed to vms on a background thread.
+        class Follower {
+        public:
+            Follower(VMS& vms, const std::string& primaryDirectory)
+                : vms(vms), reader(inDirectory(primaryDirectory, "vms.replica.feed")) {}
+
+            ~Follower() {
+                stop();
+            }
+
+            void start() {
+                worker = std::thread(&Follower::loop, this);
+            }
+
+            // Stops following after applying what the primary has written.
+            void stop() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                    wake.notify_one();
+                }
+                if (worker.joinable()) {
+                    worker.join();
+                    poll();
+                }
+            }
+
+            void printStatus(std::ostream& out) const {
+                out << "\n--- Replication Status ---\n";
+                out << "Last commit applied: " << vms.lastCommittedSequence() << "\n";
+                out << "Events applied: " << eventsApplied.load() << "\n";
+                out << "Lag at last commit: " << lagMillis.load() << " ms\n";
+                if (failed.load()) {
+                    out << "Following stopped after an error; see above.\n";
+                }
+            }
+
+        private:
+            void loop() {
+                trace::nameThread("replica");
+                std::unique_lock<std::mutex> lock(mutex);
+                while (!stopping && !failed.load()) {
+                    lock.unlock();
+                    size_t applied = poll();
+                    lock.lock();
+                    if (applied == 0) {
+                        wake.wait_for(lock, PollInterval, [this]() { return stopping; });
+                    }
+                }
+            }
+
+            size_t poll() {
+                if (failed.load()) return 0;
+                try {
+                    return reader.poll([this](const std::vector<ChangeEvent>& events) {
+                        apply(events);
+                    });
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Replication error: " << e.what() << std::endl;
+                    failed = true;
+                    return 0;
+                }
+            }
+
+            void apply(const std::vector<ChangeEvent>& events) {
+                uint64_t sequence = events.front().journalSequence;
+                uint64_t last = vms.lastCommittedSequence();
+                if (sequence <= last) return;  // already in the checkpoint or journal
+                if (sequence != last + 1 && !warnedGap) {
+                    std::cerr << "Warning: commits " << last + 1 << " to " << sequence - 1
+                        << " are missing from the primary's feed." << std::endl;
+                    warnedGap = true;
+                }
+
+                trace::Span span("replicate commit");
+                std::vector<Mutation> mutations;
+                for (const auto& event : events) {
+                    mutations.push_back(event.mutation);
+                }
+                vms.applyReplicated(sequence, mutations);
+                eventsApplied += events.size();
+                lagMillis = std::max<int64_t>(0, nowMillis() - events.front().timestampMillis);
+            }
+
+            VMS& vms;
+            ChangeFeedReader reader;
+            std::thread worker;
+            std::mutex mutex;
+            std::condition_variable wake;
+            bool stopping = false;
+            bool warnedGap = false;
+            std::atomic<bool> failed{ false };
+            std::atomic<uint64_t> eventsApplied{ 0 };
+            std::atomic<int64_t> lagMillis{ 0 };
+        };
+
+        void viewMedicalHistory(VMS& vms) {
+            std::string ownerName = vms.getValidatedStringInput("Enter owner's name: ",
+                [&vms](const std::string& s) { return vms.validateName(s); });
+            std::string petName = vms.getValidatedStringInput("Enter pet's name: ",
+                [&vms](const std::string& s) { return vms.validateName(s); });
+
+            std::shared_ptr<const Snapshot> view = vms.snapshot();
+            const Pet* pet = view->findPet(ownerName, petName);
+            if (!pet) {
+                std::cout << "Pet not found.\n";
+                return;
+            }
+
+            std::cout << "\n--- Medical History for " << pet->name << " ---\n";
+            std::cout << "Owner: " << ownerName << "\n";
+            std::cout << "Breed: " << pet->breed << "\n";
+            std::cout << "Age: " << pet->age << "\n";
+            std::cout << "Vaccination Status: " << (pet->vaccinated ? "Vaccinated" : "Not Vaccinated") << "\n";
+            std::cout << "\nMedical History:\n";
+            std::cout << (pet->medicalHistory.empty() ? "No medical history recorded." : pet->medicalHistory) << "\n";
+        }
+
+        // Staff roles only: customers register and book on the primary.
+        bool login(VMS& vms) {
+            while (true) {
+                std::cout << "\nVeterinary Management System Login (read-only replica)\n";
+                std::cout << "Available roles: admin, vet, staff (leave empty to exit)\n";
+                std::cout << "Enter role: ";
+                std::string role;
+                std::getline(std::cin, role);
+                std::transform(role.begin(), role.end(), role.begin(), ::tolower);
+                if (role.empty()) return false;
+
+                std::cout << "Enter password: ";
+                std::string password;
+                std::getline(std::cin, password);
+                try {
+                    if ((role == "admin" || role == "vet" || role == "staff") && vms.authenticateStaff(role, password)) {
+                        return true;
+                    }
+                    std::cout << LoginFailedException().what() << std::endl;
+                }
+                catch (const FileAccessException& e) {
+                    std::cout << e.what() << std::endl;
+                    std::cout << "Please ensure the system is properly set up." << std::endl;
+                }
+                catch (const std::exception& e) {
+                    std::cout << "An unexpected error occurred: " << e.what() << std::endl;
+                }
+            }
+        }
+    }
+
+    void bootstrap(const std::string& primaryDirectory) {
+        trace::Span span("replica bootstrap");
+        if (std::ifstream("vms.checkpoint").is_open()) {
+            return;  // resume from our own checkpoint and journal
+        }
+
+        // Records in a journal left here belong to some other history.
+        remove("vms.journal");
+        uint64_t sequence = checkpoint::copyFrom(primaryDirectory);
+        AppointmentArchive::copySegments(primaryDirectory, sequence);
+        std::cout << "Copied checkpoint " << sequence << " from " << primaryDirectory << ".\n";
+
+        const char* const roleFiles[] = { "admin.txt", "vet.txt", "staff.txt" };
+        for (const char* name : roleFiles) {
+            std::string contents;
+            if (file_utils::readFile(inDirectory(primaryDirectory, name), contents)) {
+                file_utils::writeDurably(name, contents);
+            }
+        }
+    }
+
+    bool run(VMS& vms, const std::string& primaryDirectory) {
+        Follower follower(vms, primaryDirectory);
+        follower.start();
+        std::cout << "Following " << primaryDirectory << " from commit " << vms.lastCommittedSequence() << ".\n";
+
+        bool promoted = false;
+        if (login(vms)) {
+            std::vector<std::string> options = {
+                "View Pet Medical History", "View Pet Appointment History",
+                "Replication Status", "Promote to Primary" };
+            while (true) {
+                int choice = ui::displayRoleMenu("Replica Menu", options, options.size());
+                if (choice == -1) break;
+
+                try {
+                    if (choice == 1) {
+                        viewMedicalHistory(vms);
+                    }
+                    else if (choice == 2) {
+                        vms.viewPetAppointmentHistory();
+                    }
+                    else if (choice == 3) {
+                        follower.printStatus(std::cout);
+                    }
+                    else {
+                        std::cout << "Only promote this replica once the primary has stopped.\n";
+                        std::cout << "Promote to primary? (y/n): ";
+                        std::string confirm;
+                        std::getline(std::cin, confirm);
+                        if (confirm == "y" || confirm == "Y") {
+                            promoted = true;
+                            break;
+                        }
+                    }
+                }
+                catch (const std::exception& e) {
+                    std::cout << "An unexpected error occurred: " << e.what() << std::endl;
+                }
+            }
+        }
+
+        // Apply the rest of the feed, then write our own checkpoint so a
+        // restart (as follower or primary) starts from it.
+        follower.stop();
+        vms.setFollowing(!promoted);
+        vms.saveData();
+        if (promoted) {
+            std::cout << "Promoted to primary at commit " << vms.lastCommittedSequence() << ".\n";
+        }
+        return promoted;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include "vms.h"
+
+// Hot standby. A second vet_system started with --follow <primary
+// directory> in a directory of its own copies the primary's latest
+// checkpoint, then applies the primary's full change feed
+// (vms.replica.feed) as it grows, journaling every commit under the
+// primary's sequence number. It serves read-only views meanwhile and can be promoted to primary,
+// after which it runs from its own files like any other instance.
+namespace replica {
+    // Copies the primary's checkpoint, archive segments and role password
+    // files into the working directory, unless it already holds a
+    // follower's state, in which case that is resumed. Call before VMS::loadData. Throws
+    // FileAccessException if the primary has not written a checkpoint.
+    void bootstrap(const std::string& primaryDirectory);
+
+    // Follows the primary's feed in the background and shows the replica
+    // menu until the user leaves it. Returns true if this process was
+    // promoted to primary.
+    bool run(VMS& vms, const std::string& primaryDirectory);
+}
\ No newline at end of file
@@ -1,19 +1,178 @@
-#include "security.h"
-
-namespace security {
-    std::string simpleEncrypt(const std::string& password) {
-        std::string encrypted = password;
-        for (char& c : encrypted) {
-            c = c + 1;
-        }
-        return encrypted;
-    }
-
-    std::string simpleDecrypt(const std::string& encrypted) {
-        std::string password = encrypted;
-        for (char& c : password) {
-            c = c - 1;
-        }
-        return password;
-    }
+#include "security.h"
+#include <cstdint>
+#include <random>
+#include <sstream>
+
+namespace security {
+    namespace {
+        const int HashIterations = 1000;
+        const size_t SaltBytes = 16;
+        const char* const HashPrefix = "$sha256$";
+
+        const uint32_t roundConstants[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t rotr(uint32_t x, int n) {
+            return (x >> n) | (x << (32 - n));
+        }
+
+        void compressBlock(uint32_t state[8], const unsigned char* block) {
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++) {
+                w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) |
+                    (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+            }
+            for (int i = 16; i < 64; i++) {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++) {
+                uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                    roundConstants[i] + w[i];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+
+        // Raw 32-byte digest.
+        std::string sha256(const std::string& data) {
+            uint32_t state[8] = {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+            };
+
+            size_t full = data.size() / 64;
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+            for (size_t i = 0; i < full; i++) {
+                compressBlock(state, bytes + i * 64);
+            }
+
+            unsigned char tail[128] = {};
+            size_t rest = data.size() - full * 64;
+            for (size_t i = 0; i < rest; i++) {
+                tail[i] = bytes[full * 64 + i];
+            }
+            tail[rest] = 0x80;
+            size_t tailBlocks = rest + 9 > 64 ? 2 : 1;
+            uint64_t bitLength = uint64_t(data.size()) * 8;
+            for (int i = 0; i < 8; i++) {
+                tail[tailBlocks * 64 - 1 - i] = static_cast<unsigned char>(bitLength >> (i * 8));
+            }
+            for (size_t i = 0; i < tailBlocks; i++) {
+                compressBlock(state, tail + i * 64);
+            }
+
+            std::string digest(32, '\0');
+            for (int i = 0; i < 8; i++) {
+                digest[i * 4] = static_cast<char>(state[i] >> 24);
+                digest[i * 4 + 1] = static_cast<char>(state[i] >> 16);
+                digest[i * 4 + 2] = static_cast<char>(state[i] >> 8);
+                digest[i * 4 + 3] = static_cast<char>(state[i]);
+            }
+            return digest;
+        }
+
+        std::string toHex(const std::string& bytes) {
+            static const char digits[] = "0123456789abcdef";
+            std::string hex;
+            hex.reserve(bytes.size() * 2);
+            for (unsigned char c : bytes) {
+                hex += digits[c >> 4];
+                hex += digits[c & 0x0f];
+            }
+            return hex;
+        }
+
+        std::string stretch(const std::string& password, const std::string& saltHex, int iterations) {
+            std::string digest = sha256(saltHex + password);
+            for (int i = 1; i < iterations; i++) {
+                digest = sha256(digest + password);
+            }
+            return toHex(digest);
+        }
+    }
+
+    std::string simpleEncrypt(const std::string& password) {
+        std::string encrypted = password;
+        for (char& c : encrypted) {
+            c = c + 1;
+        }
+        return encrypted;
+    }
+
+    std::string simpleDecrypt(const std::string& encrypted) {
+        std::string password = encrypted;
+        for (char& c : password) {
+            c = c - 1;
+        }
+        return password;
+    }
+
+    std::string sha256Hex(const std::string& data) {
+        return toHex(sha256(data));
+    }
+
+    std::string hashPassword(const std::string& password) {
+        // One per thread: the loader migrates legacy passwords in parallel.
+        thread_local std::random_device device;
+        std::string salt(SaltBytes, '\0');
+        for (auto& c : salt) {
+            c = static_cast<char>(device() & 0xff);
+        }
+        std::string saltHex = toHex(salt);
+        return HashPrefix + std::to_string(HashIterations) + "$" + saltHex + "$" +
+            stretch(password, saltHex, HashIterations);
+    }
+
+    bool isPasswordHash(const std::string& stored) {
+        return stored.compare(0, std::string(HashPrefix).size(), HashPrefix) == 0;
+    }
+
+    bool verifyPassword(const std::string& password, const std::string& stored) {
+        if (!isPasswordHash(stored)) {
+            return false;
+        }
+
+        std::stringstream fields(stored.substr(std::string(HashPrefix).size()));
+        std::string iterations, saltHex, digestHex;
+        getline(fields, iterations, '$');
+        getline(fields, saltHex, '$');
+        getline(fields, digestHex, '$');
+
+        int rounds = 0;
+        try {
+            rounds = std::stoi(iterations);
+        }
+        catch (...) {
+            return false;
+        }
+        if (rounds < 1 || saltHex.empty()) {
+            return false;
+        }
+        return constantTimeEquals(stretch(password, saltHex, rounds), digestHex);
+    }
+
+    bool constantTimeEquals(const std::string& a, const std::string& b) {
+        unsigned char diff = a.size() == b.size() ? 0 : 1;
+        size_t n = a.size() < b.size() ? a.size() : b.size();
+        for (size_t i = 0; i < n; i++) {
+            diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+        }
+        return diff == 0;
+    }
 }
\ No newline at end of file
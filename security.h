@@ -1,7 +1,19 @@
-#pragma once
-#include <string>
-
-namespace security {
-    std::string simpleEncrypt(const std::string& password);
-    std::string simpleDecrypt(const std::string& encrypted);
+#pragma once
+#include <string>
+
+namespace security {
+    // Legacy reversible shift cipher. Only used to migrate passwords stored
+    // before salted hashes were introduced.
+    std::string simpleEncrypt(const std::string& password);
+    std::string simpleDecrypt(const std::string& encrypted);
+
+    std::string sha256Hex(const std::string& data);
+
+    // Stored password format: $sha256$<iterations>$<salt hex>$<digest hex>
+    std::string hashPassword(const std::string& password);
+    bool isPasswordHash(const std::string& stored);
+    bool verifyPassword(const std::string& password, const std::string& stored);
+
+    // Compares without an early exit so timing does not leak the mismatch position.
+    bool constantTimeEquals(const std::string& a, const std::string& b);
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "snapshot.h"
+#include "stats.h"
+
+const Owner* Snapshot::findOwner(const std::string& name) const {
+    bool passed = !names || names->mightContain(BloomFilter::hashOf(name));
+    const Owner* found = nullptr;
+    if (passed) {
+        for (const auto& owner : *owners) {
+            if (owner.name == name) {
+                found = &owner;
+                break;
+            }
+        }
+    }
+    if (names) {
+        stats::recordFilterLookup(passed, found != nullptr);
+    }
+    return found;
+}
+
+const Pet* Snapshot::findPet(const std::string& ownerName, const std::string& petName) const {
+    bool passed = !names || names->mightContain(BloomFilter::hashOf(ownerName, petName));
+    const Pet* found = nullptr;
+    if (passed) {
+        for (const auto& owner : *owners) {
+            if (owner.name != ownerName) continue;
+            for (const auto& pet : owner.pets) {
+                if (pet.name == petName) {
+                    found = &pet;
+                    break;
+                }
+            }
+            if (found) break;
+        }
+    }
+    if (names) {
+        stats::recordFilterLookup(passed, found != nullptr);
+    }
+    return found;
+}
+
+const Appointment* Snapshot::findAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) const {
+    for (const auto& appt : *appointments) {
+        if (appt.date == date && appt.time == time && appt.ownerName == ownerName && appt.petName == petName) {
+            return &appt;
+        }
+    }
+    return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include "owner.h"
+#include "appointment.h"
+#include "bloom_filter.h"
+#include "chunked_records.h"
+
+// Immutable version of the data as of one commit point. Readers pin a
+// snapshot with VMS::snapshot() and can scan it for as long as they like
+// without locks; writers publish a new one instead of touching it. The two
+// collections are held separately so a version that only changed
+// appointments shares the owners with its predecessor, and each is
+// chunked (see chunked_records.h) so a version shares the chunks it did
+// not change as well.
+struct Snapshot {
+    typedef ChunkedRecords<Owner> Owners;
+    typedef ChunkedRecords<Appointment> Appointments;
+
+    uint64_t version = 0;
+    // Last journal record whose changes are included.
+    uint64_t journalSequence = 0;
+    std::shared_ptr<const Owners> owners;
+    std::shared_ptr<const Appointments> appointments;
+    // Owner names and owner/pet name pairs. Shared with later versions
+    // until VMS rebuilds it, so it may also hold names added since.
+    std::shared_ptr<const BloomFilter> names;
+
+    // First owner with the name, or the named pet of an owner with that
+    // name; nullptr if there is none. Most absent names are turned away
+    // by the filter without scanning the owners.
+    const Owner* findOwner(const std::string& name) const;
+    const Pet* findPet(const std::string& ownerName, const std::string& petName) const;
+    // Scans every appointment; meant for one-off lookups from the menus.
+    const Appointment* findAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time) const;
+};
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include "stats.h"
+#include <atomic>
+#include <iomanip>
+#include <new>
+#include <cstdlib>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace stats {
+    namespace {
+        // HDR-style layout: values below 16ns get exact buckets, larger values
+        // are split by power of two and then into 16 linear sub-buckets.
+        const int SubBucketBits = 4;
+        const int SubBucketCount = 1 << SubBucketBits;
+        const int BucketCount = SubBucketCount + (64 - SubBucketBits) * SubBucketCount;
+
+        const char* const opNames[] = {
+            "loadData",
+            "saveData",
+            "saveData: owners.csv",
+            "saveData: pets.csv",
+            "saveData: appointments.csv",
+            "updateAllAppointmentStatuses",
+            "hasTimeConflict",
+            "owner lookup",
+            "pet lookup",
+            "validate name",
+            "validate address",
+            "validate email",
+            "validate phone",
+            "validate date",
+            "validate time",
+            "validate password",
+            "staff login",
+            "customer login",
+            "scheduleAppointment",
+            "deleteOwner",
+            "deletePet",
+            "duplicate check"
+        };
+        static_assert(sizeof(opNames) / sizeof(opNames[0]) == static_cast<size_t>(Op::Count),
+            "opNames must have one entry per stats::Op");
+
+        struct Histogram {
+            std::atomic<uint64_t> buckets[BucketCount];
+            std::atomic<uint64_t> samples;
+            std::atomic<uint64_t> totalNanos;
+            std::atomic<uint64_t> maxNanos;
+            std::atomic<uint64_t> totalAllocations;
+        };
+
+        Histogram histograms[static_cast<int>(Op::Count)];
+
+        // Bumped by every operator new below.
+        thread_local uint64_t threadAllocations = 0;
+
+        std::atomic<uint64_t> filterLookups{ 0 }, filterRejected{ 0 }, filterFalsePositives{ 0 };
+
+        int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<int>(index);
+#else
+            int bit = 0;
+            while (value >>= 1) bit++;
+            return bit;
+#endif
+        }
+
+        int bucketFor(uint64_t nanos) {
+            if (nanos < static_cast<uint64_t>(SubBucketCount)) {
+                return static_cast<int>(nanos);
+            }
+            int exponent = highestBit(nanos);
+            int sub = static_cast<int>((nanos >> (exponent - SubBucketBits)) & (SubBucketCount - 1));
+            return SubBucketCount + (exponent - SubBucketBits) * SubBucketCount + sub;
+        }
+
+        // Midpoint of the range of values that land in bucket.
+        uint64_t valueFor(int bucket) {
+            if (bucket < SubBucketCount) {
+                return static_cast<uint64_t>(bucket);
+            }
+            int shift = (bucket - SubBucketCount) / SubBucketCount;
+            uint64_t sub = static_cast<uint64_t>((bucket - SubBucketCount) % SubBucketCount);
+            uint64_t low = (SubBucketCount + sub) << shift;
+            return low + ((uint64_t(1) << shift) >> 1);
+        }
+
+        Histogram& histogramFor(Op op) {
+            return histograms[static_cast<int>(op)];
+        }
+
+        double micros(uint64_t nanos) {
+            return nanos / 1000.0;
+        }
+    }
+
+    void record(Op op, uint64_t nanos, uint64_t allocations) {
+        Histogram& h = histogramFor(op);
+        h.buckets[bucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+        h.samples.fetch_add(1, std::memory_order_relaxed);
+        h.totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+        h.totalAllocations.fetch_add(allocations, std::memory_order_relaxed);
+
+        uint64_t seen = h.maxNanos.load(std::memory_order_relaxed);
+        while (nanos > seen && !h.maxNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t allocations() {
+        return threadAllocations;
+    }
+
+    void recordFilterLookup(bool passed, bool found) {
+        filterLookups.fetch_add(1, std::memory_order_relaxed);
+        if (!passed) {
+            filterRejected.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (!found) {
+            filterFalsePositives.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count(Op op) {
+        return histogramFor(op).samples.load(std::memory_order_relaxed);
+    }
+
+    uint64_t percentile(Op op, double pct) {
+        Histogram& h = histogramFor(op);
+        uint64_t total = 0;
+        for (const auto& bucket : h.buckets) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(pct / 100.0 * total + 0.5);
+        if (target < 1) target = 1;
+
+        uint64_t maxNanos = h.maxNanos.load(std::memory_order_relaxed);
+        uint64_t seen = 0;
+        for (int i = 0; i < BucketCount; i++) {
+            seen += h.buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                uint64_t value = valueFor(i);
+                return value < maxNanos ? value : maxNanos;
+            }
+        }
+        return maxNanos;
+    }
+
+    void reset() {
+        for (auto& h : histograms) {
+            for (auto& bucket : h.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            h.samples.store(0, std::memory_order_relaxed);
+            h.totalNanos.store(0, std::memory_order_relaxed);
+            h.maxNanos.store(0, std::memory_order_relaxed);
+            h.totalAllocations.store(0, std::memory_order_relaxed);
+        }
+        filterLookups.store(0, std::memory_order_relaxed);
+        filterRejected.store(0, std::memory_order_relaxed);
+        filterFalsePositives.store(0, std::memory_order_relaxed);
+    }
+
+    void printReport(std::ostream& out) {
+        out << "\n--- System Statistics (latency in microseconds) ---\n";
+        out << std::left << std::setw(30) << "Operation" << std::right
+            << std::setw(10) << "Count" << std::setw(12) << "Mean"
+            << std::setw(12) << "p50" << std::setw(12) << "p99"
+            << std::setw(12) << "Max" << std::setw(14) << "Allocs/call" << "\n";
+
+        std::ios::fmtflags flags = out.flags();
+        out << std::fixed << std::setprecision(1);
+        for (int i = 0; i < static_cast<int>(Op::Count); i++) {
+            Op op = static_cast<Op>(i);
+            Histogram& h = histogramFor(op);
+            uint64_t samples = h.samples.load(std::memory_order_relaxed);
+            uint64_t total = h.totalNanos.load(std::memory_order_relaxed);
+            uint64_t allocs = h.totalAllocations.load(std::memory_order_relaxed);
+
+            out << std::left << std::setw(30) << opNames[i] << std::right
+                << std::setw(10) << samples
+                << std::setw(12) << (samples ? micros(total / samples) : 0.0)
+                << std::setw(12) << micros(percentile(op, 50))
+                << std::setw(12) << micros(percentile(op, 99))
+                << std::setw(12) << micros(h.maxNanos.load(std::memory_order_relaxed))
+                << std::setw(14) << (samples ? static_cast<double>(allocs) / samples : 0.0) << "\n";
+        }
+
+        // The false-positive rate is over the lookups for absent names.
+        uint64_t lookups = filterLookups.load(std::memory_order_relaxed);
+        uint64_t rejected = filterRejected.load(std::memory_order_relaxed);
+        uint64_t falsePositives = filterFalsePositives.load(std::memory_order_relaxed);
+        uint64_t absent = rejected + falsePositives;
+        out << "\nName filter: " << lookups << " lookups, " << rejected << " answered without a scan, "
+            << falsePositives << " false positives (" << std::setprecision(2)
+            << (absent ? 100.0 * falsePositives / absent : 0.0) << "% of absent names)\n";
+        out.flags(flags);
+    }
+}
+
+namespace stats {
+    namespace {
+        void* allocate(std::size_t size) {
+            threadAllocations++;
+            for (;;) {
+                if (void* memory = std::malloc(size ? size : 1)) {
+                    return memory;
+                }
+                std::new_handler handler = std::get_new_handler();
+                if (!handler) {
+                    throw std::bad_alloc();
+                }
+                handler();
+            }
+        }
+
+#ifdef __cpp_aligned_new
+        // malloc only guarantees the alignment of the fundamental types, so
+        // an over-aligned block is carved out of a larger one, with the
+        // address malloc returned stored just in front of it.
+        void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+            std::size_t align = static_cast<std::size_t>(alignment);
+            threadAllocations++;
+            for (;;) {
+                if (void* memory = std::malloc(size + align + sizeof(void*))) {
+                    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(memory) + sizeof(void*);
+                    void** block = reinterpret_cast<void**>((start + align - 1) & ~static_cast<std::uintptr_t>(align - 1));
+                    block[-1] = memory;
+                    return block;
+                }
+                std::new_handler handler = std::get_new_handler();
+                if (!handler) {
+                    throw std::bad_alloc();
+                }
+                handler();
+            }
+        }
+
+        void releaseAligned(void* memory) {
+            if (memory) {
+                std::free(static_cast<void**>(memory)[-1]);
+            }
+        }
+#endif
+    }
+}
+
+// Global allocation functions, replaced only to count calls per thread for
+// stats::allocations. Every form is replaced, so that whatever allocates a
+// block (the standard library's temporary buffers use the nothrow form)
+// releases it through the matching function here rather than the
+// runtime's, which a checker such as AddressSanitizer reports as a
+// mismatch.
+void* operator new(std::size_t size) {
+    return stats::allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return stats::allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return stats::allocate(size);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return stats::allocate(size);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return stats::allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return stats::allocateAligned(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return stats::allocateAligned(size, alignment);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return stats::allocateAligned(size, alignment);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    stats::releaseAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    stats::releaseAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    stats::releaseAligned(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    stats::releaseAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    stats::releaseAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    stats::releaseAligned(memory);
+}
+#endif
\ No newline at end of file
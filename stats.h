@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <ostream>
+#include <chrono>
+#include <cstdint>
+
+namespace stats {
+    // Instrumented operations. Keep in sync with the names in stats.cpp.
+    enum class Op {
+        LoadData,
+        SaveData,
+        SaveOwners,
+        SavePets,
+        SaveAppointments,
+        UpdateStatuses,
+        TimeConflict,
+        OwnerLookup,
+        PetLookup,
+        ValidateName,
+        ValidateAddress,
+        ValidateEmail,
+        ValidatePhone,
+        ValidateDate,
+        ValidateTime,
+        ValidatePassword,
+        StaffLogin,
+        CustomerLogin,
+        Schedule,
+        DeleteOwner,
+        DeletePet,
+        DuplicateCheck,
+        Count
+    };
+
+    // Records one sample of op taking the given number of nanoseconds and
+    // making the given number of heap allocations. Lock-free (relaxed
+    // atomics only), safe to call from any thread.
+    void record(Op op, uint64_t nanos, uint64_t allocations = 0);
+
+    // Heap allocations (operator new) made so far by the calling thread.
+    uint64_t allocations();
+
+    // One lookup through a name filter (bloom_filter.h): passed is whether
+    // the filter let the name through, found whether it then existed.
+    // A name that passed but was not found is a false positive.
+    void recordFilterLookup(bool passed, bool found);
+
+    uint64_t count(Op op);
+    // Latency in nanoseconds at the given percentile (0-100), accurate to
+    // within one histogram sub-bucket (about 6%).
+    uint64_t percentile(Op op, double pct);
+
+    void reset();
+    void printReport(std::ostream& out);
+
+    // Times the enclosing scope and records it against op on destruction,
+    // with the allocations made on this thread meanwhile (work handed to
+    // other threads, such as loadData's parsers, is not counted).
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Op op)
+            : op(op), startAllocations(allocations()), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            record(op, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                allocations() - startAllocations);
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Op op;
+        uint64_t startAllocations;
+        std::chrono::steady_clock::time_point start;
+    };
+}
\ No newline at end of file
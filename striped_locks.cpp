@@ -0,0 +1,28 @@
+#include "striped_locks.h"
+#include <algorithm>
+#include <functional>
+
+size_t StripedLocks::stripeFor(const std::string& key) const {
+    return std::hash<std::string>()(key) % StripeCount;
+}
+
+std::vector<size_t> StripedLocks::lock(const std::vector<std::string>& keys) {
+    std::vector<size_t> indices;
+    indices.reserve(keys.size());
+    for (const auto& key : keys) {
+        indices.push_back(stripeFor(key));
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    for (size_t index : indices) {
+        stripes[index].lock();
+    }
+    return indices;
+}
+
+void StripedLocks::unlock(const std::vector<size_t>& indices) {
+    for (auto it = indices.rbegin(); it != indices.rend(); ++it) {
+        stripes[*it].unlock();
+    }
+}
\ No newline at end of file
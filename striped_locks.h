@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+// Lock order used by VMS (always acquire top to bottom, release in any order):
+//   0. saveMutex       serialises checkpoints; held on its own, never
+//                      together with the locks below
+//   1. structureMutex  shared by every operation; exclusive for operations
+//                      that insert or erase owners or erase appointments
+//                      (registration, owner/pet deletion, status sweeps, save)
+//   2. owner stripes   keyed by owner name, in ascending stripe index
+//   3. day stripes     keyed by appointment date, in ascending stripe index
+//   4. storageMutex    shared while touching appointment elements, exclusive
+//                      for the push_back that adds a new appointment and for
+//                      tombstoning one when a booking is rolled back
+// Cascading deletes take (1) exclusively and therefore need nothing else.
+// VMS::commit takes (1)-(3) for all of a transaction's mutations at once
+// and holds them until its journal record is written and its snapshot
+// published; it does both under feedOrderMutex, which goes between (3)
+// and (4).
+
+// A fixed pool of mutexes. Keys hash to a stripe, so unrelated keys rarely
+// contend while the memory cost stays constant.
+class StripedLocks {
+public:
+    static const size_t StripeCount = 64;
+
+    size_t stripeFor(const std::string& key) const;
+
+    // Locks the stripes for all keys in ascending stripe order (each stripe
+    // once) and returns the indices to pass to unlock.
+    std::vector<size_t> lock(const std::vector<std::string>& keys);
+    void unlock(const std::vector<size_t>& stripes);
+
+private:
+    std::mutex stripes[StripeCount];
+};
+
+// RAII holder for a set of stripes.
+class StripeGuard {
+public:
+    StripeGuard(StripedLocks& locks, const std::vector<std::string>& keys)
+        : locks(locks), held(locks.lock(keys)) {}
+    ~StripeGuard() { locks.unlock(held); }
+    StripeGuard(const StripeGuard&) = delete;
+    StripeGuard& operator=(const StripeGuard&) = delete;
+
+private:
+    StripedLocks& locks;
+    std::vector<size_t> held;
+};
\ No newline at end of file
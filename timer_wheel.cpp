@@ -0,0 +1,108 @@
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(long long first) : current(first) {
+    nodes.resize(Levels * Slots);
+    for (uint32_t head = 0; head < nodes.size(); head++) {
+        nodes[head].prev = nodes[head].next = head;
+    }
+}
+
+TimerWheel::Handle TimerWheel::add(long long deadline, uint32_t payload) {
+    uint32_t node;
+    if (freeNodes != None) {
+        node = freeNodes;
+        freeNodes = nodes[node].next;
+    }
+    else {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[node].deadline = deadline;
+    nodes[node].payload = payload;
+    file(node);
+    count++;
+    return node;
+}
+
+void TimerWheel::cancel(Handle handle) {
+    unlink(handle);
+    release(handle);
+}
+
+// The level is picked by the distance from the tick being processed, the
+// slot by the deadline's digits at that level, so a timer is reached
+// either directly (level 0) or by the cascade of its slot, which happens
+// in the last 64^level minutes before its deadline.
+void TimerWheel::file(uint32_t node) {
+    long long deadline = nodes[node].deadline;
+    long long distance = deadline - current;
+    uint32_t head;
+    if (distance < 0) {
+        head = static_cast<uint32_t>(current & (Slots - 1));
+    }
+    else if (distance < (1LL << SlotBits)) {
+        head = static_cast<uint32_t>(deadline & (Slots - 1));
+    }
+    else {
+        int level = 1;
+        while (level < Levels - 1 && distance >= (1LL << (SlotBits * (level + 1)))) {
+            level++;
+        }
+        long long farthest = current + (1LL << (SlotBits * Levels)) - 1;
+        long long filed = deadline < farthest ? deadline : farthest;
+        head = static_cast<uint32_t>(level * Slots + ((filed >> (SlotBits * level)) & (Slots - 1)));
+    }
+    Node& entry = nodes[node];
+    entry.prev = head;
+    entry.next = nodes[head].next;
+    nodes[entry.next].prev = node;
+    nodes[head].next = node;
+}
+
+void TimerWheel::unlink(uint32_t node) {
+    nodes[nodes[node].prev].next = nodes[node].next;
+    nodes[nodes[node].next].prev = nodes[node].prev;
+}
+
+void TimerWheel::release(uint32_t node) {
+    nodes[node].next = freeNodes;
+    freeNodes = node;
+    count--;
+}
+
+void TimerWheel::cascade(int level, int slot) {
+    uint32_t head = static_cast<uint32_t>(level * Slots + slot);
+    uint32_t node = nodes[head].next;
+    nodes[head].prev = nodes[head].next = head;
+    while (node != head) {
+        uint32_t next = nodes[node].next;
+        file(node);
+        node = next;
+    }
+}
+
+void TimerWheel::advance(long long until, std::vector<uint32_t>& expired) {
+    while (current <= until) {
+        if (count == 0) {
+            current = until + 1;
+            break;
+        }
+        int slot = static_cast<int>(current & (Slots - 1));
+        if (slot == 0) {
+            for (int level = 1; level < Levels; level++) {
+                int upper = static_cast<int>((current >> (SlotBits * level)) & (Slots - 1));
+                cascade(level, upper);
+                if (upper != 0) break;
+            }
+        }
+
+        uint32_t head = static_cast<uint32_t>(slot);
+        while (nodes[head].next != head) {
+            uint32_t node = nodes[head].next;
+            unlink(node);
+            expired.push_back(nodes[node].payload);
+            release(node);
+        }
+        current++;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Hierarchical timing wheel with one tick per minute. Four levels of 64
+// slots cover the next 64 minutes, 2.8 days, 182 days and 32 years; a
+// timer is filed in the level for how far away it is and moves down a
+// level whenever the level below wraps round, so add and cancel are O(1)
+// and advancing one minute empties one slot (plus a cascade every 64
+// minutes). Timers further out than 32 years wait in the top level and
+// are filed again when their slot comes round. Not thread-safe.
+class TimerWheel {
+public:
+    typedef uint32_t Handle;
+    static const Handle None = 0;
+
+    // first is the first minute advance will process.
+    explicit TimerWheel(long long first);
+
+    // The timer expires at the tick for deadline, or at the next tick if
+    // that has already been processed.
+    Handle add(long long deadline, uint32_t payload);
+    // handle must still be pending (not expired or cancelled).
+    void cancel(Handle handle);
+    // Processes every minute up to and including until and appends the
+    // payloads of the timers that expire, earliest tick first.
+    void advance(long long until, std::vector<uint32_t>& expired);
+
+    // Next minute advance will process.
+    long long next() const { return current; }
+    size_t size() const { return count; }
+
+private:
+    static const int SlotBits = 6;
+    static const int Slots = 1 << SlotBits;
+    static const int Levels = 4;
+
+    // Timers and slots share one pool: the first Levels * Slots nodes head
+    // circular lists, one per slot, so unlinking never needs to know which
+    // slot a timer is in. Free nodes are chained through next.
+    struct Node {
+        long long deadline;
+        uint32_t prev, next;
+        uint32_t payload;
+    };
+
+    void file(uint32_t node);
+    void unlink(uint32_t node);
+    void release(uint32_t node);
+    // Files the timers of a slot again, each one level down or more.
+    void cascade(int level, int slot);
+
+    std::vector<Node> nodes;
+    uint32_t freeNodes = None;
+    long long current;
+    size_t count = 0;
+};
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "trace.h"
+#include "exceptions.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+    namespace detail {
+        std::atomic<bool> enabled(false);
+    }
+
+    namespace {
+        const size_t RingCapacity = 1 << 16;
+
+        struct Event {
+            const char* name;
+            uint64_t startNanos;
+            uint64_t endNanos;
+        };
+
+        // mutex is only contended while flush() copies the events out.
+        struct ThreadBuffer {
+            int tid;
+            const char* name;
+            std::mutex mutex;
+            std::vector<Event> events;
+            uint64_t written;
+
+            ThreadBuffer(int id, const char* name) : tid(id), name(name), events(RingCapacity), written(0) {}
+        };
+
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        // Buffers are owned here rather than by their threads so spans from
+        // threads that have already exited still make it into the flush.
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        std::string outputPath;
+
+        thread_local ThreadBuffer* localBuffer = nullptr;
+        thread_local const char* localName = nullptr;
+
+        ThreadBuffer& bufferForThisThread() {
+            if (!localBuffer) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                buffers.emplace_back(new ThreadBuffer(static_cast<int>(buffers.size()) + 1, localName));
+                localBuffer = buffers.back().get();
+            }
+            return *localBuffer;
+        }
+
+        void writeMicros(std::ostream& out, uint64_t nanos) {
+            char fraction[4];
+            fraction[0] = static_cast<char>('0' + (nanos / 100) % 10);
+            fraction[1] = static_cast<char>('0' + (nanos / 10) % 10);
+            fraction[2] = static_cast<char>('0' + nanos % 10);
+            fraction[3] = '\0';
+            out << nanos / 1000 << "." << fraction;
+        }
+
+        void writeJsonString(std::ostream& out, const char* text) {
+            out << '\"';
+            for (const char* c = text; *c; ++c) {
+                if (*c == '\"' || *c == '\\') out << '\\';
+                out << *c;
+            }
+            out << '\"';
+        }
+    }
+
+    namespace detail {
+        uint64_t nowNanos() {
+            auto elapsed = std::chrono::steady_clock::now() - epoch;
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        void recordSpan(const char* name, uint64_t startNanos, uint64_t endNanos) {
+            ThreadBuffer& buffer = bufferForThisThread();
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            buffer.events[buffer.written % RingCapacity] = Event{ name, startNanos, endNanos };
+            buffer.written++;
+        }
+    }
+
+    void nameThread(const char* name) {
+        localName = name;
+        if (localBuffer) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            localBuffer->name = name;
+        }
+    }
+
+    void start(const std::string& outputFile) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        outputPath = outputFile;
+        detail::enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void flush() {
+        detail::enabled.store(false, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (outputPath.empty()) return;
+
+        std::ofstream out(outputPath);
+        if (!out.is_open()) {
+            throw FileWriteException(outputPath);
+        }
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        std::vector<Event> events;
+        for (const auto& buffer : buffers) {
+            // Copied out so the thread can carry on while they are written.
+            events.clear();
+            {
+                std::lock_guard<std::mutex> copying(buffer->mutex);
+                uint64_t oldest = buffer->written > RingCapacity ? buffer->written - RingCapacity : 0;
+                for (uint64_t i = oldest; i < buffer->written; i++) {
+                    events.push_back(buffer->events[i % RingCapacity]);
+                }
+                buffer->written = 0;
+            }
+
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+            if (buffer->name) {
+                writeJsonString(out, buffer->name);
+            }
+            else {
+                out << "\"thread " << buffer->tid << "\"";
+            }
+            out << "}}";
+
+            for (const Event& event : events) {
+                out << ",\n{\"name\":";
+                writeJsonString(out, event.name);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":";
+                writeMicros(out, event.startNanos);
+                out << ",\"dur\":";
+                writeMicros(out, event.endNanos - event.startNanos);
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+        outputPath.clear();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+namespace trace {
+    namespace detail {
+        extern std::atomic<bool> enabled;
+        uint64_t nowNanos();
+        void recordSpan(const char* name, uint64_t startNanos, uint64_t endNanos);
+    }
+
+    inline bool isEnabled() {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    // Starts recording spans. They are kept in a fixed-size ring buffer per
+    // thread (oldest spans are overwritten) until flush() writes them out.
+    void start(const std::string& outputFile);
+
+    // Writes every recorded span to the output file as Chrome/Perfetto
+    // trace-event JSON and stops recording. Other threads may still be
+    // recording; spans they finish during the flush are left out. Throws
+    // FileWriteException if the file cannot be written.
+    void flush();
+
+    // Labels the calling thread's spans in the trace; threads without a
+    // name are shown by number. name must be a string literal.
+    void nameThread(const char* name);
+
+    // Records the lifetime of the enclosing scope as a span. name must be a
+    // string literal (only the pointer is stored). When tracing is off this
+    // costs one relaxed load and a branch.
+    class Span {
+    public:
+        explicit Span(const char* name)
+            : name(isEnabled() ? name : nullptr), start(this->name ? detail::nowNanos() : 0) {}
+        ~Span() {
+            if (name) {
+                detail::recordSpan(name, start, detail::nowNanos());
+            }
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* name;
+        uint64_t start;
+    };
+}
\ No newline at end of file
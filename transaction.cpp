@@ -0,0 +1,62 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "transaction.h"
+#include "calendar.h"
+#include <utility>
+
+void Transaction::registerOwner(const Owner& owner) {
+    stage(Mutation{ Mutation::Type::RegisterOwner,
+        { owner.name, std::to_string(owner.age), owner.address, owner.phone, owner.email, owner.password,
+          owner.registered.empty() ? calendar::civilFromDays(calendar::today()) : owner.registered } });
+}
+
+void Transaction::updateOwnerContact(const std::string& name, const std::string& address,
+    const std::string& phone, const std::string& email) {
+    stage(Mutation{ Mutation::Type::UpdateOwner, { name, address, phone, email } });
+}
+
+void Transaction::deleteOwner(const std::string& name) {
+    stage(Mutation{ Mutation::Type::DeleteOwner, { name } });
+}
+
+void Transaction::addPet(const std::string& ownerName, const Pet& pet) {
+    stage(Mutation{ Mutation::Type::AddPet,
+        { ownerName, pet.name, pet.breed, std::to_string(pet.age), pet.medicalHistory.str(), pet.vaccinated ? "1" : "0" } });
+}
+
+void Transaction::updatePet(const std::string& ownerName, const std::string& petName,
+    const std::string& medicalHistory, bool vaccinated) {
+    stage(Mutation{ Mutation::Type::UpdatePet, { ownerName, petName, medicalHistory, vaccinated ? "1" : "0" } });
+}
+
+void Transaction::deletePet(const std::string& ownerName, const std::string& petName) {
+    stage(Mutation{ Mutation::Type::DeletePet, { ownerName, petName } });
+}
+
+void Transaction::addMedicalNote(const std::string& ownerName, const std::string& petName, const std::string& note) {
+    stage(Mutation{ Mutation::Type::AddNote, { ownerName, petName, "[" + calendar::civilFromDays(calendar::today()) + "] " + note } });
+}
+
+void Transaction::replaceMedicalHistory(const std::string& ownerName, const std::string& petName,
+    const std::string& medicalHistory) {
+    stage(Mutation{ Mutation::Type::SetHistory, { ownerName, petName, medicalHistory } });
+}
+
+void Transaction::scheduleAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) {
+    stage(Mutation{ Mutation::Type::Schedule, { ownerName, petName, date, time } });
+}
+
+void Transaction::updateAppointmentStatus(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time, const std::string& newStatus) {
+    stage(Mutation{ Mutation::Type::SetStatus, { ownerName, petName, date, time, newStatus } });
+}
+
+void Transaction::cancelAppointment(const std::string& ownerName, const std::string& petName,
+    const std::string& date, const std::string& time) {
+    stage(Mutation{ Mutation::Type::Cancel, { ownerName, petName, date, time } });
+}
+
+void Transaction::stage(Mutation mutation) {
+    staged.push_back(std::move(mutation));
+}
\ No newline at end of file
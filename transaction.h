@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "mutation.h"
+#include "owner.h"
+#include "pet.h"
+
+// A group of changes that VMS::commit applies as a unit: either every
+// staged mutation takes effect and is written to the journal as a single
+// record, or none of them do. Staging only records the change; owners,
+// pets and appointments are looked up and validated at commit time.
+class Transaction {
+public:
+    // owner.password must already be a hash (security::hashPassword). An
+    // empty owner.registered is stamped with today's date.
+    void registerOwner(const Owner& owner);
+    void updateOwnerContact(const std::string& name, const std::string& address,
+        const std::string& phone, const std::string& email);
+    void deleteOwner(const std::string& name);
+    void addPet(const std::string& ownerName, const Pet& pet);
+    void updatePet(const std::string& ownerName, const std::string& petName,
+        const std::string& medicalHistory, bool vaccinated);
+    void deletePet(const std::string& ownerName, const std::string& petName);
+    // The note is stamped with today's date when it is staged.
+    void addMedicalNote(const std::string& ownerName, const std::string& petName, const std::string& note);
+    void replaceMedicalHistory(const std::string& ownerName, const std::string& petName,
+        const std::string& medicalHistory);
+    void scheduleAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time);
+    void updateAppointmentStatus(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time, const std::string& newStatus);
+    void cancelAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time);
+
+    void stage(Mutation mutation);
+
+    const std::vector<Mutation>& mutations() const { return staged; }
+    size_t size() const { return staged.size(); }
+    bool empty() const { return staged.empty(); }
+    void clear() { staged.clear(); }
+
+private:
+    std::vector<Mutation> staged;
+};
+
+// A staged mutation rejected by VMS::commitValid; index is its position
+// in Transaction::mutations().
+struct CommitFailure {
+    size_t index;
+    std::string message;
+};
\ No newline at end of file
@@ -1,66 +1,333 @@
-#pragma once
-#include <vector>
-#include <string>
-#include <functional>
-#include "owner.h"
-#include "pet.h"
-#include "appointment.h"
-
-class VMS {
-private:
-    std::vector<Owner> owners;
-    std::vector<Appointment> appointments;
-
-    template<typename T>
-    T getValidInput(const std::string& prompt, std::function<bool(const T&)> validator);
-
-    std::string getValidStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator);
-
-    bool isValidName(const std::string& name) const;
-    bool isValidAddress(const std::string& address) const;
-    bool isValidEmail(const std::string& email) const;
-    bool isValidPhone(const std::string& phone) const;
-    bool isValidDate(const std::string& date) const;
-    bool isValidTime(const std::string& time) const;
-    bool isValidPassword(const std::string& password) const;
-
-    void updateAllAppointmentStatuses();
-    int displayRoleMenu(const std::string& title, const std::vector<std::string>& options, int maxOptions);
-    bool isDateTimeInFuture(const std::string& date, const std::string& time) const;
-    bool hasTimeConflict(const std::string& date, const std::string& time) const;
-    bool isDuplicateAppointment(const std::string& ownerName, const std::string& petName,
-        const std::string& date, const std::string& time) const;
-    bool isValidStatusTransition(const std::string& currentStatus, const std::string& newStatus);
-    bool isVaccinationStatusAppropriate(int petAge, bool isVaccinated);
-
-public:
-    void addOwner(const Owner& owner);
-    const std::vector<Owner>& getOwners() const;
-
-    bool validateCustomerLogin(const std::string& name, const std::string& password) const;
-
-    bool validateName(const std::string& name) const;
-    bool validateAddress(const std::string& address) const;
-    bool validateEmail(const std::string& email) const;
-    bool validatePhone(const std::string& phone) const;
-    bool validateDate(const std::string& date) const;
-    bool validateTime(const std::string& time) const;
-    bool validatePassword(const std::string& password) const;
-
-    std::string getValidatedStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator);
-
-    template<typename T>
-    T getValidatedInput(const std::string& prompt, std::function<bool(const T&)> validator);
-
-    void viewPetAppointmentHistory();
-    void viewPetMedicalHistory(const std::string& role);
-
-    void displayCustomerMenu(const std::string& customerName);
-    void displayPetsMenu(const std::string& role);
-    void displayAppointmentMenu(const std::string& role);
-    void displayOwnersMenu(const std::string& role);
-    void displayMenu(const std::string& role);
-
-    void saveData();
-    void loadData();
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
+#include <future>
+#include <unordered_map>
+#include <utility>
+#include "owner.h"
+#include "pet.h"
+#include "appointment.h"
+#include "memory_report.h"
+#include "credential_store.h"
+#include "snapshot.h"
+#include "striped_locks.h"
+#include "mutation.h"
+#include "transaction.h"
+#include "journal.h"
+#include "change_feed.h"
+#include "archive.h"
+#include "analytics.h"
+#include "bloom_filter.h"
+#include "reminders.h"
+
+class VMS {
+private:
+    // Deleting an owner or appointment only marks its slot (Owner::deleted,
+    // Appointment::deleted) and drops it from the indexes below, so slots
+    // never move between compactions (see compact).
+    std::vector<Owner> owners;
+    std::vector<Appointment> appointments;
+    size_t deletedOwners = 0, deletedAppointments = 0;
+    CredentialStore credentials;
+
+    // Last published version, read and replaced with std::atomic_load/store.
+    std::shared_ptr<const Snapshot> published;
+    std::atomic<bool> ownersChanged{ true };
+    std::atomic<bool> appointmentsChanged{ true };
+
+    // Concurrency control for the public operations; see striped_locks.h
+    // for the order in which these may be acquired.
+    std::mutex saveMutex;
+    mutable std::shared_timed_mutex structureMutex;
+    StripedLocks ownerLocks;
+    StripedLocks dayLocks;
+    std::shared_timed_mutex storageMutex;
+
+    // Calendar index: date -> positions in appointments. Guarded like the
+    // appointments themselves (day stripe + storageMutex).
+    std::unordered_map<std::string, std::vector<size_t>> appointmentsByDay;
+    // Owner name -> slot in owners (the first owner with the name), and
+    // each owner slot's appointment positions. ownerSlots changes only
+    // under structureMutex; ownerAppointments is guarded like
+    // appointmentsByDay. Positions are kept in ascending order.
+    std::unordered_map<std::string, size_t> ownerSlots;
+    std::vector<std::vector<size_t>> ownerAppointments;
+    bool duplicateOwnerNames = false;
+    // Owner names and owner/pet pairs, published with each snapshot for
+    // Snapshot::findOwner/findPet. Names are added as they appear and
+    // never taken out; staleFilterKeys counts those deleted since, and
+    // rebuildNameFilter starts afresh once they are a quarter of the
+    // filter. The pointer is replaced only under structureMutex held
+    // exclusively.
+    std::shared_ptr<BloomFilter> nameFilter;
+    std::atomic<size_t> staleFilterKeys{ 0 };
+
+    // Committed transactions since the last checkpoint.
+    Journal journal{ "vms.journal" };
+    // Every committed mutation as an event for other processes.
+    ChangeFeed feed{ "vms.feed", "vms.replica.feed" };
+    std::mutex feedOrderMutex;
+
+    // Finished appointments older than archiveAfterDays (0 = never) are
+    // moved here at each saveData.
+    AppointmentArchive archive;
+    int archiveAfterDays = 0;
+
+    // Set while this process follows a primary (see replica.h): status
+    // changes then only arrive as the primary's commits.
+    bool following = false;
+
+    // Counters behind the Reports menu, updated by every operation below.
+    Analytics analytics;
+
+    // Fed with every commit once startReminders has been called.
+    ReminderScheduler reminders{ "vms.outbox" };
+
+    // Journal size that triggers a background checkpoint; bounds the
+    // replay work at startup. The same thread compacts the tables once
+    // enough slots are tombstoned, so no commit waits for it.
+    static const long CheckpointJournalBytes = 4L << 20;
+    std::thread checkpointThread;
+    std::mutex checkpointMutex;
+    std::condition_variable checkpointWake;
+    bool checkpointRequested = false;
+    bool compactionRequested = false;
+    bool stopping = false;
+
+    // Background startup (see startLoading). credentialsLoaded is fulfilled
+    // once logins can be checked, dataLoaded when loadData has finished;
+    // the futures stay invalid when loadData is called directly.
+    std::promise<void> credentialsLoaded, dataLoaded;
+    std::shared_future<void> credentialsReady, dataReady;
+    bool credentialsSignalled = false;  // loading thread only
+    std::thread loaderThread;
+    // Journal sequence the recovered checkpoint contains.
+    uint64_t checkpointed = 0;
+    bool recovered = false;
+
+    // What a transaction has done so far: the inverse changes, which
+    // rollback runs in reverse, and the slots it wrote, which
+    // publishSnapshot copies into the next version.
+    struct UndoLog {
+        std::vector<std::function<void()>> steps;
+        std::vector<size_t> ownerSlots, appointmentSlots;
+    };
+
+    template<typename T>
+    T getValidInput(const std::string& prompt, std::function<bool(const T&)> validator);
+
+    std::string getValidStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator);
+
+    bool isValidName(const std::string& name) const;
+    bool isValidAddress(const std::string& address) const;
+    bool isValidEmail(const std::string& email) const;
+    bool isValidPhone(const std::string& phone) const;
+    bool isValidDate(const std::string& date) const;
+    bool isValidTime(const std::string& time) const;
+    bool isValidPassword(const std::string& password) const;
+
+    // Commits Scheduled -> Completed for every appointment now in the
+    // past as SetStatus mutations, so the journal, the feed and any
+    // follower see the change like any other. Takes the locks itself and
+    // does nothing while following a primary.
+    void updateAllAppointmentStatuses();
+    // Stages those changes, and completes appointments left without a pet
+    // in place (returning whether there were any); needs structureMutex
+    // held exclusively.
+    bool stageCompletedAppointments(Transaction& tx);
+    // Publishes the current state as the next version, copying the tables
+    // flagged by ownersChanged/appointmentsChanged whole. Needs
+    // structureMutex exclusively.
+    void publishSnapshot();
+    // Publishes a committed transaction: the previous version with only
+    // the chunks holding the slots in changes copied afresh. Needs
+    // structureMutex (shared will do), the transaction's stripes and
+    // feedOrderMutex, so versions follow journal order.
+    void publishSnapshot(const UndoLog& changes, uint64_t journalSequence);
+    void installSnapshot(std::shared_ptr<const Snapshot::Owners> nextOwners,
+        std::shared_ptr<const Snapshot::Appointments> nextAppointments, uint64_t journalSequence);
+    // Record in undo that the transaction wrote this slot. Without one
+    // (replay, rollback) nothing is needed: loadData publishes everything
+    // and a rollback restores what was already published.
+    void touchOwner(const Owner& owner, UndoLog* undo);
+    void touchAppointment(const Appointment& appt, UndoLog* undo);
+    void rebuildIndexes();
+    // Adds or removes the appointment in slot in the indexes above.
+    void indexAppointment(size_t slot);
+    void unindexAppointment(size_t slot);
+    // Set or clear the tombstone on a slot, keeping the indexes and the
+    // analytics counters in step.
+    void setOwnerDeleted(size_t slot, bool deleted);
+    void setAppointmentDeleted(size_t slot, bool deleted);
+    // Removes the tombstoned slots and renumbers the indexes. Without
+    // force, only when compactionDue. Needs structureMutex exclusively.
+    // Returns whether it compacted, in which case slots have moved and
+    // publishSnapshot() must publish before the next commit.
+    bool compact(bool force);
+    // Whether tombstones make up a quarter of either table, so the cost of
+    // compacting is spread over the deletes that caused it. Needs
+    // structureMutex and storageMutex, shared or not.
+    bool compactionDue() const;
+    // Without force, only when the filter is full or too stale (see
+    // nameFilter). Needs structureMutex exclusively.
+    void rebuildNameFilter(bool force);
+    void addNames(const Owner& owner);
+    void archiveOldAppointments();
+    // Adds the archived appointments to counters after a rebuild.
+    void countArchived(Analytics& counters) const;
+    // Prints a pet's appointments from view and the archive, oldest first.
+    void printAppointmentHistory(const Snapshot& view, const std::string& ownerName,
+        const std::string& petName) const;
+    // Writes the latest snapshot as a checkpoint and compacts the journal.
+    void writeCheckpoint();
+    void requestCheckpoint();
+    // compact(false) on the checkpoint thread.
+    void requestCompaction();
+    void requestBackgroundWork(bool& requested);
+    void checkpointLoop();
+    // Runs checkpoint::recover once. Throws OperationFailedException if no
+    // checkpoint is intact.
+    void recoverCheckpoint();
+    // Fills the credential store from owners.csv and the registrations and
+    // deletions journaled since the checkpoint, then releases the logins.
+    void loadCredentials(uint64_t checkpointed);
+    void signalCredentials();
+    int displayRoleMenu(const std::string& title, const std::vector<std::string>& options, int maxOptions);
+    bool isDateTimeInFuture(const std::string& date, const std::string& time) const;
+    bool hasTimeConflict(const std::string& date, const std::string& time) const;
+    bool isDuplicateAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time) const;
+    bool isValidStatusTransition(const std::string& currentStatus, const std::string& newStatus);
+    bool isVaccinationStatusAppropriate(int petAge, bool isVaccinated);
+
+    Owner* findOwner(const std::string& ownerName);
+    Pet* findPet(Owner& owner, const std::string& petName);
+    Appointment* findAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time);
+
+    std::vector<CommitFailure> commitStaged(Transaction& tx, bool skipRejected);
+    void rollback(UndoLog& undo);
+    // replaying skips the checks that depend on the current time.
+    void applyMutation(const Mutation& mutation, UndoLog* undo, bool replaying);
+    void recordStatusUndo(const Appointment& appt, UndoLog& undo);
+    // Tombstones ownerSlot's appointments (only petName's if given) and
+    // returns their positions.
+    std::vector<size_t> deleteAppointments(size_t ownerSlot, const std::string* petName, UndoLog* undo);
+
+    // The operations behind each Mutation::Type. They throw
+    // OperationFailedException when the change is rejected and expect the
+    // caller (commitStaged or loadData) to hold the necessary locks.
+    void registerOwner(Owner owner, UndoLog* undo);
+    void updateOwnerContact(const std::string& name, const std::string& address,
+        const std::string& phone, const std::string& email, UndoLog* undo);
+    void deleteOwner(const std::string& name, UndoLog* undo);
+    void addPet(const std::string& ownerName, Pet pet, UndoLog* undo);
+    void updatePet(const std::string& ownerName, const std::string& petName,
+        const LazyText& medicalHistory, bool vaccinated, UndoLog* undo);
+    void deletePet(const std::string& ownerName, const std::string& petName, UndoLog* undo);
+    void addMedicalNote(const std::string& ownerName, const std::string& petName,
+        const std::string& entry, UndoLog* undo);
+    void replaceMedicalHistory(const std::string& ownerName, const std::string& petName,
+        const LazyText& medicalHistory, UndoLog* undo);
+    void scheduleAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time, UndoLog* undo, bool replaying);
+    void updateAppointmentStatus(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time, const std::string& newStatus,
+        UndoLog* undo, bool replaying);
+    void cancelAppointment(const std::string& ownerName, const std::string& petName,
+        const std::string& date, const std::string& time, UndoLog* undo);
+
+public:
+    VMS() = default;
+    ~VMS();
+    VMS(const VMS&) = delete;
+    VMS& operator=(const VMS&) = delete;
+
+    memory::Report measureMemory() const;
+
+    // Sets how many days after its date a completed or cancelled
+    // appointment is archived; 0 keeps everything in appointments.csv.
+    void setArchiveHorizon(int days);
+    // Follower mode leaves the automatic status sweep to the primary;
+    // cleared again on promotion.
+    void setFollowing(bool follow);
+
+    // Pins the most recently committed version for read-only use.
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    bool validateCustomerLogin(const std::string& name, const std::string& password) const;
+    bool authenticateStaff(const std::string& role, const std::string& password);
+    bool customerExists(const std::string& name) const;
+
+    bool validateName(const std::string& name) const;
+    bool validateAddress(const std::string& address) const;
+    bool validateEmail(const std::string& email) const;
+    bool validatePhone(const std::string& phone) const;
+    bool validateDate(const std::string& date) const;
+    bool validateTime(const std::string& time) const;
+    bool validatePassword(const std::string& password) const;
+
+    std::string getValidatedStringInput(const std::string& prompt, std::function<bool(const std::string&)> validator);
+
+    template<typename T>
+    T getValidatedInput(const std::string& prompt, std::function<bool(const T&)> validator);
+
+    // Applies every mutation staged in tx and writes them to the journal
+    // as one synced record, then clears tx. If a mutation is rejected the
+    // ones already applied are rolled back and OperationFailedException is
+    // thrown; a journal failure rolls back and throws FileWriteException.
+    void commit(Transaction& tx);
+    // Like commit, but rejected mutations are skipped and returned instead
+    // of aborting the transaction. Used by batch mode.
+    std::vector<CommitFailure> commitValid(Transaction& tx);
+
+    // Follower mode (see replica.h): applies one commit taken from the
+    // primary's change feed and journals it under the primary's sequence
+    // number. Mutations the local state rejects are reported and skipped.
+    // Throws FileWriteException if the journal cannot be written.
+    void applyReplicated(uint64_t journalSequence, const std::vector<Mutation>& mutations);
+    // Journal sequence of the last commit, i.e. where a follower resumes.
+    uint64_t lastCommittedSequence() const;
+
+    void viewPetAppointmentHistory();
+    void viewPetMedicalHistory(const std::string& role);
+
+    void displayCustomerMenu(const std::string& customerName);
+    void displayPetsMenu(const std::string& role);
+    void displayAppointmentMenu(const std::string& role);
+    void displayOwnersMenu(const std::string& role);
+    void displayStatisticsMenu();
+    void displayReportsMenu();
+    void displayMenu(const std::string& role);
+
+    // Checkpoint: rewrites the CSV files from the current state (see
+    // checkpoint.h) and drops the journal records they now contain.
+    void saveData();
+    // Finishes any interrupted checkpoint (or falls back to the previous
+    // one), loads the CSV files and replays the journal records committed
+    // after them. Throws OperationFailedException if no checkpoint is
+    // intact.
+    void loadData();
+    // Checks the checkpoint (throwing as loadData does), then runs prepare
+    // (e.g. creating missing role files) and the rest of loadData on a
+    // background thread, and returns at once. Logins only wait for the
+    // credentials, which are read first; commit, saveData and the menus
+    // wait for all the data.
+    void startLoading(std::function<void()> prepare);
+    // Block until that stage of a background load is done; return at once
+    // if startLoading was not used.
+    void waitForCredentials() const;
+    void waitForData() const;
+
+    // Starts sending appointment reminders (see reminders.h) as soon as the
+    // data has loaded, without waiting for it. Only a primary should: a
+    // follower would send them a second time.
+    void startReminders();
 };
\ No newline at end of file